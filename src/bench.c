@@ -0,0 +1,679 @@
+
+// headless benchmark -> fixed scenes rendered offscreen for a fixed number of frames, results as json
+// usage: bench [frames] [output.json] (defaults: 1000 frames, json on stdout)
+// runs on any vulkan 1.0 driver including software ones (lavapipe/swiftshader), build with -DHG_NO_GLFW
+
+#include "vkHomeGrown.h"
+#include "hg_math.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define BENCH_WIDTH          1280
+#define BENCH_HEIGHT         720
+#define BENCH_DEFAULT_FRAMES 1000
+#define BENCH_CUBE_GRID      100  // 100 x 100 cubes -> 10000 draws per frame (one in the instanced variant)
+#define BENCH_STREAM_SIZE    512  // streamed texture edge length (RGBA8 -> 1 MiB per upload)
+#define BENCH_STREAM_COUNT   (HG_MAX_FRAMES_IN_FLIGHT + 1) // textures cycled so an upload never hits one a frame in flight samples
+
+// how the cube grid is submitted
+typedef enum _hgBenchCubeMode
+{
+    BENCH_CUBES_DRAWS,     // one draw per cube, model matrix pushed
+    BENCH_CUBES_INSTANCED, // one instanced draw, matrices in an instance stream
+    BENCH_CUBES_INDIRECT,  // one indirect command per cube (one multi draw indirect call), matrices in an instance stream
+    BENCH_CUBES_QUEUE      // one draw packet per cube, sorted near to far by the render queue before recording
+} hgBenchCubeMode;
+
+typedef struct _hgBenchResult
+{
+    const char* pcName;
+    uint32_t    uFrames;
+    double      dElapsedSec;
+    float       fMeanMs;
+    float       fP50Ms;
+    float       fP90Ms;
+    float       fP99Ms;
+    float       fMaxMs;
+    float       fGpuFrameMs;   // rolling average of the "frame" gpu scope, 0 when timestamps are unavailable
+    uint64_t    uDraws;
+    double      dDrawsPerSec;
+    uint64_t    uUploadBytes;
+    double      dUploadMBps;
+    float       fPipelineMs;   // hg_create_graphics_pipelines for the scene's pipelines
+    hgBindStats tBindStats;    // last frame of the scene
+} hgBenchResult;
+
+// shared by every scene
+typedef struct _hgBenchContext
+{
+    hgAppData             tState;
+    VkDescriptorSetLayout tTextureSetLayout;
+    VkDescriptorSetLayout tCameraSetLayout;
+    VkSampler             tSampler;
+    uint32_t              uFrames;
+    float*                afFrameMs;
+} hgBenchContext;
+
+double
+bench_time_ms(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER tFrequency = {0};
+    if(tFrequency.QuadPart == 0) QueryPerformanceFrequency(&tFrequency);
+
+    LARGE_INTEGER tCounter;
+    QueryPerformanceCounter(&tCounter);
+    return (double)tCounter.QuadPart * 1000.0 / (double)tFrequency.QuadPart;
+#else
+    struct timespec tTime;
+    clock_gettime(CLOCK_MONOTONIC, &tTime);
+    return (double)tTime.tv_sec * 1000.0 + (double)tTime.tv_nsec / 1000000.0;
+#endif
+}
+
+int
+bench_compare_float(const void* pA, const void* pB)
+{
+    float fA = *(const float*)pA;
+    float fB = *(const float*)pB;
+    return (fA > fB) - (fA < fB);
+}
+
+// frame times are measured from one hg_begin_frame to the next, so they include waiting on the gpu
+void
+bench_finish_scene(hgBenchContext* ptBench, hgBenchResult* ptResult, double dStartMs)
+{
+    vkDeviceWaitIdle(ptBench->tState.tContextComponents.tDevice);
+    ptResult->dElapsedSec = (bench_time_ms() - dStartMs) / 1000.0;
+    ptResult->uFrames     = ptBench->uFrames;
+
+    float* afSorted = malloc(ptBench->uFrames * sizeof(float));
+    memcpy(afSorted, ptBench->afFrameMs, ptBench->uFrames * sizeof(float));
+    qsort(afSorted, ptBench->uFrames, sizeof(float), bench_compare_float);
+
+    double dSum = 0.0;
+    for(uint32_t i = 0; i < ptBench->uFrames; i++) dSum += afSorted[i];
+    ptResult->fMeanMs = (float)(dSum / ptBench->uFrames);
+    ptResult->fP50Ms  = afSorted[(ptBench->uFrames - 1) * 50 / 100];
+    ptResult->fP90Ms  = afSorted[(ptBench->uFrames - 1) * 90 / 100];
+    ptResult->fP99Ms  = afSorted[(ptBench->uFrames - 1) * 99 / 100];
+    ptResult->fMaxMs  = afSorted[ptBench->uFrames - 1];
+    free(afSorted);
+
+    ptResult->dDrawsPerSec = ptResult->dElapsedSec > 0.0 ? (double)ptResult->uDraws / ptResult->dElapsedSec : 0.0;
+    hg_get_bind_stats(&ptBench->tState, &ptResult->tBindStats);
+    ptResult->dUploadMBps  = ptResult->dElapsedSec > 0.0 ? (double)ptResult->uUploadBytes / (1024.0 * 1024.0) / ptResult->dElapsedSec : 0.0;
+
+    hgGpuFrameProfile tProfile;
+    if(hg_get_gpu_frame_profile(&ptBench->tState, &tProfile) && tProfile.uScopeCount > 0)
+    {
+        ptResult->fGpuFrameMs = tProfile.atScopes[0].fAverageMs;
+    }
+}
+
+// checkerboard that moves with the frame number, stands in for video/streamed texture data
+void
+bench_fill_texture(unsigned char* pucPixels, uint32_t uSize, uint32_t uFrame)
+{
+    for(uint32_t y = 0; y < uSize; y++)
+    {
+        for(uint32_t x = 0; x < uSize; x++)
+        {
+            unsigned char* pucPixel = &pucPixels[(y * uSize + x) * 4];
+            bool           bOdd     = (((x + uFrame) / 32) + (y / 32)) & 1;
+            pucPixel[0] = bOdd ? 255 : (unsigned char)x;
+            pucPixel[1] = bOdd ? 255 : (unsigned char)y;
+            pucPixel[2] = (unsigned char)uFrame;
+            pucPixel[3] = 255;
+        }
+    }
+}
+
+VkDescriptorSet
+bench_allocate_set(hgBenchContext* ptBench, VkDescriptorPool tPool, VkDescriptorSetLayout tLayout)
+{
+    VkDescriptorSet tSet = VK_NULL_HANDLE;
+    const VkDescriptorSetAllocateInfo tAllocInfo = {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = tPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &tLayout
+    };
+    VULKAN_CHECK(vkAllocateDescriptorSets(ptBench->tState.tContextComponents.tDevice, &tAllocInfo, &tSet));
+    return tSet;
+}
+
+// -------------------------------
+// textured quad (main.c)
+// -------------------------------
+void
+bench_scene_quad(hgBenchContext* ptBench, hgBenchResult* ptResult)
+{
+    hgAppData* ptState = &ptBench->tState;
+    ptResult->pcName   = "textured_quad";
+
+    float afQuadVertices[] = {
+        // x, y,      r, g, b, a,             u, v
+        -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+         0.5f,  0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+         0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f
+    };
+    uint16_t auQuadIndices[6] = {0, 1, 2, 2, 3, 0};
+    hgIndexBuffer tIndexBuffer = hg_create_index_buffer(ptState, auQuadIndices, 6);
+
+    // cobble texture when the repo layout is there, generated data otherwise
+    int            iWidth   = 0;
+    int            iHeight  = 0;
+    unsigned char* pucImage = hg_load_texture_data("../textures/cobble.png", &iWidth, &iHeight);
+    if(!pucImage)
+    {
+        iWidth = iHeight = 256;
+        pucImage = malloc(256 * 256 * 4);
+        bench_fill_texture(pucImage, 256, 0);
+    }
+    hgTexture tTexture = hg_create_texture(ptState, pucImage, iWidth, iHeight);
+    free(pucImage); // stbi_load allocates with plain malloc
+
+    VkDescriptorPoolSize tPoolSize = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1};
+    VkDescriptorPool     tPool     = hg_create_descriptor_pool(ptState, 1, &tPoolSize, 1);
+    VkDescriptorSet      tSet      = bench_allocate_set(ptBench, tPool, ptBench->tTextureSetLayout);
+    hg_update_texture_descriptor(ptState, tSet, 0, &tTexture, ptBench->tSampler);
+
+    VkVertexInputAttributeDescription atAttribs[3] = {
+        {.location = 0, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT,       .offset = 0},
+        {.location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = sizeof(float) * 2},
+        {.location = 2, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT,       .offset = sizeof(float) * 6}
+    };
+    hgPipelineConfig tConfig = {
+        .pcVertexShaderPath        = "../out/shaders/textured_vert.spv",
+        .pcFragmentShaderPath      = "../out/shaders/textured_frag.spv",
+        .uVertexStride             = sizeof(float) * 8,
+        .ptAttributeDescriptions   = atAttribs,
+        .uAttributeCount           = 3,
+        .tCullMode                 = VK_CULL_MODE_BACK_BIT,
+        .tFrontFace                = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .ptDescriptorSetLayouts    = &ptBench->tTextureSetLayout,
+        .uDescriptorSetLayoutCount = 1,
+        .tPipelineBindPoint        = VK_PIPELINE_BIND_POINT_GRAPHICS
+    };
+    hgPipeline tPipeline;
+    double dPipelineStart = bench_time_ms();
+    hg_create_graphics_pipelines(ptState, &tConfig, 1, &tPipeline);
+    ptResult->fPipelineMs = (float)(bench_time_ms() - dPipelineStart);
+
+    double dStartMs = bench_time_ms();
+    double dFrameMs = dStartMs;
+    for(uint32_t uFrame = 0; uFrame < ptBench->uFrames; uFrame++)
+    {
+        // same circular motion as main.c, vertices rewritten into transient memory every frame
+        float fAngle = (float)uFrame * 0.01f;
+        hgTransientAllocation tVertices = hg_alloc_transient(ptState, sizeof(afQuadVertices));
+        float* afVertices = tVertices.pData;
+        memcpy(afVertices, afQuadVertices, sizeof(afQuadVertices));
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            afVertices[i * 8]     += 0.2f * cosf(fAngle);
+            afVertices[i * 8 + 1] += 0.2f * sinf(fAngle);
+        }
+
+        uint32_t uImageIndex = hg_begin_frame(ptState);
+        hg_begin_render_pass(ptState, uImageIndex);
+
+        hg_cmd_bind_pipeline(ptState, &tPipeline);
+        hg_cmd_bind_descriptor_sets(ptState, &tPipeline, 0, &tSet, 1, NULL, 0);
+        hg_cmd_bind_transient_vertex_buffer(ptState, &tVertices);
+        hg_cmd_bind_index_buffer(ptState, &tIndexBuffer);
+        hg_cmd_draw_indexed(ptState, tIndexBuffer.uIndexCount, 0, 0);
+        ptResult->uDraws++;
+
+        hg_end_render_pass(ptState);
+        hg_end_frame(ptState, uImageIndex);
+
+        double dNowMs = bench_time_ms();
+        ptBench->afFrameMs[uFrame] = (float)(dNowMs - dFrameMs);
+        dFrameMs = dNowMs;
+    }
+    bench_finish_scene(ptBench, ptResult, dStartMs);
+
+    hg_destroy_pipeline(ptState, &tPipeline);
+    vkDestroyDescriptorPool(ptState->tContextComponents.tDevice, tPool, NULL);
+    hg_destroy_texture(ptState, &tTexture);
+    hg_destroy_index_buffer(ptState, &tIndexBuffer);
+}
+
+// -------------------------------
+// cube grid (cube.c)
+// -------------------------------
+void
+bench_scene_cubes(hgBenchContext* ptBench, hgBenchResult* ptResult, hgBenchCubeMode tMode)
+{
+    static const char* apcNames[] = {"cube_grid", "cube_grid_instanced", "cube_grid_indirect", "cube_grid_queue"};
+    hgAppData* ptState    = &ptBench->tState;
+    bool       bInstanced = tMode == BENCH_CUBES_INSTANCED || tMode == BENCH_CUBES_INDIRECT; // instance stream + cube_instanced shader
+    ptResult->pcName      = apcNames[tMode];
+
+    hgVertex atCubeVertices[8] = {
+        {-0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f},
+        { 0.5f, -0.5f,  0.5f,  0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f},
+        { 0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f},
+        {-0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f},
+        {-0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f},
+        { 0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},
+        { 0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f},
+        {-0.5f,  0.5f, -0.5f,  0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f},
+    };
+    uint16_t auCubeIndices[36] = {
+        0, 1, 2,  2, 3, 0,   5, 4, 7,  7, 6, 5,   4, 0, 3,  3, 7, 4,
+        1, 5, 6,  6, 2, 1,   4, 5, 1,  1, 0, 4,   3, 2, 6,  6, 7, 3
+    };
+
+    hg_begin_upload_batch(ptState);
+    hgVertexBuffer tVertexBuffer = hg_create_static_vertex_buffer(ptState, atCubeVertices, sizeof(atCubeVertices), sizeof(hgVertex));
+    hgIndexBuffer  tIndexBuffer  = hg_create_index_buffer(ptState, auCubeIndices, 36);
+    hg_wait_for_upload(ptState, hg_submit_upload_batch(ptState));
+
+    hgUniformBuffer      tCamera   = hg_create_dynamic_uniform_buffer(ptState, sizeof(CameraBufferObject), 1);
+    VkDescriptorPoolSize tPoolSize = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1};
+    VkDescriptorPool     tPool     = hg_create_descriptor_pool(ptState, 1, &tPoolSize, 1);
+    VkDescriptorSet      tSet      = bench_allocate_set(ptBench, tPool, ptBench->tCameraSetLayout);
+    hg_update_uniform_descriptor(ptState, tSet, 0, &tCamera);
+
+    VkVertexInputAttributeDescription atAttribs[2 + HG_INSTANCE_ATTRIBUTE_COUNT] = {
+        {.location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT,    .offset = 0},
+        {.location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = sizeof(float) * 3}
+    };
+    uint32_t uAttributeCount = 2;
+    if(bInstanced) uAttributeCount += hg_get_instance_attributes(1, 2, &atAttribs[2]);
+    VkVertexInputBindingDescription atBindings[2] = {
+        {.binding = 0, .stride = sizeof(hgVertex),       .inputRate = VK_VERTEX_INPUT_RATE_VERTEX},
+        {.binding = 1, .stride = sizeof(hgInstanceData), .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE}
+    };
+    VkPushConstantRange tPushRange = {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset     = 0,
+        .size       = sizeof(float) * 16
+    };
+    hgPipelineConfig tConfig = {
+        .pcVertexShaderPath        = bInstanced ? "../out/shaders/cube_instanced_vert.spv" : "../out/shaders/cube_push_vert.spv",
+        .pcFragmentShaderPath      = "../out/shaders/cube_frag.spv",
+        .ptBindingDescriptions     = atBindings,
+        .uBindingCount             = bInstanced ? 2 : 1,
+        .ptAttributeDescriptions   = atAttribs,
+        .uAttributeCount           = uAttributeCount,
+        .tCullMode                 = VK_CULL_MODE_NONE,
+        .tFrontFace                = VK_FRONT_FACE_CLOCKWISE,
+        .ptDescriptorSetLayouts    = &ptBench->tCameraSetLayout,
+        .uDescriptorSetLayoutCount = 1,
+        .ptPushConstantRanges      = bInstanced ? NULL : &tPushRange,
+        .uPushConstantRangeCount   = bInstanced ? 0 : 1,
+        .tPipelineBindPoint        = VK_PIPELINE_BIND_POINT_GRAPHICS
+    };
+    hgPipeline tPipeline;
+    double dPipelineStart = bench_time_ms();
+    hg_create_graphics_pipelines(ptState, &tConfig, 1, &tPipeline);
+    ptResult->fPipelineMs = (float)(bench_time_ms() - dPipelineStart);
+
+    float*        afModels = malloc(sizeof(float) * 16 * BENCH_CUBE_GRID * BENCH_CUBE_GRID);
+    hgRenderQueue tQueue   = hg_create_render_queue(tMode == BENCH_CUBES_QUEUE ? BENCH_CUBE_GRID * BENCH_CUBE_GRID : 0);
+
+    CameraBufferObject tCameraData;
+    const float fCameraDistance = (float)BENCH_CUBE_GRID * 2.5f;
+    mat4_translate(tCameraData.view, 0.0f, 0.0f, -fCameraDistance);
+    mat4_perspective(tCameraData.proj, 45.0f * 3.14159f / 180.0f, (float)BENCH_WIDTH / (float)BENCH_HEIGHT, 0.1f, 1000.0f);
+
+    const uint32_t uCubeCount = BENCH_CUBE_GRID * BENCH_CUBE_GRID;
+    double         dStartMs   = bench_time_ms();
+    double         dFrameMs   = dStartMs;
+    for(uint32_t uFrame = 0; uFrame < ptBench->uFrames; uFrame++)
+    {
+        uint32_t uImageIndex = hg_begin_frame(ptState);
+        hg_begin_render_pass(ptState, uImageIndex);
+
+        hg_update_uniform_slot(ptState, &tCamera, 0, &tCameraData, sizeof(tCameraData));
+        uint32_t uDynamicOffset = hg_get_uniform_dynamic_offset(ptState, &tCamera, 0);
+
+        for(uint32_t i = 0; i < uCubeCount; i++)
+        {
+            float* afModel = &afModels[i * 16];
+            mat4_rotate_y(afModel, (float)uFrame * 0.01f + (float)i * 0.25f);
+            afModel[12] = ((float)(i % BENCH_CUBE_GRID) - (float)(BENCH_CUBE_GRID - 1) * 0.5f) * 2.0f;
+            afModel[13] = ((float)(i / BENCH_CUBE_GRID) - (float)(BENCH_CUBE_GRID - 1) * 0.5f) * 2.0f;
+        }
+
+        if(bInstanced)
+        {
+            hgTransientAllocation tInstances = hg_alloc_instance_stream(ptState, afModels, NULL, uCubeCount);
+            hg_cmd_bind_pipeline(ptState, &tPipeline);
+            hg_cmd_bind_descriptor_sets(ptState, &tPipeline, 0, &tSet, 1, &uDynamicOffset, 1);
+            hg_cmd_bind_vertex_buffer(ptState, &tVertexBuffer);
+            hg_cmd_bind_vertex_stream(ptState, 1, tInstances.tBuffer, tInstances.tOffset);
+            hg_cmd_bind_index_buffer(ptState, &tIndexBuffer);
+        }
+
+        if(tMode == BENCH_CUBES_INSTANCED)
+        {
+            hg_cmd_draw_indexed_instanced(ptState, tIndexBuffer.uIndexCount, uCubeCount, 0, 0, 0);
+            ptResult->uDraws++;
+        }
+        else if(tMode == BENCH_CUBES_INDIRECT)
+        {
+            // firstInstance picks the cube's matrix, without drawIndirectFirstInstance every command has to use 0
+            // (same gpu work, the cubes just overlap)
+            bool                          bFirstInstance = ptState->tContextComponents.tEnabledFeatures.drawIndirectFirstInstance;
+            hgTransientAllocation         tCommands      = hg_alloc_indirect_commands(ptState, uCubeCount);
+            VkDrawIndexedIndirectCommand* atCommands     = tCommands.pData;
+            for(uint32_t i = 0; i < uCubeCount; i++)
+            {
+                atCommands[i] = (VkDrawIndexedIndirectCommand){
+                    .indexCount    = tIndexBuffer.uIndexCount,
+                    .instanceCount = 1,
+                    .firstIndex    = 0,
+                    .vertexOffset  = 0,
+                    .firstInstance = bFirstInstance ? i : 0
+                };
+            }
+            hg_cmd_draw_indexed_indirect(ptState, tCommands.tBuffer, tCommands.tOffset, uCubeCount);
+            ptResult->uDraws += uCubeCount;
+        }
+        else if(tMode == BENCH_CUBES_QUEUE)
+        {
+            // queued in grid order, the sort reorders them by distance to the camera (1000 is the far plane)
+            hgDrawPacket tPacket = {
+                .ptPipeline          = &tPipeline,
+                .atSets              = {tSet},
+                .uSetCount           = 1,
+                .auDynamicOffsets    = {uDynamicOffset},
+                .uDynamicOffsetCount = 1,
+                .tPushStages         = VK_SHADER_STAGE_VERTEX_BIT,
+                .uPushSize           = sizeof(float) * 16
+            };
+            hg_set_packet_mesh(&tPacket, &tVertexBuffer, &tIndexBuffer);
+            for(uint32_t i = 0; i < uCubeCount; i++)
+            {
+                float* afModel = &afModels[i * 16];
+                float  fDepth  = sqrtf(afModel[12] * afModel[12] + afModel[13] * afModel[13] + fCameraDistance * fCameraDistance) / 1000.0f;
+                memcpy(tPacket.auPushData, afModel, sizeof(float) * 16);
+                hg_queue_draw(&tQueue, hg_make_sort_key(0, 0, 0, fDepth, false), &tPacket);
+            }
+            hg_cmd_submit_render_queue(ptState, &tQueue);
+            ptResult->uDraws += uCubeCount;
+        }
+        else
+        {
+            // binds per cube the way a naive scene walk would, the tracker drops all but the first of each
+            for(uint32_t i = 0; i < uCubeCount; i++)
+            {
+                hg_cmd_bind_pipeline(ptState, &tPipeline);
+                hg_cmd_bind_descriptor_sets(ptState, &tPipeline, 0, &tSet, 1, &uDynamicOffset, 1);
+                hg_cmd_push_constants(ptState, &tPipeline, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16, &afModels[i * 16]);
+                hg_draw_mesh(ptState, &tVertexBuffer, &tIndexBuffer, 0);
+            }
+            ptResult->uDraws += uCubeCount;
+        }
+
+        hg_end_render_pass(ptState);
+        hg_end_frame(ptState, uImageIndex);
+
+        double dNowMs = bench_time_ms();
+        ptBench->afFrameMs[uFrame] = (float)(dNowMs - dFrameMs);
+        dFrameMs = dNowMs;
+    }
+    bench_finish_scene(ptBench, ptResult, dStartMs);
+
+    free(afModels);
+    hg_destroy_render_queue(&tQueue);
+    hg_destroy_pipeline(ptState, &tPipeline);
+    vkDestroyDescriptorPool(ptState->tContextComponents.tDevice, tPool, NULL);
+    hg_destroy_uniform_buffer(ptState, &tCamera);
+    hg_destroy_index_buffer(ptState, &tIndexBuffer);
+    hg_destroy_vertex_buffer(ptState, &tVertexBuffer);
+}
+
+// -------------------------------
+// texture streaming
+// -------------------------------
+void
+bench_scene_texture_stream(hgBenchContext* ptBench, hgBenchResult* ptResult)
+{
+    hgAppData* ptState = &ptBench->tState;
+    ptResult->pcName   = "texture_stream";
+
+    // texture i is drawn in frame i and rewritten BENCH_STREAM_COUNT - 1 frames later, by then the frame that
+    // sampled it has passed its fence wait in hg_begin_frame (at most HG_MAX_FRAMES_IN_FLIGHT frames in flight)
+    size_t         szTextureBytes = (size_t)BENCH_STREAM_SIZE * BENCH_STREAM_SIZE * 4;
+    unsigned char* pucPixels      = malloc(szTextureBytes);
+    hgTexture      atTextures[BENCH_STREAM_COUNT];
+    VkDescriptorSet atSets[BENCH_STREAM_COUNT];
+
+    VkDescriptorPoolSize tPoolSize = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BENCH_STREAM_COUNT};
+    VkDescriptorPool     tPool     = hg_create_descriptor_pool(ptState, BENCH_STREAM_COUNT, &tPoolSize, 1);
+    hg_begin_upload_batch(ptState);
+    for(uint32_t i = 0; i < BENCH_STREAM_COUNT; i++)
+    {
+        bench_fill_texture(pucPixels, BENCH_STREAM_SIZE, i);
+        atTextures[i] = hg_create_texture(ptState, pucPixels, BENCH_STREAM_SIZE, BENCH_STREAM_SIZE);
+        atSets[i]     = bench_allocate_set(ptBench, tPool, ptBench->tTextureSetLayout);
+        hg_update_texture_descriptor(ptState, atSets[i], 0, &atTextures[i], ptBench->tSampler);
+    }
+    hg_wait_for_upload(ptState, hg_submit_upload_batch(ptState));
+
+    float afQuadVertices[] = {
+        -1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+        -1.0f,  1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f,
+         1.0f,  1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+         1.0f, -1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f
+    };
+    uint16_t auQuadIndices[6] = {0, 1, 2, 2, 3, 0};
+    hg_begin_upload_batch(ptState);
+    hgVertexBuffer tVertexBuffer = hg_create_static_vertex_buffer(ptState, afQuadVertices, sizeof(afQuadVertices), sizeof(float) * 8);
+    hgIndexBuffer  tIndexBuffer  = hg_create_index_buffer(ptState, auQuadIndices, 6);
+    hg_wait_for_upload(ptState, hg_submit_upload_batch(ptState));
+
+    VkVertexInputAttributeDescription atAttribs[3] = {
+        {.location = 0, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT,       .offset = 0},
+        {.location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = sizeof(float) * 2},
+        {.location = 2, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT,       .offset = sizeof(float) * 6}
+    };
+    hgPipelineConfig tConfig = {
+        .pcVertexShaderPath        = "../out/shaders/textured_vert.spv",
+        .pcFragmentShaderPath      = "../out/shaders/textured_frag.spv",
+        .uVertexStride             = sizeof(float) * 8,
+        .ptAttributeDescriptions   = atAttribs,
+        .uAttributeCount           = 3,
+        .tCullMode                 = VK_CULL_MODE_NONE,
+        .tFrontFace                = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .ptDescriptorSetLayouts    = &ptBench->tTextureSetLayout,
+        .uDescriptorSetLayoutCount = 1,
+        .tPipelineBindPoint        = VK_PIPELINE_BIND_POINT_GRAPHICS
+    };
+    hgPipeline tPipeline;
+    double dPipelineStart = bench_time_ms();
+    hg_create_graphics_pipelines(ptState, &tConfig, 1, &tPipeline);
+    ptResult->fPipelineMs = (float)(bench_time_ms() - dPipelineStart);
+
+    hgUploadTicket uTicket   = 0;
+    double         dStartMs  = bench_time_ms();
+    double         dFrameMs  = dStartMs;
+    for(uint32_t uFrame = 0; uFrame < ptBench->uFrames; uFrame++)
+    {
+        uint32_t uImageIndex = hg_begin_frame(ptState);
+
+        // next frame's texture, submitted before this frame so queue order puts the copy ahead of the draw
+        uint32_t uUpload = (uFrame + 1) % BENCH_STREAM_COUNT;
+        bench_fill_texture(pucPixels, BENCH_STREAM_SIZE, uFrame + 1);
+        hg_begin_upload_batch(ptState);
+        hg_enqueue_image_upload(ptState, atTextures[uUpload].tImage, pucPixels, BENCH_STREAM_SIZE, BENCH_STREAM_SIZE);
+        uTicket = hg_submit_upload_batch(ptState);
+        ptResult->uUploadBytes += szTextureBytes;
+
+        hg_begin_render_pass(ptState, uImageIndex);
+        hg_cmd_bind_pipeline(ptState, &tPipeline);
+        hg_cmd_bind_descriptor_sets(ptState, &tPipeline, 0, &atSets[uFrame % BENCH_STREAM_COUNT], 1, NULL, 0);
+        hg_draw_mesh(ptState, &tVertexBuffer, &tIndexBuffer, 0);
+        ptResult->uDraws++;
+
+        hg_end_render_pass(ptState);
+        hg_end_frame(ptState, uImageIndex);
+
+        double dNowMs = bench_time_ms();
+        ptBench->afFrameMs[uFrame] = (float)(dNowMs - dFrameMs);
+        dFrameMs = dNowMs;
+    }
+    hg_wait_for_upload(ptState, uTicket);
+    bench_finish_scene(ptBench, ptResult, dStartMs);
+
+    hg_destroy_pipeline(ptState, &tPipeline);
+    vkDestroyDescriptorPool(ptState->tContextComponents.tDevice, tPool, NULL);
+    for(uint32_t i = 0; i < BENCH_STREAM_COUNT; i++) hg_destroy_texture(ptState, &atTextures[i]);
+    hg_destroy_index_buffer(ptState, &tIndexBuffer);
+    hg_destroy_vertex_buffer(ptState, &tVertexBuffer);
+    free(pucPixels);
+}
+
+// -------------------------------
+// results
+// -------------------------------
+void
+bench_write_json(FILE* pFile, hgBenchContext* ptBench, hgBenchResult* atResults, uint32_t uResultCount)
+{
+    VkPhysicalDeviceProperties* ptProperties = &ptBench->tState.tContextComponents.tDeviceProperties;
+    fprintf(pFile, "{\n");
+    fprintf(pFile, "  \"device\": \"%s\",\n", ptProperties->deviceName);
+    fprintf(pFile, "  \"driver_version\": %u,\n", ptProperties->driverVersion);
+    fprintf(pFile, "  \"width\": %d,\n  \"height\": %d,\n", BENCH_WIDTH, BENCH_HEIGHT);
+    fprintf(pFile, "  \"frames_in_flight\": %u,\n", hg_get_frames_in_flight(&ptBench->tState));
+    fprintf(pFile, "  \"multi_draw_indirect\": %s,\n", hg_supports_multi_draw_indirect(&ptBench->tState) ? "true" : "false");
+    fprintf(pFile, "  \"scenes\": [\n");
+    for(uint32_t i = 0; i < uResultCount; i++)
+    {
+        hgBenchResult* ptResult = &atResults[i];
+        fprintf(pFile, "    {\n");
+        fprintf(pFile, "      \"name\": \"%s\",\n", ptResult->pcName);
+        fprintf(pFile, "      \"frames\": %u,\n", ptResult->uFrames);
+        fprintf(pFile, "      \"elapsed_s\": %.4f,\n", ptResult->dElapsedSec);
+        fprintf(pFile, "      \"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+            ptResult->fMeanMs, ptResult->fP50Ms, ptResult->fP90Ms, ptResult->fP99Ms, ptResult->fMaxMs);
+        fprintf(pFile, "      \"gpu_frame_ms\": %.4f,\n", ptResult->fGpuFrameMs);
+        fprintf(pFile, "      \"draws\": %llu,\n", (unsigned long long)ptResult->uDraws);
+        fprintf(pFile, "      \"draws_per_s\": %.1f,\n", ptResult->dDrawsPerSec);
+        fprintf(pFile, "      \"upload_bytes\": %llu,\n", (unsigned long long)ptResult->uUploadBytes);
+        fprintf(pFile, "      \"upload_mb_per_s\": %.2f,\n", ptResult->dUploadMBps);
+        fprintf(pFile, "      \"pipeline_create_ms\": %.3f,\n", ptResult->fPipelineMs);
+        fprintf(pFile, "      \"binds_per_frame\": {\"issued\": %u, \"skipped\": %u},\n",
+            ptResult->tBindStats.uBindsIssued, ptResult->tBindStats.uBindsSkipped);
+        fprintf(pFile, "      \"instances_per_frame\": %u\n", ptResult->tBindStats.uInstances);
+        fprintf(pFile, "    }%s\n", i + 1 < uResultCount ? "," : "");
+    }
+    fprintf(pFile, "  ]\n}\n");
+}
+
+int
+main(int argc, char** argv)
+{
+    hgBenchContext tBench = {0};
+    tBench.uFrames = argc > 1 ? (uint32_t)atoi(argv[1]) : BENCH_DEFAULT_FRAMES;
+    if(tBench.uFrames == 0) tBench.uFrames = BENCH_DEFAULT_FRAMES;
+    const char* pcOutputPath = argc > 2 ? argv[2] : NULL;
+
+    // offscreen, no window system -> identical setup on a desktop gpu and a software icd in ci
+    hgAppData* ptState = &tBench.tState;
+    ptState->bHeadless           = true;
+    ptState->width               = BENCH_WIDTH;
+    ptState->height              = BENCH_HEIGHT;
+    ptState->bDepthEnabled       = true;
+    ptState->bGpuProfiling       = true;
+    ptState->uFramesInFlight     = 2;
+    ptState->tPacingMode         = HG_PACING_THROUGHPUT;
+    ptState->pcPipelineCachePath = "bench_pipeline_cache.bin";
+
+    hg_create_instance(ptState, "vkHomeGrown bench", VK_MAKE_VERSION(1, 0, 0), false);
+    hg_create_surface(ptState);
+    hg_pick_physical_device(ptState);
+    hg_create_logical_device(ptState);
+
+    hgRenderPassConfig tRenderPassConfig = {
+        .tLoadOp      = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .tStoreOp     = VK_ATTACHMENT_STORE_OP_STORE,
+        .afClearColor = {0.0f, 0.0f, 0.0f, 1.0f}
+    };
+    hg_create_swapchain(ptState, VK_PRESENT_MODE_IMMEDIATE_KHR);
+    hg_create_render_pass(ptState, &tRenderPassConfig);
+    hg_create_depth_resources(ptState);
+    hg_create_framebuffers(ptState);
+    hg_create_command_pool(ptState);
+    hg_create_sync_objects(ptState);
+    hg_allocate_frame_cmd_buffers(ptState);
+
+    // layouts/sampler shared by the scenes
+    VkDevice tDevice = ptState->tContextComponents.tDevice;
+    VkDescriptorSetLayoutBinding tTextureBinding = {
+        .binding         = 0,
+        .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags      = VK_SHADER_STAGE_FRAGMENT_BIT
+    };
+    VkDescriptorSetLayoutBinding tCameraBinding = {
+        .binding         = 0,
+        .descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        .descriptorCount = 1,
+        .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT
+    };
+    VkDescriptorSetLayoutCreateInfo tLayoutInfo = {
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings    = &tTextureBinding
+    };
+    VULKAN_CHECK(vkCreateDescriptorSetLayout(tDevice, &tLayoutInfo, NULL, &tBench.tTextureSetLayout));
+    tLayoutInfo.pBindings = &tCameraBinding;
+    VULKAN_CHECK(vkCreateDescriptorSetLayout(tDevice, &tLayoutInfo, NULL, &tBench.tCameraSetLayout));
+
+    VkSamplerCreateInfo tSamplerInfo = {
+        .sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter    = VK_FILTER_LINEAR,
+        .minFilter    = VK_FILTER_LINEAR,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+        .maxAnisotropy = 1.0f,
+        .borderColor  = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+        .compareOp    = VK_COMPARE_OP_ALWAYS,
+        .mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR
+    };
+    VULKAN_CHECK(vkCreateSampler(tDevice, &tSamplerInfo, NULL, &tBench.tSampler));
+
+    tBench.afFrameMs = malloc(tBench.uFrames * sizeof(float));
+
+    hgBenchResult atResults[6] = {0};
+    bench_scene_quad(&tBench, &atResults[0]);
+    bench_scene_cubes(&tBench, &atResults[1], BENCH_CUBES_DRAWS);
+    bench_scene_cubes(&tBench, &atResults[2], BENCH_CUBES_INSTANCED);
+    bench_scene_cubes(&tBench, &atResults[3], BENCH_CUBES_INDIRECT);
+    bench_scene_cubes(&tBench, &atResults[4], BENCH_CUBES_QUEUE);
+    bench_scene_texture_stream(&tBench, &atResults[5]);
+
+    FILE* pFile = pcOutputPath ? fopen(pcOutputPath, "w") : stdout;
+    if(!pFile)
+    {
+        printf("failed to open %s\n", pcOutputPath);
+        pFile = stdout;
+    }
+    bench_write_json(pFile, &tBench, atResults, 6);
+    if(pFile != stdout) fclose(pFile);
+
+    // cleanup
+    free(tBench.afFrameMs);
+    vkDestroySampler(tDevice, tBench.tSampler, NULL);
+    vkDestroyDescriptorSetLayout(tDevice, tBench.tTextureSetLayout, NULL);
+    vkDestroyDescriptorSetLayout(tDevice, tBench.tCameraSetLayout, NULL);
+    hg_core_cleanup(ptState);
+
+    return 0;
+}
@@ -118,6 +118,32 @@
     @goto ShaderError
 )
 
+@if exist "%SHADER_DIR%/cube_push_vert.vert" (
+    @echo Compiling vertex shader...
+    "%VULKAN_SDK%\Bin\glslc.exe" "%SHADER_DIR%/cube_push_vert.vert" -o "%OUTPUT_DIR%/shaders/cube_push_vert.spv"
+    @if %ERRORLEVEL% NEQ 0 (
+        @echo [91mFailed to compile vertex shader[0m
+        @goto ShaderError
+    )
+) else (
+    @echo [91mError: cube_push_vert.vert not found at %SHADER_DIR%/cube_push_vert.vert[0m
+    @dir "%SHADER_DIR%"
+    @goto ShaderError
+)
+
+@if exist "%SHADER_DIR%/cube_instanced.vert" (
+    @echo Compiling vertex shader...
+    "%VULKAN_SDK%\Bin\glslc.exe" "%SHADER_DIR%/cube_instanced.vert" -o "%OUTPUT_DIR%/shaders/cube_instanced_vert.spv"
+    @if %ERRORLEVEL% NEQ 0 (
+        @echo [91mFailed to compile vertex shader[0m
+        @goto ShaderError
+    )
+) else (
+    @echo [91mError: cube_instanced.vert not found at %SHADER_DIR%/cube_instanced.vert[0m
+    @dir "%SHADER_DIR%"
+    @goto ShaderError
+)
+
 @echo [92mShader compilation complete![0m
 @goto AfterShaders
 
@@ -139,7 +165,7 @@ cl main.c vkHomeGrown.c -Fe"%OUTPUT_DIR%/vkHomeGrown.exe" -Fo"%OUTPUT_DIR%/" -Od
 -I"%VULKAN_SDK%/Include" ^
 -MD -link -incremental:no ^
 /LIBPATH:"%VULKAN_SDK%/Lib" ^
-"%DEPENDENCIES_DIR%\glfw3.lib" vulkan-1.lib user32.lib gdi32.lib shell32.lib
+"%DEPENDENCIES_DIR%\glfw3.lib" vulkan-1.lib user32.lib gdi32.lib shell32.lib winmm.lib
 
 @set PL_BUILD_STATUS=%ERRORLEVEL%
 
@@ -149,6 +175,24 @@ cl main.c vkHomeGrown.c -Fe"%OUTPUT_DIR%/vkHomeGrown.exe" -Fo"%OUTPUT_DIR%/" -Od
     goto Cleanupcpptest
 )
 
+@echo [1m[36mCompiling benchmark...[0m
+
+cl bench.c vkHomeGrown.c -Fe"%OUTPUT_DIR%/vkHomeGrownBench.exe" -Fo"%OUTPUT_DIR%/" -O2 -Zi -nologo ^
+-DHG_NO_GLFW ^
+-I"%PROJECT_ROOT%/dependencies/stb" ^
+-I"%VULKAN_SDK%/Include" ^
+-MD -link -incremental:no ^
+/LIBPATH:"%VULKAN_SDK%/Lib" ^
+vulkan-1.lib winmm.lib
+
+@set PL_BUILD_STATUS=%ERRORLEVEL%
+
+@if %PL_BUILD_STATUS% NEQ 0 (
+    @echo [1m[91mBenchmark compilation Failed with error code[0m: %PL_BUILD_STATUS%
+    @set PL_RESULT=[1m[91mFailed.[0m
+    goto Cleanupcpptest
+)
+
 @if exist "%DEPENDENCIES_DIR%\glfw3.dll" (
     @echo Copying GLFW DLL to output folder...
     copy "%DEPENDENCIES_DIR%\glfw3.dll" "%OUTPUT_DIR%\" > nul
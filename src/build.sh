@@ -0,0 +1,43 @@
+#!/bin/sh
+# linux build -> headless benchmark (no glfw needed), shaders compiled with glslc from the vulkan sdk / distro package
+# run the result from out/ so the ../out/shaders paths resolve, e.g. with lavapipe:
+#   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./vkHomeGrownBench 500 bench.json
+
+set -e
+cd "$(dirname "$0")"
+
+PROJECT_ROOT=..
+SHADER_DIR=shaders
+OUTPUT_DIR=$PROJECT_ROOT/out
+DEPENDENCIES_DIR=$PROJECT_ROOT/dependencies
+CC=${CC:-cc}
+GLSLC=${GLSLC:-glslc}
+
+# warnings fail the build on ci (CI is set by most ci services) or with WERROR=1
+WARNINGS="-Wall -Wextra"
+if [ -n "${CI:-}" ] || [ "${WERROR:-0}" = "1" ]; then
+    WARNINGS="$WARNINGS -Werror"
+fi
+
+mkdir -p "$OUTPUT_DIR/shaders"
+
+echo "Compiling shaders..."
+for SHADER in textured.vert textured.frag not_textured.vert not_textured.frag cube_vert.vert cube_frag.frag cube_push_vert.vert cube_instanced.vert
+do
+    NAME=${SHADER%.*}
+    case "$SHADER" in
+        textured.*|not_textured.*|cube_instanced.*) OUTPUT="${NAME}_${SHADER##*.}.spv" ;;
+        *)                                          OUTPUT="${NAME}.spv" ;;
+    esac
+    "$GLSLC" "$SHADER_DIR/$SHADER" -o "$OUTPUT_DIR/shaders/$OUTPUT"
+done
+
+echo "Compiling and Linking..."
+"$CC" -std=gnu11 -O2 -g $WARNINGS -DHG_NO_GLFW \
+    bench.c vkHomeGrown.c \
+    -I"$DEPENDENCIES_DIR" \
+    -I"$DEPENDENCIES_DIR/stb" \
+    -o "$OUTPUT_DIR/vkHomeGrownBench" \
+    -lvulkan -lpthread -lm
+
+echo "Result: Successful."
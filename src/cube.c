@@ -8,8 +8,9 @@ int main(void)
 {
 
     // example settings
-    bool bQuad     = true;  // false renders a triangle
-    bool bTextured = false; // false renders colors in vert data 
+    bool bQuad      = true;  // false renders a triangle
+    bool bTextured  = false; // false renders colors in vert data 
+    bool bInstanced = true;  // false pushes a model matrix per cube (one draw each)
 
     // init GLFW
     if (!glfwInit()) 
@@ -32,10 +33,11 @@ int main(void)
 
     // init app state
     hgAppData tState = {0};
-    tState.pWindow       = window;  // store GLFW window pointer
-    tState.width         = 800;
-    tState.height        = 600;
-    tState.bDepthEnabled = true;
+    tState.pWindow         = window;  // store GLFW window pointer
+    tState.width           = 800;
+    tState.height          = 600;
+    tState.bDepthEnabled   = true;
+    tState.uFramesInFlight = 2;
 
     // get actual window size (framebuffer size for Vulkan)
     int fbWidth, fbHeight;
@@ -91,19 +93,26 @@ int main(void)
     hg_create_framebuffers(&tState);
     hg_create_command_pool(&tState);
 
-    hgVertexBuffer tCubeVertexBuffer = hg_create_vertex_buffer(&tState, tCubeVertices, sizeof(tCubeVertices), sizeof(hgVertex));
+    hgVertexBuffer tCubeVertexBuffer = hg_create_static_vertex_buffer(&tState, tCubeVertices, sizeof(tCubeVertices), sizeof(hgVertex));
     hgIndexBuffer  tCubeIndexBuffer  = hg_create_index_buffer(&tState, tCubeIndices, 36);
 
+    // camera matrices live in a single slot dynamic uniform buffer (one copy per frame in flight),
+    // per cube model matrices go into a per instance stream (or are pushed as push constants)
+    const uint32_t uGridSize  = 5;
+    const uint32_t uCubeCount = uGridSize * uGridSize;
+    float*         afModels   = malloc(sizeof(float) * 16 * uCubeCount);
+    hgUniformBuffer tCameraUniforms = hg_create_dynamic_uniform_buffer(&tState, sizeof(CameraBufferObject), 1);
+
     // descriptors 
-    VkDescriptorPoolSize  tPoolSize = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 50};
-    VkDescriptorPool      tDescPool = hg_create_descriptor_pool(&tState, 100, &tPoolSize, 1);
+    VkDescriptorPoolSize  tPoolSize = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1};
+    VkDescriptorPool      tDescPool = hg_create_descriptor_pool(&tState, 1, &tPoolSize, 1);
     VkDescriptorSetLayout tDescriptorSetLayout = VK_NULL_HANDLE;
-    VkDescriptorSet       tDescriptorSet       = VK_NULL_HANDLE;
+    VkDescriptorSet       tDescriptorSet = VK_NULL_HANDLE;
 
     // sets and layouts
     VkDescriptorSetLayoutBinding tUboLayout = {
         .binding         = 0,
-        .descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
         .descriptorCount = 1,
         .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT
     };
@@ -114,7 +123,6 @@ int main(void)
     };
     VULKAN_CHECK(vkCreateDescriptorSetLayout(tState.tContextComponents.tDevice, &tDescriptorLayoutInfo, NULL, &tDescriptorSetLayout));
 
-    // allocate
     const VkDescriptorSetAllocateInfo tDescSetAllocInfo = {
         .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool     = tDescPool,
@@ -122,48 +130,45 @@ int main(void)
         .pSetLayouts        = &tDescriptorSetLayout
     };
     VULKAN_CHECK(vkAllocateDescriptorSets(tState.tContextComponents.tDevice, &tDescSetAllocInfo, &tDescriptorSet));
-
-    // create uniform buffer
-    hgUniformBuffer tUniBuffer = hg_create_uniform_buffer(&tState, sizeof(UniformBufferObject));
-
-    VkDescriptorBufferInfo tBufferInfo = {
-        .buffer = tUniBuffer.tBuffer,
-        .offset = 0,
-        .range  = sizeof(UniformBufferObject)
-    };
-    
-    VkWriteDescriptorSet tDescriptorWrite = {
-        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet          = tDescriptorSet,
-        .dstBinding      = 0,
-        .dstArrayElement = 0,
-        .descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .descriptorCount = 1,
-        .pBufferInfo     = &tBufferInfo
-    };
-    vkUpdateDescriptorSets(tState.tContextComponents.tDevice, 1, &tDescriptorWrite, 0, NULL);
+    hg_update_uniform_descriptor(&tState, tDescriptorSet, 0, &tCameraUniforms);
 
 
     // tests for new pipeline creation
-    VkVertexInputAttributeDescription tTestVertAttribs[3] = {
+    VkVertexInputAttributeDescription tTestVertAttribs[2 + HG_INSTANCE_ATTRIBUTE_COUNT] = {
         {.location = 0, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT,    .offset = 0},                 // pos
         {.location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = sizeof(float) * 3}, // color
 
     };
+    // instanced -> binding 1 advances once per cube and feeds the model matrix + color at locations 2..6
+    uint32_t uAttributeCount = 2;
+    if(bInstanced) uAttributeCount += hg_get_instance_attributes(1, 2, &tTestVertAttribs[2]);
+
+    VkVertexInputBindingDescription tBindings[2] = {
+        {.binding = 0, .stride = sizeof(float) * 9,      .inputRate = VK_VERTEX_INPUT_RATE_VERTEX},   // using hgvertex type which has u, v (not used here) but stride needs to match
+        {.binding = 1, .stride = sizeof(hgInstanceData), .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE}
+    };
+
+    // model matrix per draw
+    VkPushConstantRange tPushConstantRange = {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+        .offset     = 0,
+        .size       = sizeof(float) * 16
+    };
 
     hgPipelineConfig tTestConfig = {
-        .pcVertexShaderPath        = "../out/shaders/cube_vert.spv",
+        .pcVertexShaderPath        = bInstanced ? "../out/shaders/cube_instanced_vert.spv" : "../out/shaders/cube_push_vert.spv",
         .pcFragmentShaderPath      = "../out/shaders/cube_frag.spv",
-        .uVertexStride             = sizeof(float) * 9, // using hgvertex type which has u, v (not used here) but stride needs to match
+        .ptBindingDescriptions     = tBindings,
+        .uBindingCount             = bInstanced ? 2 : 1,
         .ptAttributeDescriptions   = tTestVertAttribs,
-        .uAttributeCount           = 2,
+        .uAttributeCount           = uAttributeCount,
         .bBlendEnable              = VK_FALSE,
         .tCullMode                 = VK_CULL_MODE_NONE,
         .tFrontFace                = VK_FRONT_FACE_CLOCKWISE,
         .ptDescriptorSetLayouts    = &tDescriptorSetLayout,
         .uDescriptorSetLayoutCount = 1,
-        .ptPushConstantRanges      = NULL,
-        .uPushConstantRangeCount   = 0,
+        .ptPushConstantRanges      = bInstanced ? NULL : &tPushConstantRange,
+        .uPushConstantRangeCount   = bInstanced ? 0 : 1,
         .tPipelineBindPoint        = VK_PIPELINE_BIND_POINT_GRAPHICS // for pipeline binding
     };
     hgPipeline tCubePipline = hg_create_graphics_pipeline(&tState, &tTestConfig);
@@ -181,52 +186,61 @@ int main(void)
     {
         glfwPollEvents();
 
-        int newWidth, newHeight;
-        glfwGetFramebufferSize(window, &newWidth, &newHeight);
-
-        // handle resize or minimization (width and height are 0)
-        if (newWidth != tState.width || newHeight != tState.height || newWidth == 0 || newHeight == 0) 
-        {
-            vkDeviceWaitIdle(tState.tContextComponents.tDevice); // wait for device to finish current work
-            hg_recreate_swapchain(&tState); // recreate swapchain and dependent resources
-            continue; // skip this frame
-        }
-
         // rotate cube each frame
         rotation += 0.01f;
 
-        UniformBufferObject uboData = {0};
-
-        // model matrix - rotate around Y axis
-        mat4_rotate_y(uboData.model, rotation);
+        CameraBufferObject tCameraData = {0};
 
-        // view matrix - camera at (0, 0, 3) looking at origin
-        mat4_translate(uboData.view, 0.0f, 0.0f, -5.0f);
+        // view matrix - camera pulled back far enough to see the whole grid
+        mat4_translate(tCameraData.view, 0.0f, 0.0f, -12.0f);
 
         // projection matrix - perspective
         float aspect = (float)tState.width / (float)tState.height;
-        mat4_perspective(uboData.proj, 45.0f * 3.14159f / 180.0f, aspect, 0.1f, 100.0f);
-
-        // update the uniform buffer
-        hg_update_uniform_buffer(&tState, &tUniBuffer, &uboData, sizeof(uboData));
-
-        VkDeviceSize tOffset[] = {0}; // no offset but vkCmdBindVertexBuffers wants this type passed in
+        mat4_perspective(tCameraData.proj, 45.0f * 3.14159f / 180.0f, aspect, 0.1f, 100.0f);
 
         // begin frame
         uint32_t uImageIndex = hg_begin_frame(&tState);
         hg_begin_render_pass(&tState, uImageIndex);
 
+        // camera slot is written after begin frame so the gpu is done with this frame's copy
+        hg_update_uniform_slot(&tState, &tCameraUniforms, 0, &tCameraData, sizeof(tCameraData));
+        uint32_t uDynamicOffset = hg_get_uniform_dynamic_offset(&tState, &tCameraUniforms, 0);
+
         // scene/ frame building -> testing stuff in here for now
-        vkCmdBindPipeline(tState.tCommandComponents.tCommandBuffers[uImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, tCubePipline.tPipeline);
-        vkCmdBindDescriptorSets(tState.tCommandComponents.tCommandBuffers[uImageIndex], tCubePipline.tPipelineBindPoint, 
-                tCubePipline.tPipelineLayout, 0, 1, &tDescriptorSet, 0, 0);
-        vkCmdBindVertexBuffers(tState.tCommandComponents.tCommandBuffers[uImageIndex], 0, 1, &tCubeVertexBuffer.tBuffer, tOffset);
-        vkCmdBindIndexBuffer(tState.tCommandComponents.tCommandBuffers[uImageIndex], tCubeIndexBuffer.tBuffer, 0, VK_INDEX_TYPE_UINT16);
-        vkCmdDrawIndexed(tState.tCommandComponents.tCommandBuffers[uImageIndex], tCubeIndexBuffer.uIndexCount, 1, 0, 0, 0);
+        hg_cmd_bind_pipeline(&tState, &tCubePipline);
+        hg_cmd_bind_descriptor_sets(&tState, &tCubePipline, 0, &tDescriptorSet, 1, &uDynamicOffset, 1);
+        for(uint32_t i = 0; i < uCubeCount; i++)
+        {
+            // model matrix - rotate around Y axis, then place on the grid
+            float* afModel = &afModels[i * 16];
+            mat4_rotate_y(afModel, rotation + (float)i * 0.25f);
+            afModel[12] = ((float)(i % uGridSize) - (float)(uGridSize - 1) * 0.5f) * 2.0f;
+            afModel[13] = ((float)(i / uGridSize) - (float)(uGridSize - 1) * 0.5f) * 2.0f;
+        }
+
+        if(bInstanced)
+        {
+            // whole grid in one draw, the matrices only exist in this frame's transient memory
+            hgTransientAllocation tInstances = hg_alloc_instance_stream(&tState, afModels, NULL, uCubeCount);
+            hg_cmd_bind_vertex_buffer(&tState, &tCubeVertexBuffer);
+            hg_cmd_bind_vertex_stream(&tState, 1, tInstances.tBuffer, tInstances.tOffset);
+            hg_cmd_bind_index_buffer(&tState, &tCubeIndexBuffer);
+            hg_cmd_draw_indexed_instanced(&tState, tCubeIndexBuffer.uIndexCount, uCubeCount, 0, 0, 0);
+        }
+        else
+        {
+            for(uint32_t i = 0; i < uCubeCount; i++)
+            {
+                // no descriptor or uniform traffic per cube, just 64 bytes in the command buffer
+                hg_cmd_push_constants(&tState, &tCubePipline, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(float) * 16, &afModels[i * 16]);
+                // same mesh every time -> only the first iteration actually binds the buffers
+                hg_draw_mesh(&tState, &tCubeVertexBuffer, &tCubeIndexBuffer, 0);
+            }
+        }
 
         // end frame 
         hg_end_render_pass(&tState);
-        hg_end_frame(&tState, tState.tCommandComponents.uCurrentImageIndex);
+        hg_end_frame(&tState, uImageIndex);
 
     }
 
@@ -234,9 +248,10 @@ int main(void)
     vkDeviceWaitIdle(tState.tContextComponents.tDevice);  // wait before cleanup
 
     // destroy low level resources first 
+    free(afModels);
     hg_destroy_vertex_buffer(&tState, &tCubeVertexBuffer);
     hg_destroy_index_buffer(&tState, &tCubeIndexBuffer);
-    hg_destroy_uniform_buffer(&tState, &tUniBuffer);
+    hg_destroy_uniform_buffer(&tState, &tCameraUniforms);
 
     // destroy pipeline 
     hg_destroy_pipeline(&tState, &tCubePipline); // destroys pipeline + pipeline layout
@@ -13,6 +13,13 @@ typedef struct _UniformBufferObject
     float proj[16];
 } UniformBufferObject;
 
+// per frame camera data -> the model matrix goes through push constants instead
+typedef struct _CameraBufferObject
+{
+    float view[16];
+    float proj[16];
+} CameraBufferObject;
+
 
 void 
 mat4_identity(float* m) 
@@ -34,11 +34,12 @@ int main(void)
     }
 
     // init app state
-    hgAppData tState     = {0};
-    tState.pWindow       = window;  // store GLFW window pointer
-    tState.width         = 800;
-    tState.height        = 600;
-    tState.bDepthEnabled = false;
+    hgAppData tState       = {0};
+    tState.pWindow         = window;  // store GLFW window pointer
+    tState.width           = 800;
+    tState.height          = 600;
+    tState.bDepthEnabled   = false;
+    tState.uFramesInFlight = 2;       // cpu records the next frame while the gpu renders this one
 
     // get actual window size (framebuffer size for Vulkan)
     int fbWidth, fbHeight;
@@ -85,9 +86,9 @@ int main(void)
     hg_create_framebuffers(&tState);
     hg_create_command_pool(&tState);
 
-    // create dynamic buffer so data is cpu accessible for example
-    hgVertexBuffer fTestVertBufferQuad = hg_create_dynamic_vertex_buffer(&tState, fTestVerticesQuad, sizeof(fTestVerticesQuad), sizeof(float) * 8);
-    hgIndexBuffer  tTestIndBuffer      = hg_create_index_buffer(&tState, uTestIndices, 6);
+    // quad vertices are rewritten every frame into transient memory (see main loop), only the indices need a buffer
+    uint32_t      uQuadVertexCount = sizeof(fTestVerticesQuad) / (sizeof(float) * 8);
+    hgIndexBuffer tTestIndBuffer   = hg_create_index_buffer(&tState, uTestIndices, 6);
 
 
     // descriptors 
@@ -125,7 +126,11 @@ int main(void)
     int iTextureHeight = 0;
     int iTextureWidth  = 0;
     unsigned char* pcTextureData = hg_load_texture_data("../textures/cobble.png", &iTextureWidth, &iTextureHeight);
+
+    // inside a batch the copy is only recorded -> no stall, the texture can be drawn with once the batch is submitted
+    hg_begin_upload_batch(&tState);
     hgTexture      tTestTexture  = hg_create_texture(&tState, pcTextureData, iTextureWidth, iTextureHeight);
+    hg_submit_upload_batch(&tState);
 
     // sampler
     VkSampler tTextureSampler;
@@ -185,20 +190,6 @@ int main(void)
     {
         glfwPollEvents();
 
-        int newWidth, newHeight;
-        glfwGetFramebufferSize(window, &newWidth, &newHeight);
-
-        // handle resize or minimization (width and height are 0)
-        if (newWidth != tState.width || newHeight != tState.height || newWidth == 0 || newHeight == 0) 
-        {
-            // wait for device to finish current work
-            vkDeviceWaitIdle(tState.tContextComponents.tDevice);
-
-            // recreate swapchain and dependent resources
-            hg_recreate_swapchain(&tState);
-            continue; // skip this frame
-        }
-
         // get time for rotation
         float fTimeElapsed = glfwGetTime();
         // calculate angle
@@ -207,7 +198,7 @@ int main(void)
         float fVertexDataCopy[sizeof(fTestVerticesQuad) / sizeof(float)] = {0};
         memcpy(fVertexDataCopy, fTestVerticesQuad, sizeof(fTestVerticesQuad));
         // loop through to apply new angles 
-        for(uint32_t i = 0; i < fTestVertBufferQuad.uVertexCount * 8; i+= 8) // 8 is vertex stride to skip color, uv 
+        for(uint32_t i = 0; i < uQuadVertexCount * 8; i+= 8) // 8 is vertex stride to skip color, uv 
         {
             fResultX = fRadius * cosf(fAngle);
             fResultY = fRadius * sinf(fAngle);
@@ -215,30 +206,30 @@ int main(void)
             fVertexDataCopy[i]     =  fTestVerticesQuad[i]     + fResultX;
             fVertexDataCopy[i + 1] =  fTestVerticesQuad[i + 1] + fResultY;
         }
-        // memcpy new vertex data into vkbuffer object here
-        memcpy(fTestVertBufferQuad.pDataMapped, fVertexDataCopy, sizeof(fVertexDataCopy));
+        // memcpy new vertex data into this frame's transient memory -> no per frame buffers to manage
+        hgTransientAllocation tQuadVertices = hg_alloc_transient(&tState, sizeof(fVertexDataCopy));
+        memcpy(tQuadVertices.pData, fVertexDataCopy, sizeof(fVertexDataCopy));
 
         // begin frame
         uint32_t uImageIndex = hg_begin_frame(&tState);
         hg_begin_render_pass(&tState, uImageIndex);
 
         // scene/ frame building -> testing stuff in here for now
-        vkCmdBindPipeline(tState.tCommandComponents.tCommandBuffers[uImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, tTestPipeline.tPipeline);
+        hg_cmd_bind_pipeline(&tState, &tTestPipeline);
 
         if(bTextured) // apply texture 
         {
-            vkCmdBindDescriptorSets(tState.tCommandComponents.tCommandBuffers[uImageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, tTestPipeline.tPipelineLayout, 0, 1, &tDescriptorSet, 0, NULL);
+            hg_cmd_bind_descriptor_sets(&tState, &tTestPipeline, 0, &tDescriptorSet, 1, NULL, 0);
         }
 
         // bind vertex buffer
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(tState.tCommandComponents.tCommandBuffers[uImageIndex], 0, 1, &fTestVertBufferQuad.tBuffer, offsets);
-        vkCmdBindIndexBuffer(tState.tCommandComponents.tCommandBuffers[uImageIndex], tTestIndBuffer.tBuffer, 0, VK_INDEX_TYPE_UINT16);
-        vkCmdDrawIndexed(tState.tCommandComponents.tCommandBuffers[uImageIndex], tTestIndBuffer.uIndexCount, 1, 0, 0, 0);
+        hg_cmd_bind_transient_vertex_buffer(&tState, &tQuadVertices);
+        hg_cmd_bind_index_buffer(&tState, &tTestIndBuffer);
+        hg_cmd_draw_indexed(&tState, tTestIndBuffer.uIndexCount, 0, 0);
 
         // end frame 
         hg_end_render_pass(&tState);
-        hg_end_frame(&tState, tState.tCommandComponents.uCurrentImageIndex);
+        hg_end_frame(&tState, uImageIndex);
 
     }
 
@@ -247,7 +238,6 @@ int main(void)
 
     // destroy low level resources first 
     hg_destroy_texture(&tState, &tTestTexture); // destroys image, image view, memory
-    hg_destroy_vertex_buffer(&tState, &fTestVertBufferQuad);
     hg_destroy_index_buffer(&tState, &tTestIndBuffer);
 
     // destroy pipeline 
@@ -260,6 +250,9 @@ int main(void)
 
     // should be called after all other cleanup
     hg_core_cleanup(&tState);
+#ifdef HG_ENABLE_TRACE
+    hg_trace_dump("trace.json"); // open in ui.perfetto.dev or chrome://tracing
+#endif
     glfwDestroyWindow(window);
     glfwTerminate();
 
@@ -0,0 +1,22 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;  
+
+// per instance stream (hgInstanceData) -> the mat4 takes locations 2..5
+layout(location = 2) in mat4 inModel;
+layout(location = 6) in vec4 inInstanceColor;
+
+// shared by every instance
+layout(binding = 0) uniform CameraBufferObject {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+layout(location = 0) out vec4 fragColor;  
+
+void main() 
+{
+    gl_Position = camera.proj * camera.view * inModel * vec4(inPosition, 1.0);
+    fragColor = inColor * inInstanceColor;
+}
@@ -0,0 +1,23 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;  
+
+// shared by every draw in the frame
+layout(binding = 0) uniform CameraBufferObject {
+    mat4 view;
+    mat4 proj;
+} camera;
+
+// per draw -> 64 bytes, fits the 128 byte minimum maxPushConstantsSize
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+} pc;
+
+layout(location = 0) out vec4 fragColor;  
+
+void main() 
+{
+    gl_Position = camera.proj * camera.view * pc.model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+}
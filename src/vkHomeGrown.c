@@ -13,6 +13,27 @@
 
 #include "vkHomeGrown.h"
 #include <assert.h>
+#include <string.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <time.h>
+#include <sys/stat.h>
+
+// memory mapped file access (spir-v loading) + threads (pipeline workers)
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <mmsystem.h> // timeBeginPeriod (winmm)
+    #ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+        #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002 // older sdks, the flag itself needs windows 10 1803
+    #endif
+#else
+    #include <errno.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <pthread.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -24,28 +45,227 @@
 // INTERNAL API DECLARATIONS
 // =============================================================================
 
-// low level buffer operations
-uint32_t hg_find_memory_type(hgVulkanContext* context, uint32_t typeFilter, VkMemoryPropertyFlags properties);
-void     hg_create_buffer(hgVulkanContext* context, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, VkDeviceMemory* memory);
-void     hg_copy_buffer(hgVulkanContext* context, hgCommandResources* commands, VkBuffer src, VkBuffer dst, VkDeviceSize size);
+// device memory allocator
+void hg_init_allocator(hgAppData* ptState);
+void hg_destroy_allocator(hgAppData* ptState);
+void hg_allocate_memory(hgAppData* ptState, const VkMemoryRequirements* requirements, VkMemoryPropertyFlags properties, bool linear, hgAllocation* allocationOut);
+void hg_free_memory(hgAppData* ptState, hgAllocation* allocation);
+void hg_allocate_image_memory(hgAppData* ptState, VkImage image, VkMemoryPropertyFlags properties, hgAllocation* allocationOut);
+
+// memory block helpers
+hgMemoryBlock* hg_create_memory_block(hgAppData* ptState, uint32_t memoryType, VkDeviceSize size, bool linear, bool dedicated);
+void           hg_destroy_memory_block(hgAppData* ptState, hgMemoryBlock* block);
+bool           hg_range_list_allocate(hgRangeList* list, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offsetOut);
+void           hg_range_list_free(hgRangeList* list, VkDeviceSize offset, VkDeviceSize size);
+VkDeviceSize   hg_align_up(VkDeviceSize value, VkDeviceSize alignment);
 
-// one time command helpers
-VkCommandBuffer hg_begin_single_time_commands(hgAppData* ptState);
-void            hg_end_single_time_commands(hgAppData* ptState, VkCommandBuffer cmdBuffer);
+// low level buffer operations
+uint32_t      hg_find_memory_type(hgVulkanContext* context, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+void          hg_create_buffer(hgAppData* ptState, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, hgAllocation* allocation);
+void          hg_destroy_buffer(hgAppData* ptState, VkBuffer* buffer, hgAllocation* allocation);
+void          hg_copy_buffer(hgAppData* ptState, VkBuffer src, VkDeviceSize srcOffset, VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size);
+hgIndexBuffer hg_upload_index_buffer(hgAppData* ptState, const void* indices, uint32_t count, VkIndexType indexType);
+uint32_t      hg_index_size(VkIndexType indexType);
+
+// staging ring
+void hg_create_staging_ring(hgAppData* ptState);
+void hg_destroy_staging_ring(hgAppData* ptState);
+void hg_staging_alloc(hgAppData* ptState, VkDeviceSize size, hgStagingSlice* sliceOut);
+
+// upload batches
+VkCommandBuffer hg_get_upload_cmd_buffer(hgAppData* ptState);
+hgUploadTicket  hg_flush_upload_commands(hgAppData* ptState);
+void            hg_retire_uploads(hgAppData* ptState, bool waitOldest);
+void            hg_defer_staging_free(hgAppData* ptState, hgStagingSlice* slice);
+void            hg_destroy_upload_context(hgAppData* ptState);
+
+// queue family ownership (transfer -> graphics), release is recorded right away and the acquire at submit
+void hg_release_buffer_to_graphics(hgAppData* ptState, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+void hg_release_image_to_graphics(hgAppData* ptState, VkImage image, VkImageSubresourceRange subresourceRange);
 
 // image operations
 void hg_transition_image_layout(VkCommandBuffer cmdBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subresourceRange, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
-void hg_upload_to_image(hgAppData* ptState, VkImage image, const unsigned char* data, int width, int height);
-
-// shader loading
-VkShaderModule hg_create_shader_module(hgAppData* ptState, const char* filename);
 
-// command buffer access
-VkCommandBuffer hg_get_current_frame_cmd_buffer(hgAppData* ptState);
+// read only file mapping
+void* hg_map_file(const char* path, size_t* sizeOut, void** handleOut);
+void  hg_unmap_file(void* data, size_t size, void* handle);
+
+// threading
+#ifdef _WIN32
+typedef SRWLOCK         hgMutex;
+typedef HANDLE          hgThread;
+#define HG_MUTEX_INIT   SRWLOCK_INIT
+#define HG_THREAD_LOCAL __declspec(thread)
+#else
+typedef pthread_mutex_t hgMutex;
+typedef pthread_t       hgThread;
+#define HG_MUTEX_INIT   PTHREAD_MUTEX_INITIALIZER
+#define HG_THREAD_LOCAL __thread
+#endif
+typedef void (*hgThreadFunc)(void* userData);
+
+void     hg_mutex_init(hgMutex* mutex);
+void     hg_mutex_lock(hgMutex* mutex);
+void     hg_mutex_unlock(hgMutex* mutex);
+void     hg_mutex_destroy(hgMutex* mutex);
+bool     hg_thread_start(hgThread* threadOut, hgThreadFunc func, void* userData);
+void     hg_thread_join(hgThread thread);
+uint32_t hg_get_core_count(void);
+
+// shader loading -> modules are cached, callers must not destroy them. cacheLock guards the cache when called from
+// pipeline workers (NULL on a single thread), it is only held for lookups and the insert
+VkShaderModule       hg_create_shader_module(hgAppData* ptState, const char* filename, hgMutex* cacheLock);
+hgShaderModuleEntry* hg_find_shader_entry(hgShaderCache* cache, const char* path);
+void                 hg_destroy_shader_cache(hgAppData* ptState);
+void                 hg_release_stale_shader_modules(hgAppData* ptState); // only when no pipeline build is running
+bool                 hg_resolve_shader_path(const char* filename, char* pathOut, size_t pathSize, struct stat* statOut);
+uint64_t             hg_hash_bytes(const void* data, size_t size);
+
+// shared by all workers of one hg_create_graphics_pipelines call
+typedef struct _hgPipelineBatch
+{
+    hgAppData*        ptState;
+    hgPipelineConfig* atConfigs;
+    hgPipeline*       atPipelines;
+    uint32_t          uCount;
+    uint32_t          uNextJob;   // next config to pick up (guarded by tJobLock)
+    hgMutex           tJobLock;
+    hgMutex           tShaderLock;
+} hgPipelineBatch;
+
+// pipelines -> shaderLock guards the shader cache when called from pipeline workers (NULL on a single thread)
+hgPipeline hg_build_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* config, hgMutex* shaderLock);
+void       hg_pipeline_worker(void* userData);
+
+// pipeline cache (persisted between runs)
+void        hg_create_pipeline_cache(hgAppData* ptState);
+void        hg_save_pipeline_cache(hgAppData* ptState);
+void        hg_destroy_pipeline_cache(hgAppData* ptState);
+const char* hg_get_pipeline_cache_path(hgAppData* ptState);
+bool        hg_is_pipeline_cache_compatible(hgAppData* ptState, const unsigned char* data, size_t size);
+
+// transient allocator
+void hg_create_transient_allocator(hgAppData* ptState);
+void hg_destroy_transient_allocator(hgAppData* ptState);
+void hg_activate_transient_frame(hgAppData* ptState);
+
+// per swapchain image sync objects (recreated with the swapchain)
+void hg_create_image_sync_objects(hgAppData* ptState);
+void hg_destroy_image_sync_objects(hgAppData* ptState);
 
 // depth buffers
 VkFormat hg_find_depth_format(hgAppData* ptState);
 
+// frame pacing
+uint64_t hg_get_time_ns(void);
+void     hg_sleep_until_ns(hgFramePacing* pacing, uint64_t deadlineNs);
+void     hg_apply_frame_pacing(hgAppData* ptState);
+void     hg_destroy_frame_pacing(hgAppData* ptState);
+void     hg_update_frame_latency(hgAppData* ptState, uint32_t frame, uint64_t nowNs);
+
+// readback ring
+void hg_record_readbacks(hgAppData* ptState, VkCommandBuffer cmdBuffer, uint32_t imageIndex);
+void hg_deliver_readbacks(hgAppData* ptState, bool waitAll);
+void hg_destroy_readback_ring(hgAppData* ptState);
+
+// png capture -> pixels are copied out of the readback and encoded on a writer thread
+typedef struct _hgPngJob
+{
+    hgThread       tThread;
+    bool           bRunning;  // thread started and not joined yet
+    bool           bReserved; // claimed by hg_capture_png, its readback hasn't been delivered yet
+    bool           bDone;     // set by the writer thread (guarded by hgPngWriter::tLock)
+    unsigned char* pPixels;
+    uint32_t       uWidth;
+    uint32_t       uHeight;
+    VkFormat       tFormat;
+    char           acPath[256];
+    hgMutex*       ptLock;
+} hgPngJob;
+
+typedef struct _hgPngWriter
+{
+    hgMutex  tLock;
+    hgPngJob atJobs[HG_MAX_PNG_WRITERS];
+} hgPngWriter;
+
+typedef struct _hgPngRequest
+{
+    hgAppData* ptState;
+    hgPngJob*  ptJob;       // reserved up front -> the callback never has to wait for a free writer
+    char       acPath[256];
+} hgPngRequest;
+
+void hg_png_capture_callback(const hgReadbackImage* image, void* userData);
+void hg_png_write_job(void* userData);
+void hg_reap_png_writers(hgAppData* ptState, bool waitAll);
+
+// gpu profiler
+void hg_create_gpu_profiler(hgAppData* ptState);
+void hg_destroy_gpu_profiler(hgAppData* ptState);
+void hg_resolve_gpu_frame(hgAppData* ptState, uint32_t frame);
+void hg_resolve_upload_timestamps(hgAppData* ptState, uint32_t submission);
+void hg_update_gpu_scope_stats(hgAppData* ptState, hgGpuScopeResult* result);
+void hg_reset_gpu_frame(hgAppData* ptState, VkCommandBuffer cmdBuffer);
+
+// instance streams
+void hg_write_instance_data(hgInstanceData* instancesOut, const float* models, const float* colors, uint32_t count);
+
+// bound state tracker
+hgBoundState* hg_get_bound_state(hgAppData* ptState);
+void          hg_reset_bound_state(hgAppData* ptState, uint32_t frame);
+void          hg_track_pipeline_layout(hgBoundState* boundState, VkPipelineLayout layout);
+void          hg_track_index_buffer(hgAppData* ptState, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+
+// geometry pools
+void hg_create_geometry_buffers(hgAppData* ptState, hgGeometryPool* pool);
+void hg_reclaim_geometry_ranges(hgAppData* ptState, hgGeometryPool* pool);
+
+// render queue
+hgRenderQueueEntry* hg_radix_sort_entries(hgRenderQueueEntry* entries, hgRenderQueueEntry* scratch, uint32_t count);
+
+// cpu tracing -> the only global state in the library, scopes have no hgAppData to hang off
+#ifdef HG_ENABLE_TRACE
+typedef struct _hgTraceEvent
+{
+    const char* pcName;
+    uint64_t    uStartNs;
+    uint64_t    uEndNs;
+} hgTraceEvent;
+
+// written by one thread only, handed to the next thread that starts once its owner exits. the events are a ring,
+// event n sits at n % HG_TRACE_EVENTS_PER_THREAD
+typedef struct _hgTraceBuffer
+{
+    hgTraceEvent           atEvents[HG_TRACE_EVENTS_PER_THREAD];
+    volatile uint32_t      uWritten;                         // events ever written, published after the event is written
+    const char*            apcOpenName[HG_TRACE_MAX_DEPTH];
+    uint64_t               auOpenStartNs[HG_TRACE_MAX_DEPTH];
+    uint32_t               uOpenCount;
+    uint32_t               uThreadId;                        // tid in the trace, 0 -> first thread that traced (usually main)
+    bool                   bOwned;                           // a live thread records into it (guarded by gtTraceLock)
+    struct _hgTraceBuffer* ptNext;
+} hgTraceBuffer;
+
+static hgMutex                        gtTraceLock = HG_MUTEX_INIT; // only taken when a thread records its first scope
+static hgTraceBuffer*                 gptTraceBuffers;
+static uint32_t                       guTraceThreadCount;
+static uint64_t                       guTraceStartNs;
+static HG_THREAD_LOCAL hgTraceBuffer* gptThreadTrace;
+
+hgTraceBuffer* hg_trace_acquire_buffer(void);
+void           hg_trace_release_buffer(void);
+#endif
+
+// headless render targets (stand in for swapchain images)
+void hg_create_offscreen_targets(hgAppData* ptState);
+
+// swapchain retirement -> objects of a replaced swapchain live until the frames that used them finished
+void hg_retire_swapchain_resources(hgAppData* ptState, hgRetiredSwapchain* retiredOut);
+void hg_destroy_retired_swapchain(hgAppData* ptState, hgRetiredSwapchain* retired);
+void hg_collect_retired_swapchains(hgAppData* ptState, bool waitAll);
+bool hg_is_frame_complete(hgAppData* ptState, uint64_t frame);
+
 // =============================================================================
 // INITIALIZATION & SETUP (Call once at startup)
 // =============================================================================
@@ -53,6 +273,7 @@ VkFormat hg_find_depth_format(hgAppData* ptState);
 void
 hg_create_instance(hgAppData* ptAppData, const char* pcAppName, uint32_t uAppVersion, bool bEnableValidation)
 {
+    HG_TRACE_BEGIN(__func__);
     VkApplicationInfo tAppInfo = {
         .sType              = VK_STRUCTURE_TYPE_APPLICATION_INFO,
         .pApplicationName   = pcAppName,
@@ -62,9 +283,17 @@ hg_create_instance(hgAppData* ptAppData, const char* pcAppName, uint32_t uAppVer
         .apiVersion         = VK_API_VERSION_1_0,
     };
 
-    // get required extensions from GLFW
+    // get required extensions from GLFW -> headless needs no surface extensions at all
     uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    const char** glfwExtensions = NULL;
+#ifndef HG_NO_GLFW
+    if(!ptAppData->bHeadless)
+    {
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    }
+#else
+    assert(ptAppData->bHeadless && "built with HG_NO_GLFW, only headless mode is available");
+#endif
 
     VkInstanceCreateInfo tCreateInfo = {
         .sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
@@ -82,18 +311,31 @@ hg_create_instance(hgAppData* ptAppData, const char* pcAppName, uint32_t uAppVer
     }
 
     VULKAN_CHECK(vkCreateInstance(&tCreateInfo, NULL, &ptAppData->tContextComponents.tInstance));
+    HG_TRACE_END();
 }
 
 void
 hg_create_surface(hgAppData* ptAppData) 
 {
+    HG_TRACE_BEGIN(__func__);
+    // nothing to present to
+    if(ptAppData->bHeadless)
+    {
+        HG_TRACE_END();
+        return;
+    }
+
+#ifndef HG_NO_GLFW
     // GLFW handles platform specific surface creation
     VULKAN_CHECK(glfwCreateWindowSurface(ptAppData->tContextComponents.tInstance, ptAppData->pWindow, NULL, &ptAppData->tSwapchainComponents.tSurface));
+#endif
+    HG_TRACE_END();
 }
 
 void 
 hg_pick_physical_device(hgAppData* ptAppData) 
 {
+    HG_TRACE_BEGIN(__func__);
     uint32_t uDeviceCount = 0;
     vkEnumeratePhysicalDevices(ptAppData->tContextComponents.tInstance, &uDeviceCount, NULL);
     assert(uDeviceCount > 0);
@@ -103,13 +345,16 @@ hg_pick_physical_device(hgAppData* ptAppData)
 
     // just pick the first gpu
     ptAppData->tContextComponents.tPhysicalDevice = ptDevices[0];
+    vkGetPhysicalDeviceProperties(ptAppData->tContextComponents.tPhysicalDevice, &ptAppData->tContextComponents.tDeviceProperties);
 
     free(ptDevices);
+    HG_TRACE_END();
 }
 
 void 
 hg_create_logical_device(hgAppData* ptAppData) 
 {
+    HG_TRACE_BEGIN(__func__);
     // find queue family that supports graphics and presentation
     uint32_t uQueueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(ptAppData->tContextComponents.tPhysicalDevice, &uQueueFamilyCount, NULL);
@@ -122,8 +367,12 @@ hg_create_logical_device(hgAppData* ptAppData)
     {
         if(pQueueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) 
         {
-            VkBool32 bPresentSupport = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(ptAppData->tContextComponents.tPhysicalDevice, i, ptAppData->tSwapchainComponents.tSurface, &bPresentSupport);
+            // headless -> any graphics family will do
+            VkBool32 bPresentSupport = ptAppData->bHeadless;
+            if(!ptAppData->bHeadless)
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(ptAppData->tContextComponents.tPhysicalDevice, i, ptAppData->tSwapchainComponents.tSurface, &bPresentSupport);
+            }
             if(bPresentSupport) 
             {
                 ptAppData->tContextComponents.tGraphicsQueueFamily = i;
@@ -133,32 +382,93 @@ hg_create_logical_device(hgAppData* ptAppData)
     }
     assert(ptAppData->tContextComponents.tGraphicsQueueFamily != UINT32_MAX);
 
+    // find transfer-only queue family (dma engine) -> uploads run next to rendering instead of in between
+    ptAppData->tContextComponents.tTransferQueueFamily = ptAppData->tContextComponents.tGraphicsQueueFamily;
+    for(uint32_t i = 0; i < uQueueFamilyCount; i++) 
+    {
+        VkQueueFlags tFlags = pQueueFamilies[i].queueFlags;
+        if((tFlags & VK_QUEUE_TRANSFER_BIT) && !(tFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) 
+        {
+            ptAppData->tContextComponents.tTransferQueueFamily = i;
+            break;
+        }
+    }
+    bool bSeparateTransfer = ptAppData->tContextComponents.tTransferQueueFamily != ptAppData->tContextComponents.tGraphicsQueueFamily;
+
     free(pQueueFamilies);
 
     float fQueuePriority = 1.0f;
-    VkDeviceQueueCreateInfo tQueueCreateInfo = {
-        .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-        .queueFamilyIndex = ptAppData->tContextComponents.tGraphicsQueueFamily,
-        .queueCount       = 1,
-        .pQueuePriorities = &fQueuePriority
+    VkDeviceQueueCreateInfo atQueueCreateInfos[2] = {
+        {
+            .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = ptAppData->tContextComponents.tGraphicsQueueFamily,
+            .queueCount       = 1,
+            .pQueuePriorities = &fQueuePriority
+        },
+        {
+            .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+            .queueFamilyIndex = ptAppData->tContextComponents.tTransferQueueFamily,
+            .queueCount       = 1,
+            .pQueuePriorities = &fQueuePriority
+        }
     };
 
-    const char* deviceExtensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // optional draw features -> turned on when the device has them, the draw functions fall back otherwise
+    // (fullDrawIndexUint32 lifts maxDrawIndexedIndexValue from 2^24 - 1 to the full 32 bit range)
+    VkPhysicalDeviceFeatures tSupportedFeatures;
+    vkGetPhysicalDeviceFeatures(ptAppData->tContextComponents.tPhysicalDevice, &tSupportedFeatures);
+    VkPhysicalDeviceFeatures* ptEnabledFeatures = &ptAppData->tContextComponents.tEnabledFeatures;
+    memset(ptEnabledFeatures, 0, sizeof(VkPhysicalDeviceFeatures));
+    ptEnabledFeatures->multiDrawIndirect         = tSupportedFeatures.multiDrawIndirect;
+    ptEnabledFeatures->drawIndirectFirstInstance = tSupportedFeatures.drawIndirectFirstInstance;
+    ptEnabledFeatures->fullDrawIndexUint32       = tSupportedFeatures.fullDrawIndexUint32;
+
+    uint32_t uAvailableExtensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(ptAppData->tContextComponents.tPhysicalDevice, NULL, &uAvailableExtensionCount, NULL);
+    VkExtensionProperties* atAvailableExtensions = malloc(uAvailableExtensionCount * sizeof(VkExtensionProperties));
+    vkEnumerateDeviceExtensionProperties(ptAppData->tContextComponents.tPhysicalDevice, NULL, &uAvailableExtensionCount, atAvailableExtensions);
+    bool bDrawIndirectCount = false;
+    for(uint32_t i = 0; i < uAvailableExtensionCount; i++)
+    {
+        if(strcmp(atAvailableExtensions[i].extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0) bDrawIndirectCount = true;
+    }
+    free(atAvailableExtensions);
+
+    const char* deviceExtensions[2];
+    uint32_t    uDeviceExtensionCount = 0;
+    if(!ptAppData->bHeadless) deviceExtensions[uDeviceExtensionCount++] = VK_KHR_SWAPCHAIN_EXTENSION_NAME; // no swapchain without a surface
+    if(bDrawIndirectCount)    deviceExtensions[uDeviceExtensionCount++] = VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+
     VkDeviceCreateInfo tDeviceCreateInfo = {
         .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .queueCreateInfoCount    = 1,
-        .pQueueCreateInfos       = &tQueueCreateInfo,
-        .enabledExtensionCount   = 1,
-        .ppEnabledExtensionNames = deviceExtensions
+        .queueCreateInfoCount    = bSeparateTransfer ? 2 : 1,
+        .pQueueCreateInfos       = atQueueCreateInfos,
+        .enabledExtensionCount   = uDeviceExtensionCount,
+        .ppEnabledExtensionNames = deviceExtensions,
+        .pEnabledFeatures        = ptEnabledFeatures
     };
 
     VULKAN_CHECK(vkCreateDevice(ptAppData->tContextComponents.tPhysicalDevice, &tDeviceCreateInfo, NULL, &ptAppData->tContextComponents.tDevice));
+    ptAppData->tContextComponents.pfnCmdDrawIndexedIndirectCount = bDrawIndirectCount ?
+        (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(ptAppData->tContextComponents.tDevice, "vkCmdDrawIndexedIndirectCountKHR") : NULL;
     vkGetDeviceQueue(ptAppData->tContextComponents.tDevice, ptAppData->tContextComponents.tGraphicsQueueFamily, 0, &ptAppData->tContextComponents.tGraphicsQueue);
+    vkGetDeviceQueue(ptAppData->tContextComponents.tDevice, ptAppData->tContextComponents.tTransferQueueFamily, 0, &ptAppData->tContextComponents.tTransferQueue);
+
+    // every resource goes through the allocator so it has to exist as soon as the device does
+    hg_init_allocator(ptAppData);
+
+    // warm pipeline cache from the last run -> pipelines skip the spir-v compile when the driver recognises them
+    hg_create_pipeline_cache(ptAppData);
+
+    // timestamp query pools (only with hgAppData::bGpuProfiling)
+    hg_create_gpu_profiler(ptAppData);
+    HG_TRACE_END();
 }
 
 void 
 hg_create_command_pool(hgAppData* ptAppData) 
 {
+    HG_TRACE_BEGIN(__func__);
     VkCommandPoolCreateInfo tPoolInfo = {
         .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
         .flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
@@ -166,11 +476,17 @@ hg_create_command_pool(hgAppData* ptAppData)
     };
 
     VULKAN_CHECK(vkCreateCommandPool(ptAppData->tContextComponents.tDevice, &tPoolInfo, NULL, &ptAppData->tCommandComponents.tCommandPool));
+
+    // uploads get their own pool (same family as above when there is no transfer-only queue)
+    tPoolInfo.queueFamilyIndex = ptAppData->tContextComponents.tTransferQueueFamily;
+    VULKAN_CHECK(vkCreateCommandPool(ptAppData->tContextComponents.tDevice, &tPoolInfo, NULL, &ptAppData->tCommandComponents.tTransferCommandPool));
+    HG_TRACE_END();
 }
 
 void 
 hg_create_sync_objects(hgAppData* ptAppData) 
 {
+    HG_TRACE_BEGIN(__func__);
     VkSemaphoreCreateInfo tSemaphoreInfo = {
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
     };
@@ -180,24 +496,32 @@ hg_create_sync_objects(hgAppData* ptAppData)
         .flags = VK_FENCE_CREATE_SIGNALED_BIT
     };
 
-    VULKAN_CHECK(vkCreateSemaphore(ptAppData->tContextComponents.tDevice, &tSemaphoreInfo, NULL, &ptAppData->tSyncComponents.tImageAvailable));
-    VULKAN_CHECK(vkCreateSemaphore(ptAppData->tContextComponents.tDevice, &tSemaphoreInfo, NULL, &ptAppData->tSyncComponents.tRenderFinished));
-    VULKAN_CHECK(vkCreateFence(ptAppData->tContextComponents.tDevice, &tFenceInfo, NULL, &ptAppData->tSyncComponents.tInFlight));
+    // fences start signaled so the first wait on each frame returns right away
+    for(uint32_t i = 0; i < hg_get_frames_in_flight(ptAppData); i++)
+    {
+        VULKAN_CHECK(vkCreateSemaphore(ptAppData->tContextComponents.tDevice, &tSemaphoreInfo, NULL, &ptAppData->tSyncComponents.tImageAvailable[i]));
+        VULKAN_CHECK(vkCreateFence(ptAppData->tContextComponents.tDevice, &tFenceInfo, NULL, &ptAppData->tSyncComponents.tInFlight[i]));
+    }
+    ptAppData->tSyncComponents.uCurrentFrame = 0;
+
+    // needs the swapchain -> create it first
+    hg_create_image_sync_objects(ptAppData);
+    HG_TRACE_END();
 }
 
-// specific to frame command buffers only -> used on swapchain recreation as well
+// one command buffer per frame in flight, these survive swapchain recreation
 void 
 hg_allocate_frame_cmd_buffers(hgAppData* ptState)
 {
-    ptState->tCommandComponents.tCommandBuffers = malloc(ptState->tSwapchainComponents.uSwapchainImageCount * sizeof(VkCommandBuffer));
-
+    HG_TRACE_BEGIN(__func__);
     VkCommandBufferAllocateInfo tAllocInfo = {
         .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .commandPool        = ptState->tCommandComponents.tCommandPool,
         .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = ptState->tSwapchainComponents.uSwapchainImageCount
+        .commandBufferCount = hg_get_frames_in_flight(ptState)
     };
     VULKAN_CHECK(vkAllocateCommandBuffers(ptState->tContextComponents.tDevice, &tAllocInfo, ptState->tCommandComponents.tCommandBuffers));
+    HG_TRACE_END();
 }
 
 // =============================================================================
@@ -207,6 +531,16 @@ hg_allocate_frame_cmd_buffers(hgAppData* ptState)
 void
 hg_create_swapchain(hgAppData* ptAppData, VkPresentModeKHR tPreferredPresentMode)
 {
+    HG_TRACE_BEGIN(__func__);
+    // headless -> plain images stand in for the swapchain images, everything downstream stays the same
+    if(ptAppData->bHeadless)
+    {
+        ptAppData->tSwapchainComponents.tPresentMode = tPreferredPresentMode;
+        hg_create_offscreen_targets(ptAppData);
+        HG_TRACE_END();
+        return;
+    }
+
     // get surface capabilities
     VkSurfaceCapabilitiesKHR tCapabilities;
     VULKAN_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(ptAppData->tContextComponents.tPhysicalDevice, ptAppData->tSwapchainComponents.tSurface, &tCapabilities));
@@ -245,23 +579,17 @@ hg_create_swapchain(hgAppData* ptAppData, VkPresentModeKHR tPreferredPresentMode
         ptAppData->tSwapchainComponents.tExtent = tActualExtent;
     }
 
-    // choose image count
-    uint32_t uImageCount = tCapabilities.minImageCount + 1;
-    if(tCapabilities.maxImageCount > 0 && uImageCount > tCapabilities.maxImageCount) 
-    {
-        uImageCount = tCapabilities.maxImageCount;
-    }
-
     // see if requested mode is available
     uint32_t uPresentModeCount;
     vkGetPhysicalDeviceSurfacePresentModesKHR(ptAppData->tContextComponents.tPhysicalDevice, 
         ptAppData->tSwapchainComponents.tSurface, &uPresentModeCount, NULL);
 
     VkPresentModeKHR pPresentModes[8];  // 8 is more than enough
+    if(uPresentModeCount > 8) uPresentModeCount = 8;
     vkGetPhysicalDeviceSurfacePresentModesKHR(ptAppData->tContextComponents.tPhysicalDevice, 
         ptAppData->tSwapchainComponents.tSurface, &uPresentModeCount, pPresentModes);
 
-    // FIFO as the default
+    // FIFO as the default (always supported)
     VkPresentModeKHR tSelectedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
     for(uint32_t i = 0; i < uPresentModeCount; i++) 
     {
@@ -272,6 +600,31 @@ hg_create_swapchain(hgAppData* ptAppData, VkPresentModeKHR tPreferredPresentMode
         }
     }
 
+    // remembered so recreation (resize) comes back with the same behaviour
+    ptAppData->tSwapchainComponents.tPresentMode         = tPreferredPresentMode;
+    ptAppData->tSwapchainComponents.tActivePresentMode   = tSelectedPresentMode;
+    ptAppData->tSwapchainComponents.uRequestedImageCount = ptAppData->uSwapchainImageCount;
+
+    // choose image count -> mailbox needs a spare image to replace without blocking, fewer images means less queued latency
+    uint32_t uImageCount = ptAppData->uSwapchainImageCount;
+    if(uImageCount == 0)
+    {
+        uImageCount = tCapabilities.minImageCount + 1;
+        if(tSelectedPresentMode == VK_PRESENT_MODE_MAILBOX_KHR && uImageCount < 3) uImageCount = 3;
+    }
+    if(uImageCount < tCapabilities.minImageCount) 
+    {
+        uImageCount = tCapabilities.minImageCount;
+    }
+    if(tCapabilities.maxImageCount > 0 && uImageCount > tCapabilities.maxImageCount) 
+    {
+        uImageCount = tCapabilities.maxImageCount;
+    }
+
+    // transfer src lets readbacks copy straight out of the swapchain image (practically always supported)
+    ptAppData->tSwapchainComponents.tImageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | 
+        (tCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
     // create swapchain
     VkSwapchainCreateInfoKHR tCreateInfo = {
         .sType            = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
@@ -281,12 +634,13 @@ hg_create_swapchain(hgAppData* ptAppData, VkPresentModeKHR tPreferredPresentMode
         .imageColorSpace  = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR,
         .imageExtent      = ptAppData->tSwapchainComponents.tExtent,
         .imageArrayLayers = 1,
-        .imageUsage       = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageUsage       = ptAppData->tSwapchainComponents.tImageUsage,
         .imageSharingMode = VK_SHARING_MODE_EXCLUSIVE,
         .preTransform     = tCapabilities.currentTransform,
         .compositeAlpha   = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
         .presentMode      = tSelectedPresentMode,
-        .clipped          = VK_TRUE
+        .clipped          = VK_TRUE,
+        .oldSwapchain     = ptAppData->tSwapchainComponents.tSwapchain // lets the driver hand resources over on recreation
     };
     VULKAN_CHECK(vkCreateSwapchainKHR(ptAppData->tContextComponents.tDevice, &tCreateInfo, NULL, &ptAppData->tSwapchainComponents.tSwapchain));
 
@@ -321,11 +675,13 @@ hg_create_swapchain(hgAppData* ptAppData, VkPresentModeKHR tPreferredPresentMode
         VULKAN_CHECK(vkCreateImageView(ptAppData->tContextComponents.tDevice, &tViewCreateInfo, NULL, &ptAppData->tSwapchainComponents.tSwapchainImageViews[i]));
     }
     free(pFormats);
+    HG_TRACE_END();
 }
 
 void 
 hg_create_render_pass(hgAppData* ptState, hgRenderPassConfig* ptConfig)
 {
+    HG_TRACE_BEGIN(__func__);
     // set clear color from config
     memcpy(ptState->tPipelineComponents.afClearColor, &ptConfig->afClearColor, sizeof(float) * 4);
 
@@ -345,7 +701,7 @@ hg_create_render_pass(hgAppData* ptState, hgRenderPassConfig* ptConfig)
         .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
         .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+        .finalLayout    = ptState->bHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR // headless images get read back instead
     };
     // depth attachment 
     VkAttachmentDescription tDepthAttachment = {
@@ -387,11 +743,13 @@ hg_create_render_pass(hgAppData* ptState, hgRenderPassConfig* ptConfig)
         .pSubpasses      = &tSubpass
     };
     VULKAN_CHECK(vkCreateRenderPass(ptState->tContextComponents.tDevice, &tRenderPassInfo, NULL, &ptState->tPipelineComponents.tRenderPass));
+    HG_TRACE_END();
 }
 
 void 
 hg_create_framebuffers(hgAppData* ptState) 
 {
+    HG_TRACE_BEGIN(__func__);
     ptState->tPipelineComponents.tFramebuffers = malloc(ptState->tSwapchainComponents.uSwapchainImageCount * sizeof(VkFramebuffer));
 
     for(uint32_t i = 0; i < ptState->tSwapchainComponents.uSwapchainImageCount; i++) 
@@ -428,45 +786,61 @@ hg_create_framebuffers(hgAppData* ptState)
         };
         VULKAN_CHECK(vkCreateFramebuffer(ptState->tContextComponents.tDevice, &framebufferInfo, NULL, &ptState->tPipelineComponents.tFramebuffers[i]));
     }
+    HG_TRACE_END();
 }
 
-void hg_recreate_swapchain(hgAppData* ptState)
+void 
+hg_recreate_swapchain(hgAppData* ptState)
 {
-    // wait for device to be idle
-    vkDeviceWaitIdle(ptState->tContextComponents.tDevice);
-
-    // cleanup old swapchain resources 
-    hg_cleanup_swapchain_resources(ptState);
-
-    // get new window dimensions
-    int iNewWidth = 0, iNewHeight = 0;
-    glfwGetFramebufferSize(ptState->pWindow, &iNewWidth, &iNewHeight);
-    while (iNewWidth == 0 || iNewHeight == 0) 
+    HG_TRACE_BEGIN(__func__);
+    // minimized -> nothing to present to, sleep until the window has a size again
+    // (headless targets are resized by changing width/height and calling this directly)
+#ifndef HG_NO_GLFW
+    if(!ptState->bHeadless)
     {
+        int iNewWidth = 0, iNewHeight = 0;
         glfwGetFramebufferSize(ptState->pWindow, &iNewWidth, &iNewHeight);
-        glfwWaitEvents();
+        while (iNewWidth == 0 || iNewHeight == 0) 
+        {
+            glfwWaitEvents();
+            glfwGetFramebufferSize(ptState->pWindow, &iNewWidth, &iNewHeight);
+        }
+        ptState->width  = iNewWidth;
+        ptState->height = iNewHeight;
+    }
+#endif
+
+    // frames in flight may still render to the old images, so instead of waiting for the device the old
+    // objects are parked until the fences of those frames signal (hg_collect_retired_swapchains)
+    hgSwapchain* ptSwapchain = &ptState->tSwapchainComponents;
+    if(ptSwapchain->uRetiredCount == HG_MAX_RETIRED_SWAPCHAINS)
+    {
+        hg_collect_retired_swapchains(ptState, true); // resized faster than frames complete
     }
+    hgRetiredSwapchain* ptRetired = &ptSwapchain->atRetired[ptSwapchain->uRetiredCount++];
+    hg_retire_swapchain_resources(ptState, ptRetired);
 
-    // recreate swapchain with new size
-    hg_create_swapchain(ptState, VK_PRESENT_MODE_FIFO_KHR); // TODO: pass in VkPresentModeKHR that was set in config struct
+    // the old handle stays in tSwapchain so hg_create_swapchain passes it as oldSwapchain, it's retired afterwards
+    VkSwapchainKHR tOldSwapchain = ptSwapchain->tSwapchain;
+    hg_create_swapchain(ptState, ptSwapchain->tPresentMode);
+    ptRetired->tSwapchain       = tOldSwapchain;
+    ptSwapchain->bNeedsRecreate = false;
 
     if (ptState->bDepthEnabled) // recreate depth resources if depth is enabled
     {
         hg_create_depth_resources(ptState);
     }
 
-    // recreate framebuffers & frame command buffers
+    // recreate framebuffers & per image sync (image count may have changed), frame command buffers are kept
     hg_create_framebuffers(ptState);
-    hg_allocate_frame_cmd_buffers(ptState);
-
-    // Update state with new dimensions
-    ptState->width  = iNewWidth;
-    ptState->height = iNewHeight;
+    hg_create_image_sync_objects(ptState);
+    HG_TRACE_END();
 }
 
 void
 hg_create_depth_resources(hgAppData* ptState)
 {
+    HG_TRACE_BEGIN(__func__);
     // find supported format
     VkFormat tDepthFormat = hg_find_depth_format(ptState);
     ptState->tPipelineComponents.tDepthFormat = tDepthFormat;
@@ -492,16 +866,7 @@ hg_create_depth_resources(hgAppData* ptState)
     VULKAN_CHECK(vkCreateImage(ptState->tContextComponents.tDevice, &tImageInfo, NULL, &ptState->tPipelineComponents.tDepthImage));
 
     // allocate memory for depth image
-    VkMemoryRequirements tMemRequirements;
-    vkGetImageMemoryRequirements(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tDepthImage, &tMemRequirements);
-
-    VkMemoryAllocateInfo tAllocInfo = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize  = tMemRequirements.size,
-        .memoryTypeIndex = hg_find_memory_type(&ptState->tContextComponents, tMemRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-    };
-    VULKAN_CHECK(vkAllocateMemory(ptState->tContextComponents.tDevice, &tAllocInfo, NULL, &ptState->tPipelineComponents.tDepthMemory));
-    VULKAN_CHECK(vkBindImageMemory(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tDepthImage, ptState->tPipelineComponents.tDepthMemory, 0));
+    hg_allocate_image_memory(ptState, ptState->tPipelineComponents.tDepthImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &ptState->tPipelineComponents.tDepthAllocation);
 
     // create image view
     VkImageViewCreateInfo tViewInfo = {
@@ -518,6 +883,7 @@ hg_create_depth_resources(hgAppData* ptState)
         }
     };
     VULKAN_CHECK(vkCreateImageView(ptState->tContextComponents.tDevice, &tViewInfo, NULL, &ptState->tPipelineComponents.tDepthImageView));
+    HG_TRACE_END();
 }
 
 // =============================================================================
@@ -530,92 +896,215 @@ hg_create_depth_resources(hgAppData* ptState)
 hgVertexBuffer 
 hg_create_static_vertex_buffer(hgAppData* ptAppData, void* data, size_t size, size_t stride)
 {
+    HG_TRACE_BEGIN(__func__);
     hgVertexBuffer tNewBuffer = {0};
 
     tNewBuffer.szSize = size;
     tNewBuffer.uVertexCount = size / stride;
 
-    // create staging buffer
-    VkBuffer tStagingBuffer;
-    VkDeviceMemory tStagingMemory;
-    hg_create_buffer(&ptAppData->tContextComponents, (VkDeviceSize)size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &tStagingBuffer, &tStagingMemory);
-
-    // map and copy data
-    void* pMapped;
-    vkMapMemory(ptAppData->tContextComponents.tDevice, tStagingMemory, 0, size, 0, &pMapped);
-    memcpy(pMapped, data, size);
-    vkUnmapMemory(ptAppData->tContextComponents.tDevice, tStagingMemory);
-
     // create device local buffer
-    hg_create_buffer(&ptAppData->tContextComponents, (VkDeviceSize)size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tMemory);
-
-    // copy staging to device
-    hg_copy_buffer(&ptAppData->tContextComponents, &ptAppData->tCommandComponents, 
-        tStagingBuffer, tNewBuffer.tBuffer, size);
+    hg_create_buffer(ptAppData, (VkDeviceSize)size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tAllocation);
 
-    // cleanup staging
-    vkDestroyBuffer(ptAppData->tContextComponents.tDevice, tStagingBuffer, NULL);
-    vkFreeMemory(ptAppData->tContextComponents.tDevice, tStagingMemory, NULL);
+    // copy through the staging ring -> outside of a batch this waits for the copy
+    bool bImplicitBatch = !ptAppData->tUploadComponents.bBatchOpen;
+    if(bImplicitBatch) hg_begin_upload_batch(ptAppData);
+    hg_enqueue_buffer_upload(ptAppData, tNewBuffer.tBuffer, 0, data, (VkDeviceSize)size);
+    if(bImplicitBatch) hg_wait_for_upload(ptAppData, hg_submit_upload_batch(ptAppData));
 
+    HG_TRACE_END();
     return tNewBuffer;
 }
 
 hgVertexBuffer 
 hg_create_dynamic_vertex_buffer(hgAppData* ptState, void* pData, size_t szSize, size_t szStride)
 {
+    HG_TRACE_BEGIN(__func__);
     hgVertexBuffer tNewBuffer = {0};
 
     tNewBuffer.szSize = szSize;
     tNewBuffer.uVertexCount = szSize / szStride;
 
     // create host-visible vertex buffer 
-    hg_create_buffer(&ptState->tContextComponents, (VkDeviceSize)szSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tMemory);
+    hg_create_buffer(ptState, (VkDeviceSize)szSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tAllocation);
 
-    // map memory once and keep it mapped
-    vkMapMemory(ptState->tContextComponents.tDevice, tNewBuffer.tMemory, 0, szSize, 0, &tNewBuffer.pDataMapped);
+    // host visible blocks are mapped once by the allocator and stay mapped
+    tNewBuffer.pDataMapped = tNewBuffer.tAllocation.pMapped;
     // copy initial data
     memcpy(tNewBuffer.pDataMapped, pData, szSize);
 
+    HG_TRACE_END();
     return tNewBuffer;
 }
 
 hgIndexBuffer 
 hg_create_index_buffer(hgAppData* ptAppData, uint16_t* indices, uint32_t count)
 {
-    hgIndexBuffer tNewBuffer = {0};
+    HG_TRACE_BEGIN(__func__);
+    hgIndexBuffer tNewBuffer = hg_upload_index_buffer(ptAppData, indices, count, VK_INDEX_TYPE_UINT16);
+    HG_TRACE_END();
+    return tNewBuffer;
+}
 
-    size_t szSize = sizeof(uint16_t) * count;
-    tNewBuffer.szSize = szSize;
-    tNewBuffer.uIndexCount = count;
+hgIndexBuffer
+hg_create_index_buffer_32(hgAppData* ptState, const uint32_t* auIndices, uint32_t uCount)
+{
+    HG_TRACE_BEGIN(__func__);
+    uint32_t uMaxIndex = 0;
+    for(uint32_t i = 0; i < uCount; i++)
+    {
+        if(auIndices[i] > uMaxIndex) uMaxIndex = auIndices[i];
+    }
+
+    // 0xffff is kept out of 16 bit buffers, it would turn into a restart should a pipeline enable primitive restart
+    hgIndexBuffer tNewBuffer;
+    if(uMaxIndex < UINT16_MAX)
+    {
+        uint16_t* auNarrowed = malloc(sizeof(uint16_t) * uCount);
+        for(uint32_t i = 0; i < uCount; i++) auNarrowed[i] = (uint16_t)auIndices[i];
+
+        // the staging ring copies the data right away, so the narrowed copy can go immediately
+        tNewBuffer = hg_upload_index_buffer(ptState, auNarrowed, uCount, VK_INDEX_TYPE_UINT16);
+        free(auNarrowed);
+    }
+    else
+    {
+        uint32_t uMaxIndexValue = ptState->tContextComponents.tDeviceProperties.limits.maxDrawIndexedIndexValue;
+        if(uMaxIndex > uMaxIndexValue)
+        {
+            printf("Index %u exceeds maxDrawIndexedIndexValue (%u)!\n", uMaxIndex, uMaxIndexValue);
+            exit(1);
+        }
+        tNewBuffer = hg_upload_index_buffer(ptState, auIndices, uCount, VK_INDEX_TYPE_UINT32);
+    }
+
+    HG_TRACE_END();
+    return tNewBuffer;
+}
 
-    // create staging buffer
-    VkBuffer tStagingBuffer;
-    VkDeviceMemory tStagingMemory;
-    hg_create_buffer(&ptAppData->tContextComponents, (VkDeviceSize)szSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &tStagingBuffer, &tStagingMemory);
+// -------------------------------
+// uploads
+// -------------------------------
+void
+hg_begin_upload_batch(hgAppData* ptState)
+{
+    assert(!ptState->tUploadComponents.bBatchOpen && "upload batch already open");
+    ptState->tUploadComponents.bBatchOpen = true;
+}
 
-    // map and copy
-    void* pMapped;
-    vkMapMemory(ptAppData->tContextComponents.tDevice, tStagingMemory, 0, szSize, 0, &pMapped);
-    memcpy(pMapped, indices, szSize);
-    vkUnmapMemory(ptAppData->tContextComponents.tDevice, tStagingMemory);
+void
+hg_enqueue_buffer_upload(hgAppData* ptState, VkBuffer tDstBuffer, VkDeviceSize tDstOffset, const void* pData, VkDeviceSize tSize)
+{
+    HG_TRACE_BEGIN(__func__);
+    assert(ptState->tUploadComponents.bBatchOpen && "hg_begin_upload_batch() first");
 
-    // create device buffer
-    hg_create_buffer(&ptAppData->tContextComponents, (VkDeviceSize)szSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tMemory);
+    hgStagingSlice tStaging;
+    hg_staging_alloc(ptState, tSize, &tStaging);
+    memcpy(tStaging.pData, pData, (size_t)tSize);
 
-    // copy
-    hg_copy_buffer(&ptAppData->tContextComponents, &ptAppData->tCommandComponents, 
-        tStagingBuffer, tNewBuffer.tBuffer, szSize);
+    hg_copy_buffer(ptState, tStaging.tBuffer, tStaging.tOffset, tDstBuffer, tDstOffset, tSize);
+    hg_defer_staging_free(ptState, &tStaging);
 
-    // cleanup staging
-    vkDestroyBuffer(ptAppData->tContextComponents.tDevice, tStagingBuffer, NULL);
-    vkFreeMemory(ptAppData->tContextComponents.tDevice, tStagingMemory, NULL);
+    // hand the range over to the graphics queue when the copy ran on the transfer queue
+    hg_release_buffer_to_graphics(ptState, tDstBuffer, tDstOffset, tSize);
+    HG_TRACE_END();
+}
 
-    return tNewBuffer;
+void
+hg_enqueue_image_upload(hgAppData* ptState, VkImage tImage, const void* pData, uint32_t uWidth, uint32_t uHeight)
+{
+    HG_TRACE_BEGIN(__func__);
+    assert(ptState->tUploadComponents.bBatchOpen && "hg_begin_upload_batch() first");
+
+    VkDeviceSize tImageSize = (VkDeviceSize)uWidth * uHeight * 4; // RGBA8
+
+    // copy data into the staging ring
+    hgStagingSlice tStaging;
+    hg_staging_alloc(ptState, tImageSize, &tStaging);
+    memcpy(tStaging.pData, pData, (size_t)tImageSize);
+
+    VkCommandBuffer tCmdBuffer = hg_get_upload_cmd_buffer(ptState);
+
+    // transition to transfer dst
+    VkImageSubresourceRange tSubResRan = {
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = 0,
+        .levelCount     = 1,
+        .baseArrayLayer = 0,
+        .layerCount     = 1
+    };
+
+    hg_transition_image_layout(tCmdBuffer, tImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
+        tSubResRan, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    // copy buffer to image
+    VkBufferImageCopy tRegion = {
+        .bufferOffset       = tStaging.tOffset,
+        .bufferRowLength    = 0,
+        .bufferImageHeight  = 0,
+        .imageSubresource   = {
+            .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel       = 0,
+            .baseArrayLayer = 0,
+            .layerCount     = 1
+        },
+        .imageOffset        = {0, 0, 0},
+        .imageExtent        = {uWidth, uHeight, 1}
+    };
+    vkCmdCopyBufferToImage(tCmdBuffer, tStaging.tBuffer, tImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &tRegion);
+
+    // transition to shader read -> a transfer queue can't do that for the fragment stage, there the transition
+    // becomes part of the ownership transfer to the graphics queue
+    if(ptState->tContextComponents.tTransferQueueFamily != ptState->tContextComponents.tGraphicsQueueFamily)
+    {
+        hg_release_image_to_graphics(ptState, tImage, tSubResRan);
+    }
+    else
+    {
+        hg_transition_image_layout(tCmdBuffer, tImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 
+            tSubResRan, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+
+    hg_defer_staging_free(ptState, &tStaging);
+    HG_TRACE_END();
+}
+
+hgUploadTicket
+hg_submit_upload_batch(hgAppData* ptState)
+{
+    HG_TRACE_BEGIN(__func__);
+    assert(ptState->tUploadComponents.bBatchOpen && "no upload batch open");
+
+    hgUploadTicket uTicket = hg_flush_upload_commands(ptState);
+    ptState->tUploadComponents.bBatchOpen = false;
+    HG_TRACE_END();
+    return uTicket;
+}
+
+bool
+hg_is_upload_complete(hgAppData* ptState, hgUploadTicket uTicket)
+{
+    hgUploadContext* ptUpload = &ptState->tUploadComponents;
+    if(uTicket <= ptUpload->uCompletedTicket) return true;
+
+    hg_retire_uploads(ptState, false);
+    return uTicket <= ptUpload->uCompletedTicket;
+}
+
+void
+hg_wait_for_upload(hgAppData* ptState, hgUploadTicket uTicket)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgUploadContext* ptUpload = &ptState->tUploadComponents;
+    assert(uTicket <= ptUpload->uLastTicket && "ticket was never submitted");
+
+    // submissions finish in order so waiting on the oldest until we get there is enough
+    while(uTicket > ptUpload->uCompletedTicket && ptUpload->uSubmissionCount > 0)
+    {
+        hg_retire_uploads(ptState, true);
+    }
+    HG_TRACE_END();
 }
 
 // -------------------------------
@@ -624,13 +1113,17 @@ hg_create_index_buffer(hgAppData* ptAppData, uint16_t* indices, uint32_t count)
 unsigned char*
 hg_load_texture_data(const char* pcFileName, int* iWidthOut, int* iHeightOut)
 {
+    HG_TRACE_BEGIN(__func__);
     int iComponentsInFile = 0;
-    return stbi_load(pcFileName, iWidthOut, iHeightOut, &iComponentsInFile, 4);
+    unsigned char* pucData = stbi_load(pcFileName, iWidthOut, iHeightOut, &iComponentsInFile, 4);
+    HG_TRACE_END();
+    return pucData;
 }
 
 hgTexture 
 hg_create_texture(hgAppData* ptAppData, const unsigned char* pucData, int iWidth, int iHeight)
 {
+    HG_TRACE_BEGIN(__func__);
     hgTexture tTexture = {0};
     tTexture.iWidth    = iWidth;
     tTexture.iHeight   = iHeight;
@@ -652,19 +1145,13 @@ hg_create_texture(hgAppData* ptAppData, const unsigned char* pucData, int iWidth
     VULKAN_CHECK(vkCreateImage(ptAppData->tContextComponents.tDevice, &tImageInfo, NULL, &tTexture.tImage));
 
     // allocate memory
-    VkMemoryRequirements tMemRequirements;
-    vkGetImageMemoryRequirements(ptAppData->tContextComponents.tDevice, tTexture.tImage, &tMemRequirements);
-
-    VkMemoryAllocateInfo tAllocInfo = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize  = tMemRequirements.size,
-        .memoryTypeIndex = hg_find_memory_type(&ptAppData->tContextComponents, tMemRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-    };
-    VULKAN_CHECK(vkAllocateMemory(ptAppData->tContextComponents.tDevice, &tAllocInfo, NULL, &tTexture.tMemory));
-    VULKAN_CHECK(vkBindImageMemory(ptAppData->tContextComponents.tDevice, tTexture.tImage, tTexture.tMemory, 0));
+    hg_allocate_image_memory(ptAppData, tTexture.tImage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tTexture.tAllocation);
 
     // upload texture data (using staging buffer)
-    hg_upload_to_image(ptAppData, tTexture.tImage, pucData, iWidth, iHeight);
+    bool bImplicitBatch = !ptAppData->tUploadComponents.bBatchOpen;
+    if(bImplicitBatch) hg_begin_upload_batch(ptAppData);
+    hg_enqueue_image_upload(ptAppData, tTexture.tImage, pucData, (uint32_t)iWidth, (uint32_t)iHeight);
+    if(bImplicitBatch) hg_wait_for_upload(ptAppData, hg_submit_upload_batch(ptAppData));
 
     // create image view
     VkImageViewCreateInfo tViewInfo = {
@@ -688,6 +1175,7 @@ hg_create_texture(hgAppData* ptAppData, const unsigned char* pucData, int iWidth
     };
     VULKAN_CHECK(vkCreateImageView(ptAppData->tContextComponents.tDevice, &tViewInfo, NULL, &tTexture.tImageView));
 
+    HG_TRACE_END();
     return tTexture;
 }
 
@@ -697,9 +1185,88 @@ hg_create_texture(hgAppData* ptAppData, const unsigned char* pucData, int iWidth
 hgPipeline
 hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig)
 {
-    // create shader modules
-    VkShaderModule tVertShaderModule = hg_create_shader_module(ptState, ptConfig->pcVertexShaderPath);
-    VkShaderModule tFragShaderModule = hg_create_shader_module(ptState, ptConfig->pcFragmentShaderPath);
+    hgPipeline tPipeline = hg_build_graphics_pipeline(ptState, ptConfig, NULL);
+    hg_release_stale_shader_modules(ptState);
+    return tPipeline;
+}
+
+void
+hg_create_graphics_pipelines(hgAppData* ptState, hgPipelineConfig* atConfigs, uint32_t uCount, hgPipeline* atPipelinesOut)
+{
+    HG_TRACE_BEGIN(__func__);
+    if(uCount == 0)
+    {
+        HG_TRACE_END();
+        return;
+    }
+
+    uint32_t uWorkerCount = ptState->uPipelineWorkerCount ? ptState->uPipelineWorkerCount : hg_get_core_count();
+    if(uWorkerCount > HG_MAX_PIPELINE_WORKERS) uWorkerCount = HG_MAX_PIPELINE_WORKERS;
+    if(uWorkerCount > uCount)                  uWorkerCount = uCount;
+    if(uWorkerCount == 0)                      uWorkerCount = 1;
+
+    hgPipelineBatch tBatch = {
+        .ptState     = ptState,
+        .atConfigs   = atConfigs,
+        .atPipelines = atPipelinesOut,
+        .uCount      = uCount,
+        .uNextJob    = 0
+    };
+    hg_mutex_init(&tBatch.tJobLock);
+    hg_mutex_init(&tBatch.tShaderLock);
+
+    // vkCreateGraphicsPipelines/vkCreatePipelineLayout are free threaded and the pipeline cache synchronizes
+    // itself, only the shader module cache lookups need a lock -> the calling thread works as one of the workers
+    hgThread atThreads[HG_MAX_PIPELINE_WORKERS];
+    uint32_t uStarted = 0;
+    for(uint32_t i = 1; i < uWorkerCount; i++)
+    {
+        if(!hg_thread_start(&atThreads[uStarted], hg_pipeline_worker, &tBatch))
+        {
+            break; // whatever couldn't start is picked up by the threads that did
+        }
+        uStarted++;
+    }
+    hg_pipeline_worker(&tBatch);
+
+    for(uint32_t i = 0; i < uStarted; i++)
+    {
+        hg_thread_join(atThreads[i]);
+    }
+
+    hg_mutex_destroy(&tBatch.tJobLock);
+    hg_mutex_destroy(&tBatch.tShaderLock);
+
+    // every worker has joined -> nothing references the modules a changed file replaced during the batch
+    hg_release_stale_shader_modules(ptState);
+    HG_TRACE_END();
+}
+
+void
+hg_pipeline_worker(void* pUserData)
+{
+    hgPipelineBatch* ptBatch = pUserData;
+    while(true)
+    {
+        hg_mutex_lock(&ptBatch->tJobLock);
+        uint32_t uJob = ptBatch->uNextJob++;
+        hg_mutex_unlock(&ptBatch->tJobLock);
+
+        if(uJob >= ptBatch->uCount)
+        {
+            return;
+        }
+        ptBatch->atPipelines[uJob] = hg_build_graphics_pipeline(ptBatch->ptState, &ptBatch->atConfigs[uJob], &ptBatch->tShaderLock);
+    }
+}
+
+hgPipeline
+hg_build_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig, hgMutex* ptShaderLock)
+{
+    HG_TRACE_BEGIN(__func__);
+    // create shader modules (cached, so pipelines sharing shaders only load them once, cold ones load in parallel)
+    VkShaderModule tVertShaderModule = hg_create_shader_module(ptState, ptConfig->pcVertexShaderPath, ptShaderLock);
+    VkShaderModule tFragShaderModule = hg_create_shader_module(ptState, ptConfig->pcFragmentShaderPath, ptShaderLock);
 
     VkPipelineShaderStageCreateInfo tVertShaderStageInfo = {
         .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -716,17 +1283,25 @@ hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig)
     };
     VkPipelineShaderStageCreateInfo tShaderStages[] = {tVertShaderStageInfo, tFragShaderStageInfo};
 
-    // vertex input state using config
+    // vertex input state using config -> explicit binding list, otherwise one per vertex binding from uVertexStride
     VkVertexInputBindingDescription tBindingDescription = {
         .binding   = 0,
         .stride    = ptConfig->uVertexStride,
         .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
     };
+    const VkVertexInputBindingDescription* ptBindings    = (ptConfig->uVertexStride > 0) ? &tBindingDescription : NULL;
+    uint32_t                               uBindingCount = (ptConfig->uVertexStride > 0) ? 1 : 0;
+    if(ptConfig->uBindingCount > 0)
+    {
+        assert(ptConfig->uBindingCount <= HG_MAX_VERTEX_BINDINGS && "raise HG_MAX_VERTEX_BINDINGS");
+        ptBindings    = ptConfig->ptBindingDescriptions;
+        uBindingCount = ptConfig->uBindingCount;
+    }
 
     VkPipelineVertexInputStateCreateInfo tVertexInputInfo = {
         .sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount   = (ptConfig->uVertexStride > 0) ? 1 : 0,
-        .pVertexBindingDescriptions      = (ptConfig->uVertexStride > 0) ? &tBindingDescription : NULL,
+        .vertexBindingDescriptionCount   = uBindingCount,
+        .pVertexBindingDescriptions      = ptBindings,
         .vertexAttributeDescriptionCount = ptConfig->uAttributeCount,
         .pVertexAttributeDescriptions    = ptConfig->ptAttributeDescriptions
     };
@@ -737,26 +1312,20 @@ hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig)
         .primitiveRestartEnable = VK_FALSE
     };
 
-    VkViewport tViewport = {
-        .x        = 0.0f,
-        .y        = 0.0f,
-        .width    = (float)ptState->tSwapchainComponents.tExtent.width,
-        .height   = (float)ptState->tSwapchainComponents.tExtent.height,
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f
-    };
-
-    VkRect2D tScissor = {
-        .offset = {0, 0},
-        .extent = ptState->tSwapchainComponents.tExtent
-    };
-
+    // viewport/scissor are dynamic (set in hg_begin_render_pass) so pipelines don't depend on the swapchain extent
     VkPipelineViewportStateCreateInfo tViewportState = {
         .sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
         .viewportCount = 1,
-        .pViewports    = &tViewport,
+        .pViewports    = NULL,
         .scissorCount  = 1,
-        .pScissors     = &tScissor
+        .pScissors     = NULL
+    };
+
+    VkDynamicState atDynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo tDynamicState = {
+        .sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = 2,
+        .pDynamicStates    = atDynamicStates
     };
 
     VkPipelineRasterizationStateCreateInfo tRasterizer = {
@@ -793,6 +1362,30 @@ hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig)
         .blendConstants  = {0.0f, 0.0f, 0.0f, 0.0f}
     };
 
+    // push constant ranges have to fit the device limit (128 bytes guaranteed)
+    hgPipeline tPipelineResult = {0};
+    uint32_t uMaxPushConstantsSize = ptState->tContextComponents.tDeviceProperties.limits.maxPushConstantsSize;
+    for(uint32_t i = 0; i < ptConfig->uPushConstantRangeCount; i++)
+    {
+        const VkPushConstantRange* ptRange = &ptConfig->ptPushConstantRanges[i];
+        if(ptRange->offset % 4 != 0 || ptRange->size == 0 || ptRange->size % 4 != 0)
+        {
+            printf("Push constant range %u must have offset/size as non zero multiples of 4!\n", i);
+            exit(1);
+        }
+        if(ptRange->offset + ptRange->size > uMaxPushConstantsSize)
+        {
+            printf("Push constant range %u (%u bytes at %u) exceeds maxPushConstantsSize (%u)!\n", 
+                    i, ptRange->size, ptRange->offset, uMaxPushConstantsSize);
+            exit(1);
+        }
+        tPipelineResult.tPushConstantStages |= ptRange->stageFlags;
+        if(ptRange->offset + ptRange->size > tPipelineResult.uPushConstantSize)
+        {
+            tPipelineResult.uPushConstantSize = ptRange->offset + ptRange->size;
+        }
+    }
+
     // create pipeline layout using config
     VkPipelineLayoutCreateInfo tPipelineLayoutInfo = {
         .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
@@ -802,7 +1395,6 @@ hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig)
         .pPushConstantRanges    = ptConfig->ptPushConstantRanges
     };
 
-    hgPipeline tPipelineResult = {0};
     tPipelineResult.tPipelineBindPoint = ptConfig->tPipelineBindPoint;
 
     VULKAN_CHECK(vkCreatePipelineLayout(ptState->tContextComponents.tDevice, &tPipelineLayoutInfo, NULL, &tPipelineResult.tPipelineLayout));
@@ -829,6 +1421,7 @@ hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig)
         .pMultisampleState   = &tMultisampling,
         .pColorBlendState    = &tColorBlending,
         .pDepthStencilState  = NULL,
+        .pDynamicState       = &tDynamicState,
         .layout              = tPipelineResult.tPipelineLayout,
         .renderPass          = ptState->tPipelineComponents.tRenderPass,
         .subpass             = 0,
@@ -839,19 +1432,18 @@ hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* ptConfig)
     // if depth is enabled pass in VkPipelineDepthStencilStateCreateInfo
     if(ptState->bDepthEnabled) tPipelineInfo.pDepthStencilState = &tDepthStencil;
 
-    VULKAN_CHECK(vkCreateGraphicsPipelines(ptState->tContextComponents.tDevice, VK_NULL_HANDLE, 1, &tPipelineInfo, 
+    VULKAN_CHECK(vkCreateGraphicsPipelines(ptState->tContextComponents.tDevice, ptState->tContextComponents.tPipelineCache, 1, &tPipelineInfo, 
             NULL, &tPipelineResult.tPipeline));
 
-    // cleanup shader modules
-    vkDestroyShaderModule(ptState->tContextComponents.tDevice, tVertShaderModule, NULL);
-    vkDestroyShaderModule(ptState->tContextComponents.tDevice, tFragShaderModule, NULL);
-
+    // shader modules stay in the cache for the next pipeline that uses them
+    HG_TRACE_END();
     return tPipelineResult;
 }
 
 VkDescriptorPool 
 hg_create_descriptor_pool(hgAppData* ptState, uint32_t uMaxSets, VkDescriptorPoolSize* atPoolSizes, uint32_t uPoolSizeCount)
 {
+    HG_TRACE_BEGIN(__func__);
     VkDescriptorPool tDescPool = VK_NULL_HANDLE;
 
     // desc pool
@@ -864,6 +1456,7 @@ hg_create_descriptor_pool(hgAppData* ptState, uint32_t uMaxSets, VkDescriptorPoo
     };
     VULKAN_CHECK(vkCreateDescriptorPool(ptState->tContextComponents.tDevice, &tDescPoolCreateInfo, NULL, &tDescPool));
 
+    HG_TRACE_END();
     return tDescPool;
 }
 
@@ -880,7 +1473,7 @@ hg_update_texture_descriptor(hgAppData* ptState, VkDescriptorSet tDescriptorSet,
     VkWriteDescriptorSet tDescriptorWrite = {
         .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .dstSet          = tDescriptorSet,
-        .dstBinding      = 0,
+        .dstBinding      = uBinding,
         .dstArrayElement = 0,
         .descriptorCount = 1,
         .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -892,22 +1485,26 @@ hg_update_texture_descriptor(hgAppData* ptState, VkDescriptorSet tDescriptorSet,
 hgUniformBuffer 
 hg_create_uniform_buffer(hgAppData* ptState, size_t szSize)
 {
+    HG_TRACE_BEGIN(__func__);
     hgUniformBuffer tNewBuffer = {0};
     tNewBuffer.szSize = szSize;
 
     // create buffer
-    hg_create_buffer(&ptState->tContextComponents, (VkDeviceSize)szSize,VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,&tNewBuffer.tBuffer, &tNewBuffer.tMemory);
+    hg_create_buffer(ptState, (VkDeviceSize)szSize,VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,&tNewBuffer.tBuffer, &tNewBuffer.tAllocation);
 
-    // keep the buffer mapped permanently for easy updates
-    vkMapMemory(ptState->tContextComponents.tDevice, tNewBuffer.tMemory, 0, szSize, 0, &tNewBuffer.pMapped);
+    // the allocator keeps host visible blocks mapped permanently for easy updates
+    tNewBuffer.pMapped = tNewBuffer.tAllocation.pMapped;
 
+    HG_TRACE_END();
     return tNewBuffer;
 }
 
 void 
 hg_update_uniform_buffer(hgAppData* ptState, hgUniformBuffer* tBuffer, void* pData, size_t szSize)
 {
+    (void)ptState;
+
     // since we keep it mapped, just memcpy -> note: no need to unmap/remap - HOST_COHERENT flag means writes are automatically visible to GPU
     memcpy(tBuffer->pMapped, pData, szSize);
 }
@@ -915,681 +1512,4158 @@ hg_update_uniform_buffer(hgAppData* ptState, hgUniformBuffer* tBuffer, void* pDa
 void 
 hg_destroy_uniform_buffer(hgAppData* ptState, hgUniformBuffer* tBuffer)
 {
-    // unmap before destroying
-    if (tBuffer->pMapped) 
-    {
-        vkUnmapMemory(ptState->tContextComponents.tDevice, tBuffer->tMemory);
-        tBuffer->pMapped = NULL;
-    }
-    if (tBuffer->tBuffer != VK_NULL_HANDLE) 
+    // mapping belongs to the memory block so there is nothing to unmap here
+    tBuffer->pMapped = NULL;
+    hg_destroy_buffer(ptState, &tBuffer->tBuffer, &tBuffer->tAllocation);
+    tBuffer->szSize       = 0;
+    tBuffer->szSlotSize   = 0;
+    tBuffer->szSlotStride = 0;
+    tBuffer->uSlotCount   = 0;
+}
+
+hgUniformBuffer
+hg_create_dynamic_uniform_buffer(hgAppData* ptState, size_t szSlotSize, uint32_t uSlotCount)
+{
+    HG_TRACE_BEGIN(__func__);
+    const VkPhysicalDeviceLimits* ptLimits = &ptState->tContextComponents.tDeviceProperties.limits;
+
+    // one slot is what the shader sees through the descriptor range
+    if(szSlotSize == 0 || szSlotSize > ptLimits->maxUniformBufferRange)
     {
-        vkDestroyBuffer(ptState->tContextComponents.tDevice, tBuffer->tBuffer, NULL);
-        tBuffer->tBuffer = VK_NULL_HANDLE;
+        printf("Dynamic uniform slot size %zu exceeds maxUniformBufferRange (%u)!\n", szSlotSize, ptLimits->maxUniformBufferRange);
+        exit(1);
     }
-    if (tBuffer->tMemory != VK_NULL_HANDLE) 
+    assert(uSlotCount > 0);
+
+    // dynamic offsets must be multiples of minUniformBufferOffsetAlignment (power of two)
+    VkDeviceSize tAlignment = ptLimits->minUniformBufferOffsetAlignment;
+    if(tAlignment == 0)
     {
-        vkFreeMemory(ptState->tContextComponents.tDevice, tBuffer->tMemory, NULL);
-        tBuffer->tMemory = VK_NULL_HANDLE;
+        tAlignment = 1;
     }
-    tBuffer->szSize = 0;
-}
 
-// =============================================================================
-// FRAME RENDERING
-// =============================================================================
-
-// -------------------------------
-// frame lifecycle
-// -------------------------------
-uint32_t 
-hg_begin_frame(hgAppData* ptState)
-{
-    vkWaitForFences(ptState->tContextComponents.tDevice, 1, &ptState->tSyncComponents.tInFlight, VK_TRUE, UINT64_MAX);
-    vkResetFences(ptState->tContextComponents.tDevice, 1, &ptState->tSyncComponents.tInFlight);
+    hgUniformBuffer tNewBuffer = {0};
+    tNewBuffer.szSlotSize   = szSlotSize;
+    tNewBuffer.szSlotStride = (size_t)((szSlotSize + tAlignment - 1) & ~(tAlignment - 1));
+    tNewBuffer.uSlotCount   = uSlotCount;
 
-    uint32_t uImageIndex = 0;
-    vkAcquireNextImageKHR(ptState->tContextComponents.tDevice, ptState->tSwapchainComponents.tSwapchain, UINT64_MAX, 
-        ptState->tSyncComponents.tImageAvailable, VK_NULL_HANDLE, &uImageIndex);
+    // a full set of slots per frame in flight so the cpu never writes what the gpu is still reading
+    tNewBuffer.szSize = tNewBuffer.szSlotStride * uSlotCount * hg_get_frames_in_flight(ptState);
 
-    // set current frame index
-    ptState->tCommandComponents.uCurrentImageIndex = uImageIndex;
+    hg_create_buffer(ptState, (VkDeviceSize)tNewBuffer.szSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tAllocation);
+    tNewBuffer.pMapped = tNewBuffer.tAllocation.pMapped;
 
-    // get, reset, and begin command buffer
-    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
-    vkResetCommandBuffer(tCommandBuffer, 0);
+    HG_TRACE_END();
+    return tNewBuffer;
+}
 
-    VkCommandBufferBeginInfo tBeginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
-    };
-    VULKAN_CHECK(vkBeginCommandBuffer(ptState->tCommandComponents.tCommandBuffers[uImageIndex], &tBeginInfo));
+void
+hg_update_uniform_slot(hgAppData* ptState, hgUniformBuffer* tBuffer, uint32_t uSlot, const void* pData, size_t szSize)
+{
+    assert(tBuffer->uSlotCount > 0 && "not a dynamic uniform buffer");
+    assert(uSlot < tBuffer->uSlotCount);
+    assert(szSize <= tBuffer->szSlotSize);
 
-    return uImageIndex;
+    uint32_t uOffset = hg_get_uniform_dynamic_offset(ptState, tBuffer, uSlot);
+    memcpy((char*)tBuffer->pMapped + uOffset, pData, szSize);
 }
 
-void 
-hg_end_frame(hgAppData* ptState, uint32_t uImageIndex)
+uint32_t
+hg_get_uniform_dynamic_offset(hgAppData* ptState, hgUniformBuffer* tBuffer, uint32_t uSlot)
 {
-    // get current command buffer
-    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
-    VULKAN_CHECK(vkEndCommandBuffer(tCommandBuffer));
+    assert(uSlot < tBuffer->uSlotCount);
 
-    // submit command buffer
-    VkSubmitInfo tSubmitInfo = {
-        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .waitSemaphoreCount   = 1,
-        .pWaitSemaphores      = &ptState->tSyncComponents.tImageAvailable,
-        .pWaitDstStageMask    = (VkPipelineStageFlags[]){VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
-        .commandBufferCount   = 1,
-        .pCommandBuffers      = &ptState->tCommandComponents.tCommandBuffers[uImageIndex],
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores    = &ptState->tSyncComponents.tRenderFinished
-    };
+    // slots of the frame being recorded
+    uint32_t uFrame = hg_get_current_frame_index(ptState);
+    return (uint32_t)((uFrame * tBuffer->uSlotCount + uSlot) * tBuffer->szSlotStride);
+}
 
-    VULKAN_CHECK(vkQueueSubmit(ptState->tContextComponents.tGraphicsQueue, 1, &tSubmitInfo, ptState->tSyncComponents.tInFlight));
+void
+hg_update_uniform_descriptor(hgAppData* ptState, VkDescriptorSet tDescriptorSet, uint32_t uBinding, hgUniformBuffer* tBuffer)
+{
+    // dynamic buffers expose a single slot, the offset is supplied at bind time
+    bool bDynamic = tBuffer->uSlotCount > 0;
+
+    VkDescriptorBufferInfo tBufferInfo = {
+        .buffer = tBuffer->tBuffer,
+        .offset = 0,
+        .range  = bDynamic ? tBuffer->szSlotSize : tBuffer->szSize
+    };
 
-    // present
-    VkPresentInfoKHR tPresentInfo = {
-        .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores    = &ptState->tSyncComponents.tRenderFinished,
-        .swapchainCount     = 1,
-        .pSwapchains        = &ptState->tSwapchainComponents.tSwapchain,
-        .pImageIndices      = &uImageIndex
+    VkWriteDescriptorSet tDescriptorWrite = {
+        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet          = tDescriptorSet,
+        .dstBinding      = uBinding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType  = bDynamic ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .pBufferInfo     = &tBufferInfo
     };
-    VULKAN_CHECK(vkQueuePresentKHR(ptState->tContextComponents.tGraphicsQueue, &tPresentInfo));
+    vkUpdateDescriptorSets(ptState->tContextComponents.tDevice, 1, &tDescriptorWrite, 0, NULL);
 }
 
 // -------------------------------
-// render pass
+// transient memory
 // -------------------------------
-
-void 
-hg_begin_render_pass(hgAppData* ptState, uint32_t uImageIndex) 
+hgTransientAllocation
+hg_alloc_transient(hgAppData* ptState, size_t szSize)
 {
-    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
-    if (ptState->bDepthEnabled) 
+    hgTransientAllocator* ptTransient = &ptState->tTransientComponents;
+    if(ptTransient->tBuffer == VK_NULL_HANDLE) hg_create_transient_allocator(ptState);
+    if(!ptTransient->bActive)                  hg_activate_transient_frame(ptState);
+
+    VkDeviceSize tStart = hg_align_up(ptTransient->tHead, ptTransient->tAlignment);
+    if(tStart + szSize > ptTransient->tFrameSize)
     {
-        // with depth
-        // color clear values 
-        VkClearValue tClearValues[2];
-        tClearValues[0].color.float32[0] = ptState->tPipelineComponents.afClearColor[0];
-        tClearValues[0].color.float32[1] = ptState->tPipelineComponents.afClearColor[1];
-        tClearValues[0].color.float32[2] = ptState->tPipelineComponents.afClearColor[2];
-        tClearValues[0].color.float32[3] = ptState->tPipelineComponents.afClearColor[3];
+        printf("transient frame region full (%llu bytes), raise hgAppData::szTransientFrameSize\n", (unsigned long long)ptTransient->tFrameSize);
+        exit(1);
+    }
+    ptTransient->tHead = tStart + szSize;
+
+    VkDeviceSize tOffset = (VkDeviceSize)ptTransient->uActiveFrame * ptTransient->tFrameSize + tStart;
+    hgTransientAllocation tResult = {
+        .pData   = (char*)ptTransient->tAllocation.pMapped + tOffset,
+        .tBuffer = ptTransient->tBuffer,
+        .tOffset = tOffset,
+        .tSize   = szSize
+    };
+    return tResult;
+}
 
-        // depth clear values
-        tClearValues[1].depthStencil.depth = 1.0f;
-        tClearValues[1].depthStencil.stencil = 0;
+// -------------------------------
+// instance streams
+// -------------------------------
+hgTransientAllocation
+hg_alloc_instance_stream(hgAppData* ptState, const float* afModels, const float* afColors, uint32_t uCount)
+{
+    // interleaved straight into mapped memory, nothing is staged
+    hgTransientAllocation tStream = hg_alloc_transient(ptState, sizeof(hgInstanceData) * uCount);
+    hg_write_instance_data(tStream.pData, afModels, afColors, uCount);
+    return tStream;
+}
 
-        VkRenderPassBeginInfo tRenderPassInfo = {
-            .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass      = ptState->tPipelineComponents.tRenderPass,
-            .framebuffer     = ptState->tPipelineComponents.tFramebuffers[uImageIndex],
-            .renderArea      = {
-                .offset      = {0, 0},
-                .extent      = ptState->tSwapchainComponents.tExtent
-            },
-            .clearValueCount = 2,
-            .pClearValues    = tClearValues
+hgVertexBuffer
+hg_create_instance_buffer(hgAppData* ptState, const float* afModels, const float* afColors, uint32_t uCount)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgInstanceData* atInstances = malloc(sizeof(hgInstanceData) * uCount);
+    hg_write_instance_data(atInstances, afModels, afColors, uCount);
+
+    // the staging ring copies the data right away, so the interleaved copy can go immediately
+    hgVertexBuffer tBuffer = hg_create_static_vertex_buffer(ptState, atInstances, sizeof(hgInstanceData) * uCount, sizeof(hgInstanceData));
+    free(atInstances);
+    HG_TRACE_END();
+    return tBuffer;
+}
+
+uint32_t
+hg_get_instance_attributes(uint32_t uBinding, uint32_t uFirstLocation, VkVertexInputAttributeDescription* atAttributesOut)
+{
+    // a mat4 input is four vec4 locations
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        atAttributesOut[i] = (VkVertexInputAttributeDescription){
+            .location = uFirstLocation + i,
+            .binding  = uBinding,
+            .format   = VK_FORMAT_R32G32B32A32_SFLOAT,
+            .offset   = (uint32_t)(offsetof(hgInstanceData, afModel) + sizeof(float) * 4 * i)
         };
-        vkCmdBeginRenderPass(tCommandBuffer, &tRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
     }
-    else 
-    {
-        // without depth
-        VkClearValue tClearColor = {{{
-            ptState->tPipelineComponents.afClearColor[0],
-            ptState->tPipelineComponents.afClearColor[1],
-            ptState->tPipelineComponents.afClearColor[2],
-            ptState->tPipelineComponents.afClearColor[3]
-        }}};
+    atAttributesOut[4] = (VkVertexInputAttributeDescription){
+        .location = uFirstLocation + 4,
+        .binding  = uBinding,
+        .format   = VK_FORMAT_R32G32B32A32_SFLOAT,
+        .offset   = (uint32_t)offsetof(hgInstanceData, afColor)
+    };
+    return HG_INSTANCE_ATTRIBUTE_COUNT;
+}
 
-        VkRenderPassBeginInfo tRenderPassInfo = {
-            .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass      = ptState->tPipelineComponents.tRenderPass,
-            .framebuffer     = ptState->tPipelineComponents.tFramebuffers[uImageIndex],
-            .renderArea      = {
-                .offset      = {0, 0},
-                .extent      = ptState->tSwapchainComponents.tExtent
-            },
-            .clearValueCount = 1,
-            .pClearValues    = &tClearColor
-        };
-        vkCmdBeginRenderPass(tCommandBuffer, &tRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+// -------------------------------
+// indirect draws
+// -------------------------------
+hgIndirectBuffer
+hg_create_indirect_buffer(hgAppData* ptState, const VkDrawIndexedIndirectCommand* atCommands, uint32_t uCount)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgIndirectBuffer tNewBuffer = {0};
+    tNewBuffer.uMaxDraws    = uCount;
+    tNewBuffer.tCountOffset = (VkDeviceSize)uCount * sizeof(VkDrawIndexedIndirectCommand);
+
+    // storage usage so a compute pass can write the commands (and the count) in place
+    hg_create_buffer(ptState, tNewBuffer.tCountOffset + sizeof(uint32_t), 
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tAllocation);
+
+    // gpu filled buffers start out zeroed -> slots nobody wrote have instanceCount 0 and draw nothing, even when the
+    // count fallback draws every slot
+    uint32_t uInitialCount = atCommands ? uCount : 0;
+    void*    pZeroed       = atCommands ? NULL : calloc(1, (size_t)tNewBuffer.tCountOffset + sizeof(uint32_t));
+    bool bImplicitBatch = !ptState->tUploadComponents.bBatchOpen;
+    if(bImplicitBatch) hg_begin_upload_batch(ptState);
+    if(atCommands)
+    {
+        hg_enqueue_buffer_upload(ptState, tNewBuffer.tBuffer, 0, atCommands, tNewBuffer.tCountOffset);
+        hg_enqueue_buffer_upload(ptState, tNewBuffer.tBuffer, tNewBuffer.tCountOffset, &uInitialCount, sizeof(uint32_t));
+    }
+    else
+    {
+        hg_enqueue_buffer_upload(ptState, tNewBuffer.tBuffer, 0, pZeroed, tNewBuffer.tCountOffset + sizeof(uint32_t));
     }
+    if(bImplicitBatch) hg_wait_for_upload(ptState, hg_submit_upload_batch(ptState));
+    free(pZeroed); // the staging ring already holds a copy
+
+    HG_TRACE_END();
+    return tNewBuffer;
 }
 
 void
-hg_end_render_pass(hgAppData* ptState)
+hg_cmd_reset_indirect_buffer(hgAppData* ptState, hgIndirectBuffer* tIndirectBuffer)
+{
+    // recorded on the graphics queue (vkCmdFillBuffer needs it on vulkan 1.0), outside of a render pass
+    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
+    VkDeviceSize    tSize          = tIndirectBuffer->tCountOffset + sizeof(uint32_t);
+
+    // earlier indirect reads/compute writes this frame finish first, the producer and the draws see the zeros
+    VkBufferMemoryBarrier tBarrier = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer              = tIndirectBuffer->tBuffer,
+        .offset              = 0,
+        .size                = tSize
+    };
+    vkCmdPipelineBarrier(tCommandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, NULL, 1, &tBarrier, 0, NULL);
+    vkCmdFillBuffer(tCommandBuffer, tIndirectBuffer->tBuffer, 0, tSize, 0);
+    tBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    tBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(tCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0, 0, NULL, 1, &tBarrier, 0, NULL);
+}
+
+hgTransientAllocation
+hg_alloc_indirect_commands(hgAppData* ptState, uint32_t uCount)
 {
-    vkCmdEndRenderPass(ptState->tCommandComponents.tCommandBuffers[ptState->tCommandComponents.uCurrentImageIndex]);
+    return hg_alloc_transient(ptState, (size_t)uCount * sizeof(VkDrawIndexedIndirectCommand));
 }
 
-// -------------------------------
-// bind state
-// -------------------------------
+bool
+hg_supports_multi_draw_indirect(hgAppData* ptState)
+{
+    return ptState->tContextComponents.tEnabledFeatures.multiDrawIndirect == VK_TRUE;
+}
 
-void 
-hg_cmd_bind_pipeline(hgAppData* ptState, hgPipeline* tPipeline)
+bool
+hg_supports_draw_indirect_count(hgAppData* ptState)
 {
-    // get command buffer
-    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
-    vkCmdBindPipeline(tCommandBuffer, tPipeline->tPipelineBindPoint, tPipeline->tPipeline);
+    return ptState->tContextComponents.pfnCmdDrawIndexedIndirectCount != NULL;
 }
 
 // -------------------------------
-// draw commands
+// geometry pools
 // -------------------------------
-// TODO: implement hg_cmd_draw, hg_cmd_draw_indexed, etc.
+hgGeometryPool
+hg_create_geometry_pool(hgAppData* ptState, uint32_t uVertexStride, uint32_t uMaxVertices, uint32_t uMaxIndices)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgGeometryPool tNewPool = {0};
+    tNewPool.uVertexStride   = uVertexStride;
+    tNewPool.uVertexCapacity = uMaxVertices;
+    tNewPool.uIndexCapacity  = uMaxIndices;
+
+    // the biggest index any mesh can use is uMaxVertices - 1 (0xffff stays free for primitive restart)
+    tNewPool.tIndexType = uMaxVertices <= UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    uint32_t uMaxIndexValue = ptState->tContextComponents.tDeviceProperties.limits.maxDrawIndexedIndexValue;
+    if(tNewPool.tIndexType == VK_INDEX_TYPE_UINT32 && uMaxVertices - 1 > uMaxIndexValue)
+    {
+        printf("Geometry pool of %u vertices exceeds maxDrawIndexedIndexValue (%u)!\n", uMaxVertices, uMaxIndexValue);
+        exit(1);
+    }
+    hg_create_geometry_buffers(ptState, &tNewPool);
 
-// -------------------------------
-// convenience wrappers
-// -------------------------------
-// TODO: implement hg_draw_mesh
+    // both buffers start out as one free range
+    hg_range_list_free(&tNewPool.tFreeVertices, 0, uMaxVertices);
+    hg_range_list_free(&tNewPool.tFreeIndices, 0, uMaxIndices);
 
-// =============================================================================
-// CLEANUP
-// =============================================================================
+    HG_TRACE_END();
+    return tNewPool;
+}
 
-void 
-hg_core_cleanup(hgAppData* ptState)
+hgMeshHandle
+hg_register_mesh(hgAppData* ptState, hgGeometryPool* ptPool, const void* pVertices, uint32_t uVertexCount, const uint32_t* auIndices, uint32_t uIndexCount)
 {
-    if (!ptState) return;
-    vkDeviceWaitIdle(ptState->tContextComponents.tDevice);
-    hg_cleanup_swapchain_resources(ptState); // handles swapchain and related components
+    HG_TRACE_BEGIN(__func__);
+    assert(uVertexCount > 0 && uIndexCount > 0 && "empty mesh");
+    hg_reclaim_geometry_ranges(ptState, ptPool);
 
-    // destroy surface (not in swapchain resources function)
-    if (ptState->tSwapchainComponents.tSurface != VK_NULL_HANDLE) 
+    VkDeviceSize tFirstVertex = 0;
+    VkDeviceSize tFirstIndex  = 0;
+    if(!hg_range_list_allocate(&ptPool->tFreeVertices, uVertexCount, 1, &tFirstVertex))
     {
-        vkDestroySurfaceKHR(ptState->tContextComponents.tInstance, ptState->tSwapchainComponents.tSurface, NULL);
-        ptState->tSwapchainComponents.tSurface = VK_NULL_HANDLE;
+        HG_TRACE_END();
+        return 0;
     }
-
-    // cleanup Pipeline Components (except framebuffers) -> note: framebuffers already destroyed by hg_cleanup_swapchain_resources()
-    // destroy render pass
-    if (ptState->tPipelineComponents.tRenderPass != VK_NULL_HANDLE) 
+    if(!hg_range_list_allocate(&ptPool->tFreeIndices, uIndexCount, 1, &tFirstIndex))
     {
-        vkDestroyRenderPass(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tRenderPass, NULL);
-        ptState->tPipelineComponents.tRenderPass = VK_NULL_HANDLE;
+        hg_range_list_free(&ptPool->tFreeVertices, tFirstVertex, uVertexCount);
+        HG_TRACE_END();
+        return 0;
     }
 
-    // Cleanup Command Components (except framce command buffers) -> note: frame command buffers already freed by hg_cleanup_swapchain_resources()
-    // destroy command pool
-    if (ptState->tCommandComponents.tCommandPool != VK_NULL_HANDLE) 
+    // recycle an unused slot before growing the table
+    uint32_t uSlot = 0;
+    while(uSlot < ptPool->uMeshCount && ptPool->atMeshes[uSlot].uVertexCount > 0) uSlot++;
+    if(uSlot == ptPool->uMeshCount)
     {
-        vkDestroyCommandPool(ptState->tContextComponents.tDevice, ptState->tCommandComponents.tCommandPool, NULL);
-        ptState->tCommandComponents.tCommandPool = VK_NULL_HANDLE;
+        if(ptPool->uMeshCount == ptPool->uMeshCapacity)
+        {
+            ptPool->uMeshCapacity = ptPool->uMeshCapacity ? ptPool->uMeshCapacity * 2 : 64;
+            ptPool->atMeshes      = realloc(ptPool->atMeshes, ptPool->uMeshCapacity * sizeof(hgMesh));
+        }
+        ptPool->uMeshCount++;
     }
+    ptPool->atMeshes[uSlot] = (hgMesh){
+        .uFirstIndex   = (uint32_t)tFirstIndex,
+        .uIndexCount   = uIndexCount,
+        .iVertexOffset = (int32_t)tFirstVertex,
+        .uVertexCount  = uVertexCount
+    };
 
-    // cleanup Sync Components
-    if (ptState->tSyncComponents.tImageAvailable != VK_NULL_HANDLE) 
-    {
-        vkDestroySemaphore(ptState->tContextComponents.tDevice, ptState->tSyncComponents.tImageAvailable, NULL);
-        ptState->tSyncComponents.tImageAvailable = VK_NULL_HANDLE;
-    }
-    if (ptState->tSyncComponents.tRenderFinished != VK_NULL_HANDLE) 
-    {
-        vkDestroySemaphore(ptState->tContextComponents.tDevice, ptState->tSyncComponents.tRenderFinished, NULL);
-        ptState->tSyncComponents.tRenderFinished = VK_NULL_HANDLE;
-    }
-    if (ptState->tSyncComponents.tInFlight != VK_NULL_HANDLE) 
+    // a 16 bit pool only ever holds meshes below 0xffff vertices, so narrowing can't cut off an index
+    const void* pIndices   = auIndices;
+    uint16_t*   auNarrowed = NULL;
+    if(ptPool->tIndexType == VK_INDEX_TYPE_UINT16)
     {
-        vkDestroyFence(ptState->tContextComponents.tDevice, ptState->tSyncComponents.tInFlight, NULL);
-        ptState->tSyncComponents.tInFlight = VK_NULL_HANDLE;
+        auNarrowed = malloc(sizeof(uint16_t) * uIndexCount);
+        for(uint32_t i = 0; i < uIndexCount; i++) auNarrowed[i] = (uint16_t)auIndices[i];
+        pIndices = auNarrowed;
     }
 
-    // cleanup Vulkan Context (device and instance)
-    // note: physical device doesn't need to be destroyed
-    if (ptState->tContextComponents.tDevice != VK_NULL_HANDLE) 
+    VkDeviceSize tStride    = ptPool->uVertexStride;
+    VkDeviceSize tIndexSize = hg_index_size(ptPool->tIndexType);
+    bool bImplicitBatch = !ptState->tUploadComponents.bBatchOpen;
+    if(bImplicitBatch) hg_begin_upload_batch(ptState);
+    hg_enqueue_buffer_upload(ptState, ptPool->tVertexBuffer, tFirstVertex * tStride, pVertices, uVertexCount * tStride);
+    hg_enqueue_buffer_upload(ptState, ptPool->tIndexBuffer, tFirstIndex * tIndexSize, pIndices, uIndexCount * tIndexSize);
+    if(bImplicitBatch) hg_wait_for_upload(ptState, hg_submit_upload_batch(ptState));
+    free(auNarrowed); // the staging ring copied it already
+
+    HG_TRACE_END();
+    return uSlot + 1;
+}
+
+void
+hg_unregister_mesh(hgAppData* ptState, hgGeometryPool* ptPool, hgMeshHandle tMesh)
+{
+    // validate before indexing -> a stale or garbage handle must not read or clear someone else's slot
+    if(tMesh == 0 || tMesh > ptPool->uMeshCount || ptPool->atMeshes[tMesh - 1].uVertexCount == 0)
     {
-        vkDestroyDevice(ptState->tContextComponents.tDevice, NULL);
-        ptState->tContextComponents.tDevice = VK_NULL_HANDLE;
+        assert(false && "not a registered mesh");
+        return;
     }
-    if (ptState->tContextComponents.tInstance != VK_NULL_HANDLE) 
+    hgMesh* ptMesh = &ptPool->atMeshes[tMesh - 1];
+
+    if(ptPool->uRetiredCount == ptPool->uRetiredCapacity)
     {
-        vkDestroyInstance(ptState->tContextComponents.tInstance, NULL);
-        ptState->tContextComponents.tInstance = VK_NULL_HANDLE;
+        ptPool->uRetiredCapacity = ptPool->uRetiredCapacity ? ptPool->uRetiredCapacity * 2 : 16;
+        ptPool->atRetired        = realloc(ptPool->atRetired, ptPool->uRetiredCapacity * sizeof(hgRetiredMesh));
     }
 
-    // reset counts and state
-    ptState->tSwapchainComponents.uSwapchainImageCount = 0;
-    ptState->tCommandComponents.uCurrentImageIndex = 0;
-    ptState->width = 0;
-    ptState->height = 0;
+    // the frame being recorded may already draw it -> ranges wait for that frame (the next one when called between frames)
+    ptPool->atRetired[ptPool->uRetiredCount++] = (hgRetiredMesh){*ptMesh, ptState->tSyncComponents.uFrameCount + 1};
+    memset(ptMesh, 0, sizeof(hgMesh));
+}
 
-    // note: GLFW window cleanup should be done separately by the application
+const hgMesh*
+hg_get_mesh(hgGeometryPool* ptPool, hgMeshHandle tMesh)
+{
+    if(tMesh == 0 || tMesh > ptPool->uMeshCount || ptPool->atMeshes[tMesh - 1].uVertexCount == 0)
+    {
+        assert(false && "not a registered mesh");
+        return NULL;
+    }
+    return &ptPool->atMeshes[tMesh - 1];
 }
 
-void
-hg_cleanup_swapchain_resources(hgAppData* ptState) 
+bool
+hg_compact_geometry_pool(hgAppData* ptState, hgGeometryPool* ptPool)
 {
-    if(ptState->bDepthEnabled) // only if depth is enabled
+    HG_TRACE_BEGIN(__func__);
+    assert(!ptState->tUploadComponents.bBatchOpen && "submit the upload batch before compacting");
+    assert(ptState->tCommandComponents.bRecording && !ptState->tCommandComponents.bInRenderPass && 
+           "compact after hg_begin_frame and before hg_begin_render_pass");
+    hg_reclaim_geometry_ranges(ptState, ptPool);
+
+    // live meshes get packed in slot order, one copy region per mesh and buffer
+    VkBufferCopy* atVertexCopies = malloc((ptPool->uMeshCount + 1) * sizeof(VkBufferCopy));
+    VkBufferCopy* atIndexCopies  = malloc((ptPool->uMeshCount + 1) * sizeof(VkBufferCopy));
+    VkDeviceSize  tStride        = ptPool->uVertexStride;
+    VkDeviceSize  tIndexSize     = hg_index_size(ptPool->tIndexType);
+    uint32_t      uCopyCount     = 0;
+    uint32_t      uLiveVertices  = 0;
+    uint32_t      uLiveIndices   = 0;
+    for(uint32_t i = 0; i < ptPool->uMeshCount; i++)
     {
-        // destroy depth resources FIRST
-        if (ptState->tPipelineComponents.tDepthImageView != VK_NULL_HANDLE) 
-        {
-            vkDestroyImageView(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tDepthImageView, NULL);
-            ptState->tPipelineComponents.tDepthImageView = VK_NULL_HANDLE;
-        }
-        if (ptState->tPipelineComponents.tDepthImage != VK_NULL_HANDLE) 
-        {
-            vkDestroyImage(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tDepthImage, NULL);
-            ptState->tPipelineComponents.tDepthImage = VK_NULL_HANDLE;
-        }
-        if (ptState->tPipelineComponents.tDepthMemory != VK_NULL_HANDLE) 
-        {
-            vkFreeMemory(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tDepthMemory, NULL);
-            ptState->tPipelineComponents.tDepthMemory = VK_NULL_HANDLE;
-        }
+        hgMesh* ptMesh = &ptPool->atMeshes[i];
+        if(ptMesh->uVertexCount == 0) continue;
+
+        atVertexCopies[uCopyCount] = (VkBufferCopy){
+            .srcOffset = (VkDeviceSize)ptMesh->iVertexOffset * tStride,
+            .dstOffset = (VkDeviceSize)uLiveVertices * tStride,
+            .size      = (VkDeviceSize)ptMesh->uVertexCount * tStride
+        };
+        atIndexCopies[uCopyCount] = (VkBufferCopy){
+            .srcOffset = (VkDeviceSize)ptMesh->uFirstIndex * tIndexSize,
+            .dstOffset = (VkDeviceSize)uLiveIndices * tIndexSize,
+            .size      = (VkDeviceSize)ptMesh->uIndexCount * tIndexSize
+        };
+        uLiveVertices += ptMesh->uVertexCount;
+        uLiveIndices  += ptMesh->uIndexCount;
+        uCopyCount++;
     }
 
-    // free command buffers
-    if (ptState->tCommandComponents.tCommandBuffers) {
-        vkFreeCommandBuffers(ptState->tContextComponents.tDevice, ptState->tCommandComponents.tCommandPool, 
-            ptState->tSwapchainComponents.uSwapchainImageCount, ptState->tCommandComponents.tCommandBuffers);
-        free(ptState->tCommandComponents.tCommandBuffers);
-        ptState->tCommandComponents.tCommandBuffers = NULL;
+    // packed already when the only free range is the one behind the live meshes (retired ranges are holes too)
+    hgRangeList* ptFreeVertices = &ptPool->tFreeVertices;
+    hgRangeList* ptFreeIndices  = &ptPool->tFreeIndices;
+    bool bVerticesPacked = ptFreeVertices->uCount == 0 ? uLiveVertices == ptPool->uVertexCapacity :
+                           ptFreeVertices->uCount == 1 && ptFreeVertices->atRanges[0].tOffset == uLiveVertices;
+    bool bIndicesPacked  = ptFreeIndices->uCount == 0 ? uLiveIndices == ptPool->uIndexCapacity :
+                           ptFreeIndices->uCount == 1 && ptFreeIndices->atRanges[0].tOffset == uLiveIndices;
+    if(bVerticesPacked && bIndicesPacked)
+    {
+        free(atVertexCopies);
+        free(atIndexCopies);
+        HG_TRACE_END();
+        return false;
     }
 
-    // destroy framebuffers
-    if (ptState->tPipelineComponents.tFramebuffers) 
+    // copy into a fresh pair instead of in place -> regions of one vkCmdCopyBuffer may not overlap
+    VkBuffer     tOldVertexBuffer     = ptPool->tVertexBuffer;
+    hgAllocation tOldVertexAllocation = ptPool->tVertexAllocation;
+    VkBuffer     tOldIndexBuffer      = ptPool->tIndexBuffer;
+    hgAllocation tOldIndexAllocation  = ptPool->tIndexAllocation;
+    hg_create_geometry_buffers(ptState, ptPool);
+
+    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
+
+    // uploads submitted earlier land before the copy reads them, draws later in this frame see the copied data
+    VkMemoryBarrier tBarrier = {
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+    };
+    vkCmdPipelineBarrier(tCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &tBarrier, 0, NULL, 0, NULL);
+    if(uCopyCount > 0)
     {
-        for (uint32_t i = 0; i < ptState->tSwapchainComponents.uSwapchainImageCount; i++) 
-        {
-            vkDestroyFramebuffer(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tFramebuffers[i], NULL);
-        }
-        free(ptState->tPipelineComponents.tFramebuffers);
-        ptState->tPipelineComponents.tFramebuffers = NULL;
+        vkCmdCopyBuffer(tCommandBuffer, tOldVertexBuffer, ptPool->tVertexBuffer, uCopyCount, atVertexCopies);
+        vkCmdCopyBuffer(tCommandBuffer, tOldIndexBuffer, ptPool->tIndexBuffer, uCopyCount, atIndexCopies);
     }
+    tBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(tCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &tBarrier, 0, NULL, 0, NULL);
 
-    // destroy image views
-    if (ptState->tSwapchainComponents.tSwapchainImageViews) 
+    // frames in flight and this frame's copies still read the old pair -> destroyed once this frame has finished
+    if(ptPool->uRetiredBufferCount == ptPool->uRetiredBufferCapacity)
     {
-        for (uint32_t i = 0; i < ptState->tSwapchainComponents.uSwapchainImageCount; i++) 
-        {
-            vkDestroyImageView(ptState->tContextComponents.tDevice,ptState->tSwapchainComponents.tSwapchainImageViews[i], NULL);
-        }
-        free(ptState->tSwapchainComponents.tSwapchainImageViews);
-        ptState->tSwapchainComponents.tSwapchainImageViews = NULL;
+        ptPool->uRetiredBufferCapacity = ptPool->uRetiredBufferCapacity ? ptPool->uRetiredBufferCapacity * 2 : 4;
+        ptPool->atRetiredBuffers       = realloc(ptPool->atRetiredBuffers, ptPool->uRetiredBufferCapacity * sizeof(hgRetiredBuffers));
     }
+    ptPool->atRetiredBuffers[ptPool->uRetiredBufferCount++] = (hgRetiredBuffers){
+        .tVertexBuffer     = tOldVertexBuffer,
+        .tVertexAllocation = tOldVertexAllocation,
+        .tIndexBuffer      = tOldIndexBuffer,
+        .tIndexAllocation  = tOldIndexAllocation,
+        .uRetireFrame      = ptState->tSyncComponents.uFrameCount + 1
+    };
 
-    // destroy old swapchain
-    if (ptState->tSwapchainComponents.tSwapchain != VK_NULL_HANDLE) 
+    // handles stay the same, only their ranges move
+    uint32_t uCopy = 0;
+    for(uint32_t i = 0; i < ptPool->uMeshCount; i++)
     {
-        vkDestroySwapchainKHR(ptState->tContextComponents.tDevice, ptState->tSwapchainComponents.tSwapchain, NULL);
-        ptState->tSwapchainComponents.tSwapchain = VK_NULL_HANDLE;
+        hgMesh* ptMesh = &ptPool->atMeshes[i];
+        if(ptMesh->uVertexCount == 0) continue;
+
+        ptMesh->iVertexOffset = (int32_t)(atVertexCopies[uCopy].dstOffset / tStride);
+        ptMesh->uFirstIndex   = (uint32_t)(atIndexCopies[uCopy].dstOffset / tIndexSize);
+        uCopy++;
     }
-}
+    free(atVertexCopies);
+    free(atIndexCopies);
 
-void 
-hg_destroy_texture(hgAppData* ptAppData, hgTexture* tTexture)
-{
-    if(tTexture->tImageView != VK_NULL_HANDLE) vkDestroyImageView(ptAppData->tContextComponents.tDevice, tTexture->tImageView, NULL);
-    if(tTexture->tImage != VK_NULL_HANDLE)     vkDestroyImage(ptAppData->tContextComponents.tDevice, tTexture->tImage, NULL);
-    if(tTexture->tMemory != VK_NULL_HANDLE)    vkFreeMemory(ptAppData->tContextComponents.tDevice, tTexture->tMemory, NULL);
+    ptFreeVertices->uCount = 0;
+    ptFreeIndices->uCount  = 0;
+    if(uLiveVertices < ptPool->uVertexCapacity) hg_range_list_free(ptFreeVertices, uLiveVertices, ptPool->uVertexCapacity - uLiveVertices);
+    if(uLiveIndices < ptPool->uIndexCapacity)   hg_range_list_free(ptFreeIndices, uLiveIndices, ptPool->uIndexCapacity - uLiveIndices);
+    ptPool->uRetiredCount = 0; // retired ranges point into the old pair, the new one has no holes
 
-    memset(tTexture, 0, sizeof(hgTexture));
+    HG_TRACE_END();
+    return true;
 }
 
+// -------------------------------
+// memory
+// -------------------------------
 void
-hg_destroy_vertex_buffer(hgAppData* ptState, hgVertexBuffer* tVertexBuffer)
+hg_get_allocator_stats(hgAppData* ptState, hgAllocatorStats* ptStatsOut)
 {
-    if(tVertexBuffer->tBuffer != VK_NULL_HANDLE) vkDestroyBuffer(ptState->tContextComponents.tDevice, tVertexBuffer->tBuffer, NULL);
-    if(tVertexBuffer->tMemory != VK_NULL_HANDLE) vkFreeMemory(ptState->tContextComponents.tDevice, tVertexBuffer->tMemory, NULL);
+    memset(ptStatsOut, 0, sizeof(hgAllocatorStats));
+
+    VkDeviceSize tFreeBytes = 0;
+    for(uint32_t i = 0; i < ptState->tMemoryComponents.uBlockCount; i++)
+    {
+        hgMemoryBlock* ptBlock = ptState->tMemoryComponents.aptBlocks[i];
+        ptStatsOut->uBlockCount++;
+        ptStatsOut->uDedicatedBlockCount += ptBlock->bDedicated ? 1 : 0;
+        ptStatsOut->uAllocationCount     += ptBlock->uAllocationCount;
+        ptStatsOut->uFreeRangeCount      += ptBlock->tFreeRanges.uCount;
+        ptStatsOut->tTotalBytes          += ptBlock->tSize;
+        ptStatsOut->tUsedBytes           += ptBlock->tUsed;
+
+        for(uint32_t j = 0; j < ptBlock->tFreeRanges.uCount; j++)
+        {
+            tFreeBytes += ptBlock->tFreeRanges.atRanges[j].tSize;
+            if(ptBlock->tFreeRanges.atRanges[j].tSize > ptStatsOut->tLargestFreeRange)
+            {
+                ptStatsOut->tLargestFreeRange = ptBlock->tFreeRanges.atRanges[j].tSize;
+            }
+        }
+    }
+
+    // how much of the free memory is unusable for one big allocation
+    if(tFreeBytes > 0)
+    {
+        ptStatsOut->fFragmentation = 1.0f - (float)((double)ptStatsOut->tLargestFreeRange / (double)tFreeBytes);
+    }
 }
 
 void
-hg_destroy_index_buffer(hgAppData* ptState, hgIndexBuffer* tIndexBuffer)
+hg_print_allocator_stats(hgAppData* ptState)
 {
-    if(tIndexBuffer->tBuffer != VK_NULL_HANDLE) vkDestroyBuffer(ptState->tContextComponents.tDevice, tIndexBuffer->tBuffer, NULL);
-    if(tIndexBuffer->tMemory != VK_NULL_HANDLE) vkFreeMemory(ptState->tContextComponents.tDevice, tIndexBuffer->tMemory, NULL);
-}
+    hgAllocatorStats tStats;
+    hg_get_allocator_stats(ptState, &tStats);
 
-void 
-hg_destroy_pipeline(hgAppData* ptAppData, hgPipeline* tPipeline)
-{
-    if(tPipeline->tPipeline != VK_NULL_HANDLE)       vkDestroyPipeline      (ptAppData->tContextComponents.tDevice, tPipeline->tPipeline, NULL);
-    if(tPipeline->tPipelineLayout != VK_NULL_HANDLE) vkDestroyPipelineLayout(ptAppData->tContextComponents.tDevice, tPipeline->tPipelineLayout, NULL);
+    const double dMB = 1024.0 * 1024.0;
+    printf("device memory: %u blocks (%u dedicated), %u allocations, %.2f / %.2f MB used, %u free ranges, largest free %.2f MB, fragmentation %.2f\n",
+        tStats.uBlockCount, tStats.uDedicatedBlockCount, tStats.uAllocationCount, tStats.tUsedBytes / dMB, tStats.tTotalBytes / dMB,
+        tStats.uFreeRangeCount, tStats.tLargestFreeRange / dMB, tStats.fFragmentation);
 
-};
+    for(uint32_t i = 0; i < ptState->tMemoryComponents.uBlockCount; i++)
+    {
+        hgMemoryBlock* ptBlock = ptState->tMemoryComponents.aptBlocks[i];
+        printf("    block %u: type %u, %.2f / %.2f MB, %u allocations, %u free ranges%s%s\n", i, ptBlock->uMemoryTypeIndex,
+            ptBlock->tUsed / dMB, ptBlock->tSize / dMB, ptBlock->uAllocationCount, ptBlock->tFreeRanges.uCount,
+            ptBlock->bDedicated ? ", dedicated" : "", ptBlock->pMapped ? ", mapped" : "");
+    }
+
+    if(ptState->tTransientComponents.tBuffer != VK_NULL_HANDLE)
+    {
+        printf("transient memory: peak %.2f / %.2f MB per frame\n", 
+            ptState->tTransientComponents.tPeakUsage / dMB, ptState->tTransientComponents.tFrameSize / dMB);
+    }
+}
 
 // =============================================================================
-// INTERNAL HELPERS
+// FRAME RENDERING
 // =============================================================================
 
 // -------------------------------
-// memory & buffer helpers
+// frame lifecycle
 // -------------------------------
 uint32_t 
-hg_find_memory_type(hgVulkanContext* ptContext, uint32_t uTypeFilter, VkMemoryPropertyFlags tProperties)
+hg_begin_frame(hgAppData* ptState)
 {
-    VkPhysicalDeviceMemoryProperties tMemProperties;
-    vkGetPhysicalDeviceMemoryProperties(ptContext->tPhysicalDevice, &tMemProperties);
+    HG_TRACE_BEGIN(__func__);
+    hgFrameSync* ptSync  = &ptState->tSyncComponents;
+    VkDevice     tDevice = ptState->tContextComponents.tDevice;
+    uint32_t     uFrame  = ptSync->uCurrentFrame;
 
-    for(uint32_t i = 0; i < tMemProperties.memoryTypeCount; i++) 
+    // fps cap sleeps here, low latency additionally waits for the previous frame
+    HG_TRACE_BEGIN("frame pacing");
+    hg_apply_frame_pacing(ptState);
+    HG_TRACE_END();
+
+    // only waits for the frame that used this slot hg_get_frames_in_flight() frames ago
+    HG_TRACE_BEGIN("wait for frame fence");
+    vkWaitForFences(tDevice, 1, &ptSync->tInFlight[uFrame], VK_TRUE, UINT64_MAX);
+
+    if(ptState->tPacingMode == HG_PACING_LOW_LATENCY)
     {
-        if((uTypeFilter & (1 << i)) && (tMemProperties.memoryTypes[i].propertyFlags & tProperties) == tProperties)
+        // no queued frames -> input of this frame reaches the screen one frame later instead of uFramesInFlight
+        uint32_t uFramesInFlight = hg_get_frames_in_flight(ptState);
+        uint32_t uPrevFrame      = (uFrame + uFramesInFlight - 1) % uFramesInFlight;
+        if(ptSync->auSubmittedFrame[uPrevFrame] > 0)
         {
-            return i;
+            vkWaitForFences(tDevice, 1, &ptSync->tInFlight[uPrevFrame], VK_TRUE, UINT64_MAX);
         }
     }
-    printf("Failed to find suitable memory type!\n");
-    exit(1);
-}
+    HG_TRACE_END();
 
-void
-hg_create_buffer(hgVulkanContext* ptContext, VkDeviceSize tSize, VkBufferUsageFlags tFlags, VkMemoryPropertyFlags tProperties, VkBuffer* ptBuffer, VkDeviceMemory* pMemory)
-{
-    // create buffer
-    VkBufferCreateInfo tBufferCreateInfo = {
-        .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size        = tSize,
-        .usage       = tFlags,
-        .sharingMode = VK_SHARING_MODE_EXCLUSIVE
-    };
-    VULKAN_CHECK(vkCreateBuffer(ptContext->tDevice, &tBufferCreateInfo, NULL, ptBuffer));
+    // latency samples of every frame that finished by now, then start timing this one
+    uint64_t uNowNs = hg_get_time_ns();
+    for(uint32_t i = 0; i < hg_get_frames_in_flight(ptState); i++)
+    {
+        hg_update_frame_latency(ptState, i, uNowNs);
+    }
+    ptState->tPacingComponents.auFrameStartNs[uFrame] = uNowNs;
 
-    // get memory requirements
+    // reclaim staging space of uploads that finished in the meantime (never blocks)
+    hg_retire_uploads(ptState, false);
+
+    // hand out readbacks of frames the gpu finished (never blocks)
+    hg_deliver_readbacks(ptState, false);
+
+    // this frame's transient region is free again (unless something was allocated before hg_begin_frame)
+    if(!ptState->tTransientComponents.bActive) hg_activate_transient_frame(ptState);
+
+    // swapchains replaced by a resize are destroyed once their last frame finished (never blocks)
+    hg_collect_retired_swapchains(ptState, false);
+
+    // out of date -> nothing was acquired and the semaphore stays unsignaled, so recreate and try again.
+    // suboptimal still hands out a usable image, that one is presented and the swapchain recreated afterwards
+    uint32_t uImageIndex = 0;
+    HG_TRACE_BEGIN("vkAcquireNextImageKHR");
+    while(!ptState->bHeadless)
+    {
+        if(ptState->tSwapchainComponents.bNeedsRecreate)
+        {
+            hg_recreate_swapchain(ptState);
+        }
+
+        VkResult tResult = vkAcquireNextImageKHR(tDevice, ptState->tSwapchainComponents.tSwapchain, UINT64_MAX, 
+            ptSync->tImageAvailable[uFrame], VK_NULL_HANDLE, &uImageIndex);
+        if(tResult == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            ptState->tSwapchainComponents.bNeedsRecreate = true;
+            continue;
+        }
+        if(tResult == VK_SUBOPTIMAL_KHR)
+        {
+            ptState->tSwapchainComponents.bNeedsRecreate = true;
+            break;
+        }
+        VULKAN_CHECK(tResult);
+        break;
+    }
+    HG_TRACE_END();
+
+    // headless -> offscreen images are simply used in turn
+    if(ptState->bHeadless)
+    {
+        uImageIndex = (uint32_t)(ptSync->uFrameCount % ptState->tSwapchainComponents.uSwapchainImageCount);
+    }
+
+    // the image can come back while an older frame still renders to it (more frames in flight than images)
+    if(ptSync->tImagesInFlight[uImageIndex] != VK_NULL_HANDLE && ptSync->tImagesInFlight[uImageIndex] != ptSync->tInFlight[uFrame])
+    {
+        HG_TRACE_BEGIN("wait for image fence");
+        vkWaitForFences(tDevice, 1, &ptSync->tImagesInFlight[uImageIndex], VK_TRUE, UINT64_MAX);
+        HG_TRACE_END();
+    }
+    ptSync->tImagesInFlight[uImageIndex] = ptSync->tInFlight[uFrame];
+    vkResetFences(tDevice, 1, &ptSync->tInFlight[uFrame]);
+
+    // set current image index
+    ptState->tCommandComponents.uCurrentImageIndex = uImageIndex;
+
+    // get, reset, and begin command buffer
+    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
+    vkResetCommandBuffer(tCommandBuffer, 0);
+
+    VkCommandBufferBeginInfo tBeginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
+    };
+    VULKAN_CHECK(vkBeginCommandBuffer(tCommandBuffer, &tBeginInfo));
+    hg_reset_bound_state(ptState, uFrame); // a fresh command buffer has nothing bound
+    ptState->tCommandComponents.bRecording = true;
+
+    // timestamps of the frame that last used this slot are ready (its fence was waited above), then time this one
+    hg_resolve_gpu_frame(ptState, uFrame);
+    hg_reset_gpu_frame(ptState, tCommandBuffer);
+    hg_cmd_begin_gpu_scope(ptState, "frame");
+
+    HG_TRACE_END();
+
+    // closed by hg_end_frame -> everything the app records in between shows up inside it
+    HG_TRACE_BEGIN("record commands");
+    return uImageIndex;
+}
+
+void 
+hg_end_frame(hgAppData* ptState, uint32_t uImageIndex)
+{
+    HG_TRACE_END(); // "record commands"
+    HG_TRACE_BEGIN(__func__);
+    hgFrameSync* ptSync = &ptState->tSyncComponents;
+    uint32_t     uFrame = ptSync->uCurrentFrame;
+
+    // get current command buffer
+    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
+    hg_record_readbacks(ptState, tCommandBuffer, uImageIndex);
+    hg_cmd_end_gpu_scope(ptState); // "frame"
+    VULKAN_CHECK(vkEndCommandBuffer(tCommandBuffer));
+    ptState->tCommandComponents.tLastBindStats = ptState->tCommandComponents.atBoundState[uFrame].tStats;
+    ptState->tCommandComponents.bRecording     = false;
+
+    // submit command buffer
+    // headless has no acquire to wait on and no present to signal
+    VkSubmitInfo tSubmitInfo = {
+        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .waitSemaphoreCount   = ptState->bHeadless ? 0 : 1,
+        .pWaitSemaphores      = &ptSync->tImageAvailable[uFrame],
+        .pWaitDstStageMask    = (VkPipelineStageFlags[]){VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+        .commandBufferCount   = 1,
+        .pCommandBuffers      = &tCommandBuffer,
+        .signalSemaphoreCount = ptState->bHeadless ? 0 : 1,
+        .pSignalSemaphores    = &ptSync->tRenderFinished[uImageIndex]
+    };
+
+    HG_TRACE_BEGIN("vkQueueSubmit");
+    VULKAN_CHECK(vkQueueSubmit(ptState->tContextComponents.tGraphicsQueue, 1, &tSubmitInfo, ptSync->tInFlight[uFrame]));
+    HG_TRACE_END();
+    ptSync->uFrameCount++;
+    ptSync->auSubmittedFrame[uFrame] = ptSync->uFrameCount;
+    ptState->tPacingComponents.abLatencyPending[uFrame] = true;
+
+    // present (headless frames just stay in their offscreen image)
+    if(!ptState->bHeadless)
+    {
+        VkPresentInfoKHR tPresentInfo = {
+            .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores    = &ptSync->tRenderFinished[uImageIndex],
+            .swapchainCount     = 1,
+            .pSwapchains        = &ptState->tSwapchainComponents.tSwapchain,
+            .pImageIndices      = &uImageIndex
+        };
+        HG_TRACE_BEGIN("vkQueuePresentKHR");
+        VkResult tPresentResult = vkQueuePresentKHR(ptState->tContextComponents.tGraphicsQueue, &tPresentInfo);
+        HG_TRACE_END();
+        if(tPresentResult == VK_ERROR_OUT_OF_DATE_KHR || tPresentResult == VK_SUBOPTIMAL_KHR)
+        {
+            ptState->tSwapchainComponents.bNeedsRecreate = true;
+        }
+        else
+        {
+            VULKAN_CHECK(tPresentResult);
+        }
+    }
+
+    // next frame records into the next slot while the gpu works on this one
+    ptSync->uCurrentFrame = (uFrame + 1) % hg_get_frames_in_flight(ptState);
+
+    // recreate right away so a resize never costs an extra acquire (old objects retire with this frame)
+    if(ptState->tSwapchainComponents.bNeedsRecreate)
+    {
+        hg_recreate_swapchain(ptState);
+    }
+
+    // transient memory of this frame belongs to the gpu until its fence signals
+    hgTransientAllocator* ptTransient = &ptState->tTransientComponents;
+    if(ptTransient->tHead > ptTransient->tPeakUsage) ptTransient->tPeakUsage = ptTransient->tHead;
+    ptTransient->bActive = false;
+    HG_TRACE_END();
+}
+
+// -------------------------------
+// frame in flight access
+// -------------------------------
+uint32_t
+hg_get_frames_in_flight(hgAppData* ptState)
+{
+    if(ptState->uFramesInFlight == 0)                      return HG_DEFAULT_FRAMES_IN_FLIGHT;
+    if(ptState->uFramesInFlight > HG_MAX_FRAMES_IN_FLIGHT) return HG_MAX_FRAMES_IN_FLIGHT;
+    return ptState->uFramesInFlight;
+}
+
+uint32_t
+hg_get_current_frame_index(hgAppData* ptState)
+{
+    return ptState->tSyncComponents.uCurrentFrame;
+}
+
+VkCommandBuffer 
+hg_get_current_frame_cmd_buffer(hgAppData* ptState) 
+{
+    return ptState->tCommandComponents.tCommandBuffers[ptState->tSyncComponents.uCurrentFrame];
+}
+
+void
+hg_get_frame_latency(hgAppData* ptState, hgFrameLatency* ptLatencyOut)
+{
+    *ptLatencyOut = ptState->tPacingComponents.tLatency;
+}
+
+// -------------------------------
+// readback
+// -------------------------------
+bool
+hg_request_readback(hgAppData* ptState, hgReadbackCallback pfCallback, void* pUserData)
+{
+    hgReadbackRing* ptRing      = &ptState->tReadbackComponents;
+    hgSwapchain*    ptSwapchain = &ptState->tSwapchainComponents;
+
+    if(!(ptSwapchain->tImageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+    {
+        printf("readback not possible, swapchain images can't be a transfer source\n");
+        return false;
+    }
+
+    // busy slots are never waited on, a full ring just drops the request
+    hgReadbackSlot* ptSlot = NULL;
+    for(uint32_t i = 0; i < HG_READBACK_RING_SIZE; i++)
+    {
+        if(!ptRing->atSlots[i].bInUse)
+        {
+            ptSlot = &ptRing->atSlots[i];
+            break;
+        }
+    }
+    if(!ptSlot)
+    {
+        return false;
+    }
+
+    // a free slot's buffer is idle, so it can be replaced right away when the extent grew
+    VkDeviceSize tSize = (VkDeviceSize)ptSwapchain->tExtent.width * ptSwapchain->tExtent.height * 4;
+    if(ptSlot->tCapacity < tSize)
+    {
+        if(ptSlot->tBuffer != VK_NULL_HANDLE)
+        {
+            hg_destroy_buffer(ptState, &ptSlot->tBuffer, &ptSlot->tAllocation);
+        }
+        hg_create_buffer(ptState, tSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ptSlot->tBuffer, &ptSlot->tAllocation);
+        ptSlot->tCapacity = tSize;
+    }
+
+    ptSlot->uWidth     = ptSwapchain->tExtent.width;
+    ptSlot->uHeight    = ptSwapchain->tExtent.height;
+    ptSlot->tFormat    = ptSwapchain->tFormat;
+    ptSlot->uFrame     = 0;
+    ptSlot->bInUse     = true;
+    ptSlot->pfCallback = pfCallback;
+    ptSlot->pUserData  = pUserData;
+    return true;
+}
+
+bool
+hg_capture_png(hgAppData* ptState, const char* pcPath)
+{
+    hgReadbackRing* ptRing = &ptState->tReadbackComponents;
+    if(!ptRing->ptPngWriter)
+    {
+        ptRing->ptPngWriter = calloc(1, sizeof(hgPngWriter));
+        hg_mutex_init(&ptRing->ptPngWriter->tLock);
+    }
+    hgPngWriter* ptWriter = ptRing->ptPngWriter;
+
+    // captures faster than png encodes -> refuse this one instead of stalling a later hg_begin_frame on a writer
+    hgPngJob* ptJob = NULL;
+    hg_reap_png_writers(ptState, false);
+    for(uint32_t i = 0; i < HG_MAX_PNG_WRITERS && !ptJob; i++)
+    {
+        if(!ptWriter->atJobs[i].bRunning && !ptWriter->atJobs[i].bReserved) ptJob = &ptWriter->atJobs[i];
+    }
+    if(!ptJob)
+    {
+        return false;
+    }
+
+    hgPngRequest* ptRequest = malloc(sizeof(hgPngRequest));
+    ptRequest->ptState = ptState;
+    ptRequest->ptJob   = ptJob;
+    snprintf(ptRequest->acPath, sizeof(ptRequest->acPath), "%s", pcPath);
+
+    if(!hg_request_readback(ptState, hg_png_capture_callback, ptRequest))
+    {
+        free(ptRequest);
+        return false;
+    }
+    ptJob->bReserved = true;
+    return true;
+}
+
+void
+hg_flush_readbacks(hgAppData* ptState)
+{
+    HG_TRACE_BEGIN(__func__);
+    hg_deliver_readbacks(ptState, true);
+    hg_reap_png_writers(ptState, true);
+    HG_TRACE_END();
+}
+
+// -------------------------------
+// gpu profiling
+// -------------------------------
+void
+hg_cmd_begin_gpu_scope(hgAppData* ptState, const char* pcName)
+{
+    hgGpuProfiler* ptProfiler = &ptState->tProfilerComponents;
+    if(ptProfiler->tQueryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    assert(ptProfiler->uOpenCount < HG_MAX_GPU_SCOPE_DEPTH && "gpu scopes nested too deep");
+
+    // out of scopes -> still tracked on the stack so the matching end stays balanced
+    uint32_t uFrame = ptState->tSyncComponents.uCurrentFrame;
+    int32_t  iScope = -1;
+    if(ptProfiler->auScopeCount[uFrame] < HG_MAX_GPU_SCOPES)
+    {
+        iScope = (int32_t)ptProfiler->auScopeCount[uFrame]++;
+        hgGpuScope* ptScope = &ptProfiler->aatScopes[uFrame][iScope];
+        ptScope->pcName  = pcName;
+        ptScope->uDepth  = ptProfiler->uOpenCount;
+        ptScope->iParent = ptProfiler->uOpenCount > 0 ? ptProfiler->aiOpenStack[ptProfiler->uOpenCount - 1] : -1;
+        ptScope->bClosed = false;
+
+        uint32_t uQuery = (uFrame * HG_MAX_GPU_SCOPES + (uint32_t)iScope) * 2;
+        vkCmdWriteTimestamp(hg_get_current_frame_cmd_buffer(ptState), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, ptProfiler->tQueryPool, uQuery);
+    }
+    ptProfiler->aiOpenStack[ptProfiler->uOpenCount++] = iScope;
+}
+
+void
+hg_cmd_end_gpu_scope(hgAppData* ptState)
+{
+    hgGpuProfiler* ptProfiler = &ptState->tProfilerComponents;
+    if(ptProfiler->tQueryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    assert(ptProfiler->uOpenCount > 0 && "hg_cmd_end_gpu_scope without a matching begin");
+
+    int32_t iScope = ptProfiler->aiOpenStack[--ptProfiler->uOpenCount];
+    if(iScope < 0)
+    {
+        return;
+    }
+
+    uint32_t uFrame = ptState->tSyncComponents.uCurrentFrame;
+    uint32_t uQuery = (uFrame * HG_MAX_GPU_SCOPES + (uint32_t)iScope) * 2 + 1;
+    vkCmdWriteTimestamp(hg_get_current_frame_cmd_buffer(ptState), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, ptProfiler->tQueryPool, uQuery);
+    ptProfiler->aatScopes[uFrame][iScope].bClosed = true;
+}
+
+bool
+hg_get_gpu_frame_profile(hgAppData* ptState, hgGpuFrameProfile* ptProfileOut)
+{
+    hgGpuProfiler* ptProfiler = &ptState->tProfilerComponents;
+    if(ptProfiler->tQueryPool == VK_NULL_HANDLE || ptProfiler->tLastFrame.uFrame == 0)
+    {
+        return false;
+    }
+    *ptProfileOut = ptProfiler->tLastFrame;
+    return true;
+}
+
+void
+hg_print_gpu_frame_profile(hgAppData* ptState)
+{
+    hgGpuFrameProfile tProfile;
+    if(!hg_get_gpu_frame_profile(ptState, &tProfile))
+    {
+        printf("gpu profile: not available\n");
+        return;
+    }
+
+    printf("gpu profile (frame %llu):\n", (unsigned long long)tProfile.uFrame);
+    for(uint32_t i = 0; i < tProfile.uScopeCount; i++)
+    {
+        hgGpuScopeResult* ptScope = &tProfile.atScopes[i];
+        printf("  %*s%-24s %7.3f ms (avg %7.3f, max %7.3f)\n", (int)ptScope->uDepth * 2, "", ptScope->pcName, 
+            ptScope->fMs, ptScope->fAverageMs, ptScope->fMaxMs);
+    }
+    if(tProfile.tUpload.pcName)
+    {
+        printf("  %-24s %7.3f ms (avg %7.3f, max %7.3f)\n", tProfile.tUpload.pcName, 
+            tProfile.tUpload.fMs, tProfile.tUpload.fAverageMs, tProfile.tUpload.fMaxMs);
+    }
+}
+
+// -------------------------------
+// cpu tracing
+// -------------------------------
+#ifdef HG_ENABLE_TRACE
+void
+hg_trace_begin(const char* pcName)
+{
+    hgTraceBuffer* ptBuffer = gptThreadTrace ? gptThreadTrace : hg_trace_acquire_buffer();
+
+    // too deep -> counted so the matching end still pops the right scope
+    if(ptBuffer->uOpenCount < HG_TRACE_MAX_DEPTH)
+    {
+        ptBuffer->apcOpenName[ptBuffer->uOpenCount]   = pcName;
+        ptBuffer->auOpenStartNs[ptBuffer->uOpenCount] = hg_get_time_ns();
+    }
+    ptBuffer->uOpenCount++;
+}
+
+void
+hg_trace_end(void)
+{
+    hgTraceBuffer* ptBuffer = gptThreadTrace;
+    assert(ptBuffer && ptBuffer->uOpenCount > 0 && "HG_TRACE_END without a matching begin");
+
+    uint32_t uScope = --ptBuffer->uOpenCount;
+    if(uScope >= HG_TRACE_MAX_DEPTH)
+    {
+        return;
+    }
+
+    // full ring -> the oldest event goes, so a long run still exports its most recent frames
+    hgTraceEvent* ptEvent = &ptBuffer->atEvents[ptBuffer->uWritten % HG_TRACE_EVENTS_PER_THREAD];
+    ptEvent->pcName   = ptBuffer->apcOpenName[uScope];
+    ptEvent->uStartNs = ptBuffer->auOpenStartNs[uScope];
+    ptEvent->uEndNs   = hg_get_time_ns();
+    ptBuffer->uWritten++;
+}
+
+bool
+hg_trace_dump(const char* pcPath)
+{
+    FILE* pFile = fopen(pcPath, "wb");
+    if(!pFile)
+    {
+        printf("failed to write trace: %s\n", pcPath);
+        return false;
+    }
+
+    // complete ("X") events in microseconds, one track per thread
+    fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool     bFirst       = true;
+    uint64_t uOverwritten = 0;
+    hg_mutex_lock(&gtTraceLock);
+    for(hgTraceBuffer* ptBuffer = gptTraceBuffers; ptBuffer; ptBuffer = ptBuffer->ptNext)
+    {
+        fprintf(pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}", 
+            bFirst ? "" : ",\n", ptBuffer->uThreadId, ptBuffer->uThreadId == 0 ? "main" : "worker", ptBuffer->uThreadId);
+        bFirst = false;
+
+        // only the retained window, oldest first
+        uint32_t uWritten = ptBuffer->uWritten;
+        uint32_t uFirst   = uWritten > HG_TRACE_EVENTS_PER_THREAD ? uWritten - HG_TRACE_EVENTS_PER_THREAD : 0;
+        for(uint32_t i = uFirst; i < uWritten; i++)
+        {
+            // a thread still tracing may lap the dump -> an event copied while its slot was reused is skipped
+            hgTraceEvent tEvent = ptBuffer->atEvents[i % HG_TRACE_EVENTS_PER_THREAD];
+            if(ptBuffer->uWritten - i >= HG_TRACE_EVENTS_PER_THREAD)
+            {
+                continue;
+            }
+            fprintf(pFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", 
+                tEvent.pcName, ptBuffer->uThreadId, (double)(tEvent.uStartNs - guTraceStartNs) / 1000.0, 
+                (double)(tEvent.uEndNs - tEvent.uStartNs) / 1000.0);
+        }
+        uOverwritten += uFirst;
+    }
+    hg_mutex_unlock(&gtTraceLock);
+    fprintf(pFile, "\n]}\n");
+    fclose(pFile);
+
+    if(uOverwritten > 0)
+    {
+        printf("trace: %llu older scopes were overwritten, raise HG_TRACE_EVENTS_PER_THREAD for a longer window\n", 
+            (unsigned long long)uOverwritten);
+    }
+    return true;
+}
+#else
+void
+hg_trace_begin(const char* pcName)
+{
+    (void)pcName;
+}
+
+void
+hg_trace_end(void)
+{
+}
+
+bool
+hg_trace_dump(const char* pcPath)
+{
+    printf("trace not written (%s), build with -DHG_ENABLE_TRACE\n", pcPath);
+    return false;
+}
+#endif
+
+// -------------------------------
+// render pass
+// -------------------------------
+
+void 
+hg_begin_render_pass(hgAppData* ptState, uint32_t uImageIndex) 
+{
+    HG_TRACE_BEGIN(__func__);
+    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
+    hg_cmd_begin_gpu_scope(ptState, "render pass");
+    ptState->tCommandComponents.bInRenderPass = true;
+    if (ptState->bDepthEnabled) 
+    {
+        // with depth
+        // color clear values 
+        VkClearValue tClearValues[2];
+        tClearValues[0].color.float32[0] = ptState->tPipelineComponents.afClearColor[0];
+        tClearValues[0].color.float32[1] = ptState->tPipelineComponents.afClearColor[1];
+        tClearValues[0].color.float32[2] = ptState->tPipelineComponents.afClearColor[2];
+        tClearValues[0].color.float32[3] = ptState->tPipelineComponents.afClearColor[3];
+
+        // depth clear values
+        tClearValues[1].depthStencil.depth = 1.0f;
+        tClearValues[1].depthStencil.stencil = 0;
+
+        VkRenderPassBeginInfo tRenderPassInfo = {
+            .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .renderPass      = ptState->tPipelineComponents.tRenderPass,
+            .framebuffer     = ptState->tPipelineComponents.tFramebuffers[uImageIndex],
+            .renderArea      = {
+                .offset      = {0, 0},
+                .extent      = ptState->tSwapchainComponents.tExtent
+            },
+            .clearValueCount = 2,
+            .pClearValues    = tClearValues
+        };
+        vkCmdBeginRenderPass(tCommandBuffer, &tRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    }
+    else 
+    {
+        // without depth
+        VkClearValue tClearColor = {{{
+            ptState->tPipelineComponents.afClearColor[0],
+            ptState->tPipelineComponents.afClearColor[1],
+            ptState->tPipelineComponents.afClearColor[2],
+            ptState->tPipelineComponents.afClearColor[3]
+        }}};
+
+        VkRenderPassBeginInfo tRenderPassInfo = {
+            .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .renderPass      = ptState->tPipelineComponents.tRenderPass,
+            .framebuffer     = ptState->tPipelineComponents.tFramebuffers[uImageIndex],
+            .renderArea      = {
+                .offset      = {0, 0},
+                .extent      = ptState->tSwapchainComponents.tExtent
+            },
+            .clearValueCount = 1,
+            .pClearValues    = &tClearColor
+        };
+        vkCmdBeginRenderPass(tCommandBuffer, &tRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    // pipelines use dynamic viewport/scissor -> default both to the whole swapchain image
+    VkExtent2D tExtent = ptState->tSwapchainComponents.tExtent;
+    hg_cmd_set_viewport(ptState, 0.0f, 0.0f, (float)tExtent.width, (float)tExtent.height);
+    hg_cmd_set_scissor(ptState, 0, 0, tExtent.width, tExtent.height);
+    HG_TRACE_END();
+}
+
+void
+hg_end_render_pass(hgAppData* ptState)
+{
+    HG_TRACE_BEGIN(__func__);
+    vkCmdEndRenderPass(hg_get_current_frame_cmd_buffer(ptState));
+    hg_cmd_end_gpu_scope(ptState); // "render pass"
+    ptState->tCommandComponents.bInRenderPass = false;
+    HG_TRACE_END();
+}
+
+// -------------------------------
+// dynamic state
+// -------------------------------
+void
+hg_cmd_set_viewport(hgAppData* ptState, float fX, float fY, float fWidth, float fHeight)
+{
+    VkViewport tViewport = {
+        .x        = fX,
+        .y        = fY,
+        .width    = fWidth,
+        .height   = fHeight,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f
+    };
+    vkCmdSetViewport(hg_get_current_frame_cmd_buffer(ptState), 0, 1, &tViewport);
+}
+
+void
+hg_cmd_set_scissor(hgAppData* ptState, int32_t iX, int32_t iY, uint32_t uWidth, uint32_t uHeight)
+{
+    VkRect2D tScissor = {
+        .offset = {iX, iY},
+        .extent = {uWidth, uHeight}
+    };
+    vkCmdSetScissor(hg_get_current_frame_cmd_buffer(ptState), 0, 1, &tScissor);
+}
+
+// -------------------------------
+// bind state
+// -------------------------------
+
+void 
+hg_cmd_bind_pipeline(hgAppData* ptState, hgPipeline* tPipeline)
+{
+    hgBoundState* ptBound = hg_get_bound_state(ptState);
+    hg_track_pipeline_layout(ptBound, tPipeline->tPipelineLayout);
+    if(ptBound->tPipeline == tPipeline->tPipeline)
+    {
+        ptBound->tStats.uBindsSkipped++;
+        return;
+    }
+
+    vkCmdBindPipeline(hg_get_current_frame_cmd_buffer(ptState), tPipeline->tPipelineBindPoint, tPipeline->tPipeline);
+    ptBound->tPipeline = tPipeline->tPipeline;
+    ptBound->tStats.uBindsIssued++;
+}
+
+void
+hg_cmd_bind_vertex_buffer(hgAppData* ptState, hgVertexBuffer* tVertexBuffer)
+{
+    hg_cmd_bind_vertex_stream(ptState, 0, tVertexBuffer->tBuffer, 0);
+}
+
+void
+hg_cmd_bind_transient_vertex_buffer(hgAppData* ptState, hgTransientAllocation* tVertices)
+{
+    hg_cmd_bind_vertex_stream(ptState, 0, tVertices->tBuffer, tVertices->tOffset);
+}
+
+void
+hg_cmd_bind_vertex_stream(hgAppData* ptState, uint32_t uBinding, VkBuffer tBuffer, VkDeviceSize tOffset)
+{
+    assert(uBinding < HG_MAX_VERTEX_BINDINGS && "raise HG_MAX_VERTEX_BINDINGS");
+    hgBoundState* ptBound = hg_get_bound_state(ptState);
+    if(ptBound->atVertexBuffers[uBinding] == tBuffer && ptBound->atVertexOffsets[uBinding] == tOffset)
+    {
+        ptBound->tStats.uBindsSkipped++;
+        return;
+    }
+
+    vkCmdBindVertexBuffers(hg_get_current_frame_cmd_buffer(ptState), uBinding, 1, &tBuffer, &tOffset);
+    ptBound->atVertexBuffers[uBinding] = tBuffer;
+    ptBound->atVertexOffsets[uBinding] = tOffset;
+    ptBound->tStats.uBindsIssued++;
+}
+
+void
+hg_cmd_bind_index_buffer(hgAppData* ptState, hgIndexBuffer* tIndexBuffer)
+{
+    hg_track_index_buffer(ptState, tIndexBuffer->tBuffer, 0, tIndexBuffer->tIndexType);
+}
+
+void
+hg_cmd_bind_descriptor_sets(hgAppData* ptState, hgPipeline* tPipeline, uint32_t uFirstSet, VkDescriptorSet* tDescriptorSets, uint32_t uSetCount,
+                            const uint32_t* auDynamicOffsets, uint32_t uDynamicOffsetCount)
+{
+    assert(uFirstSet + uSetCount <= HG_MAX_BOUND_DESCRIPTOR_SETS && "raise HG_MAX_BOUND_DESCRIPTOR_SETS");
+    assert(uDynamicOffsetCount <= HG_MAX_DYNAMIC_OFFSETS && "raise HG_MAX_DYNAMIC_OFFSETS");
+
+    hgBoundState* ptBound = hg_get_bound_state(ptState);
+    hg_track_pipeline_layout(ptBound, tPipeline->tPipelineLayout);
+
+    // dynamic offsets can't be split per set -> with offsets only an identical earlier call counts as redundant
+    bool bRedundant = true;
+    for(uint32_t i = 0; i < uSetCount && bRedundant; i++)
+    {
+        hgBoundDescriptorSet* ptSlot = &ptBound->atSets[uFirstSet + i];
+        if(ptSlot->tSet != tDescriptorSets[i])
+        {
+            bRedundant = false;
+        }
+        else if(uDynamicOffsetCount == 0)
+        {
+            bRedundant = ptSlot->uDynamicOffsetCount == 0;
+        }
+        else
+        {
+            bRedundant = ptSlot->uFirstSet == uFirstSet && ptSlot->uSetCount == uSetCount &&
+                         ptSlot->uDynamicOffsetCount == uDynamicOffsetCount &&
+                         memcmp(ptSlot->auDynamicOffsets, auDynamicOffsets, uDynamicOffsetCount * sizeof(uint32_t)) == 0;
+        }
+    }
+    if(bRedundant)
+    {
+        ptBound->tStats.uBindsSkipped++;
+        return;
+    }
+
+    vkCmdBindDescriptorSets(hg_get_current_frame_cmd_buffer(ptState), tPipeline->tPipelineBindPoint, tPipeline->tPipelineLayout,
+                            uFirstSet, uSetCount, tDescriptorSets, uDynamicOffsetCount, auDynamicOffsets);
+    for(uint32_t i = 0; i < uSetCount; i++)
+    {
+        hgBoundDescriptorSet* ptSlot = &ptBound->atSets[uFirstSet + i];
+        ptSlot->tSet                = tDescriptorSets[i];
+        ptSlot->uFirstSet           = uFirstSet;
+        ptSlot->uSetCount           = uSetCount;
+        ptSlot->uDynamicOffsetCount = uDynamicOffsetCount;
+        if(uDynamicOffsetCount > 0) memcpy(ptSlot->auDynamicOffsets, auDynamicOffsets, uDynamicOffsetCount * sizeof(uint32_t));
+    }
+    ptBound->tStats.uBindsIssued++;
+}
+
+void
+hg_cmd_push_constants(hgAppData* ptState, hgPipeline* tPipeline, VkShaderStageFlags tStages, uint32_t uOffset, uint32_t uSize, const void* pData)
+{
+    uint32_t uMaxPushConstantsSize = ptState->tContextComponents.tDeviceProperties.limits.maxPushConstantsSize;
+    if(uOffset + uSize > uMaxPushConstantsSize)
+    {
+        printf("Push constants (%u bytes at %u) exceed maxPushConstantsSize (%u)!\n", uSize, uOffset, uMaxPushConstantsSize);
+        exit(1);
+    }
+
+    // the layout has to declare what we push, otherwise this is undefined behaviour rather than an error
+    assert(uOffset % 4 == 0 && uSize % 4 == 0);
+    assert((tStages & ~tPipeline->tPushConstantStages) == 0 && "stages not covered by the pipeline's push constant ranges");
+    assert(uOffset + uSize <= tPipeline->uPushConstantSize && "push outside the pipeline's push constant ranges");
+
+    hgBoundState* ptBound = hg_get_bound_state(ptState);
+    hg_track_pipeline_layout(ptBound, tPipeline->tPipelineLayout);
+
+    // compared word by word against what was last pushed with the same stages, bytes past the shadow are always pushed
+    uint32_t uFirstWord = uOffset / 4;
+    uint32_t uWordCount = uSize / 4;
+    bool     bRedundant = uOffset + uSize <= HG_MAX_TRACKED_PUSH_BYTES;
+    for(uint32_t i = 0; i < uWordCount && bRedundant; i++)
+    {
+        bRedundant = ptBound->atPushStages[uFirstWord + i] == tStages;
+    }
+    if(bRedundant && memcmp(&ptBound->auPushBytes[uOffset], pData, uSize) == 0)
+    {
+        ptBound->tStats.uBindsSkipped++;
+        return;
+    }
+
+    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
+    vkCmdPushConstants(tCommandBuffer, tPipeline->tPipelineLayout, tStages, uOffset, uSize, pData);
+    for(uint32_t i = 0; i < uWordCount && uFirstWord + i < HG_MAX_TRACKED_PUSH_BYTES / 4; i++)
+    {
+        ptBound->atPushStages[uFirstWord + i] = tStages;
+        memcpy(&ptBound->auPushBytes[(uFirstWord + i) * 4], (const uint8_t*)pData + i * 4, 4);
+    }
+    ptBound->tStats.uBindsIssued++;
+}
+
+void
+hg_cmd_invalidate_bound_state(hgAppData* ptState)
+{
+    hgBoundState* ptBound = hg_get_bound_state(ptState);
+    hgBindStats   tStats  = ptBound->tStats;
+    memset(ptBound, 0, sizeof(hgBoundState));
+    ptBound->tStats = tStats;
+}
+
+void
+hg_get_bind_stats(hgAppData* ptState, hgBindStats* ptStatsOut)
+{
+    *ptStatsOut = ptState->tCommandComponents.tLastBindStats;
+}
+
+void
+hg_cmd_bind_geometry_pool(hgAppData* ptState, hgGeometryPool* tPool)
+{
+    hg_cmd_bind_vertex_stream(ptState, 0, tPool->tVertexBuffer, 0);
+    hg_track_index_buffer(ptState, tPool->tIndexBuffer, 0, tPool->tIndexType);
+}
+
+// -------------------------------
+// draw commands
+// -------------------------------
+void
+hg_cmd_draw(hgAppData* ptState, uint32_t uVertexCount, uint32_t uFirstVertex)
+{
+    hg_cmd_draw_instanced(ptState, uVertexCount, 1, uFirstVertex, 0);
+}
+
+void
+hg_cmd_draw_indexed(hgAppData* ptState, uint32_t uIndexCount, uint32_t uFirstIndex, int32_t iVertexOffset)
+{
+    hg_cmd_draw_indexed_instanced(ptState, uIndexCount, 1, uFirstIndex, iVertexOffset, 0);
+}
+
+void
+hg_cmd_draw_instanced(hgAppData* ptState, uint32_t uVertexCount, uint32_t uInstanceCount, uint32_t uFirstVertex, uint32_t uFirstInstance)
+{
+    vkCmdDraw(hg_get_current_frame_cmd_buffer(ptState), uVertexCount, uInstanceCount, uFirstVertex, uFirstInstance);
+    hgBindStats* ptStats = &hg_get_bound_state(ptState)->tStats;
+    ptStats->uDraws++;
+    ptStats->uInstances += uInstanceCount;
+}
+
+void
+hg_cmd_draw_indexed_indirect(hgAppData* ptState, VkBuffer tBuffer, VkDeviceSize tOffset, uint32_t uDrawCount)
+{
+    // without multiDrawIndirect drawCount has to be 0 or 1 -> one call per command gives the same result
+    VkCommandBuffer tCommandBuffer = hg_get_current_frame_cmd_buffer(ptState);
+    const uint32_t  uStride        = sizeof(VkDrawIndexedIndirectCommand);
+    uint32_t        uMaxPerCall    = hg_supports_multi_draw_indirect(ptState) ? ptState->tContextComponents.tDeviceProperties.limits.maxDrawIndirectCount : 1;
+    for(uint32_t uFirst = 0; uFirst < uDrawCount; uFirst += uMaxPerCall)
+    {
+        uint32_t uCount = uDrawCount - uFirst < uMaxPerCall ? uDrawCount - uFirst : uMaxPerCall;
+        vkCmdDrawIndexedIndirect(tCommandBuffer, tBuffer, tOffset + (VkDeviceSize)uFirst * uStride, uCount, uStride);
+    }
+    hg_get_bound_state(ptState)->tStats.uDraws += uDrawCount;
+}
+
+void
+hg_cmd_draw_indexed_indirect_count(hgAppData* ptState, VkBuffer tBuffer, VkDeviceSize tOffset, VkBuffer tCountBuffer, VkDeviceSize tCountOffset, uint32_t uMaxDrawCount)
+{
+    PFN_vkCmdDrawIndexedIndirectCountKHR pfnDrawCount = ptState->tContextComponents.pfnCmdDrawIndexedIndirectCount;
+    if(pfnDrawCount == NULL)
+    {
+        // the count lives in gpu memory, so the best the fallback can do is draw every slot
+        hg_cmd_draw_indexed_indirect(ptState, tBuffer, tOffset, uMaxDrawCount);
+        return;
+    }
+
+    pfnDrawCount(hg_get_current_frame_cmd_buffer(ptState), tBuffer, tOffset, tCountBuffer, tCountOffset, uMaxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+    hg_get_bound_state(ptState)->tStats.uDraws += uMaxDrawCount; // upper bound, the real count is only known to the gpu
+}
+
+void
+hg_cmd_draw_indexed_instanced(hgAppData* ptState, uint32_t uIndexCount, uint32_t uInstanceCount, uint32_t uFirstIndex, int32_t iVertexOffset, uint32_t uFirstInstance)
+{
+    vkCmdDrawIndexed(hg_get_current_frame_cmd_buffer(ptState), uIndexCount, uInstanceCount, uFirstIndex, iVertexOffset, uFirstInstance);
+    hgBindStats* ptStats = &hg_get_bound_state(ptState)->tStats;
+    ptStats->uDraws++;
+    ptStats->uInstances += uInstanceCount;
+}
+
+void
+hg_cmd_draw_pool_mesh(hgAppData* ptState, hgGeometryPool* tPool, hgMeshHandle tMesh, uint32_t uInstanceCount, uint32_t uFirstInstance)
+{
+    const hgMesh* ptMesh = hg_get_mesh(tPool, tMesh);
+    hg_cmd_bind_geometry_pool(ptState, tPool);
+    hg_cmd_draw_indexed_instanced(ptState, ptMesh->uIndexCount, uInstanceCount, ptMesh->uFirstIndex, ptMesh->iVertexOffset, uFirstInstance);
+}
+
+// -------------------------------
+// render queue
+// -------------------------------
+hgRenderQueue
+hg_create_render_queue(uint32_t uInitialCapacity)
+{
+    hgRenderQueue tNewQueue = {0};
+    tNewQueue.uCapacity = uInitialCapacity;
+    if(uInitialCapacity > 0)
+    {
+        tNewQueue.atPackets = malloc(uInitialCapacity * sizeof(hgDrawPacket));
+        tNewQueue.atEntries = malloc(uInitialCapacity * sizeof(hgRenderQueueEntry));
+        tNewQueue.atScratch = malloc(uInitialCapacity * sizeof(hgRenderQueueEntry));
+    }
+    return tNewQueue;
+}
+
+hgSortKey
+hg_make_sort_key(uint8_t uLayer, uint16_t uPipelineId, uint16_t uMaterialId, float fDepth, bool bTransparent)
+{
+    // clamped so anything past the planes still sorts to the ends
+    if(fDepth < 0.0f) fDepth = 0.0f;
+    if(fDepth > 1.0f) fDepth = 1.0f;
+    uint64_t uDepth = (uint64_t)((double)fDepth * (double)HG_SORT_KEY_DEPTH_MAX);
+
+    // the translucency bit keeps the two layouts apart -> their lower bits mean different things and must never interleave
+    // blending needs far to near across the whole layer, so depth goes above the state bits there
+    if(bTransparent)
+    {
+        return ((uint64_t)uLayer << 56) | (1ull << 55) | ((HG_SORT_KEY_DEPTH_MAX - uDepth) << 32) | ((uint64_t)uPipelineId << 16) | uMaterialId;
+    }
+    return ((uint64_t)uLayer << 56) | ((uint64_t)uPipelineId << 39) | ((uint64_t)uMaterialId << 23) | uDepth;
+}
+
+void
+hg_set_packet_mesh(hgDrawPacket* ptPacket, hgVertexBuffer* tVertexBuffer, hgIndexBuffer* tIndexBuffer)
+{
+    ptPacket->tVertexBuffer = tVertexBuffer->tBuffer;
+    ptPacket->tVertexOffset = 0;
+    ptPacket->tIndexBuffer  = tIndexBuffer->tBuffer;
+    ptPacket->tIndexType    = tIndexBuffer->tIndexType;
+    ptPacket->uCount        = tIndexBuffer->uIndexCount;
+    ptPacket->uFirst        = 0;
+    ptPacket->iVertexOffset = 0;
+}
+
+void
+hg_set_packet_pool_mesh(hgDrawPacket* ptPacket, hgGeometryPool* tPool, hgMeshHandle tMesh)
+{
+    const hgMesh* ptMesh = hg_get_mesh(tPool, tMesh);
+    ptPacket->tVertexBuffer = tPool->tVertexBuffer;
+    ptPacket->tVertexOffset = 0;
+    ptPacket->tIndexBuffer  = tPool->tIndexBuffer;
+    ptPacket->tIndexType    = tPool->tIndexType;
+    ptPacket->uCount        = ptMesh->uIndexCount;
+    ptPacket->uFirst        = ptMesh->uFirstIndex;
+    ptPacket->iVertexOffset = ptMesh->iVertexOffset;
+}
+
+void
+hg_queue_draw(hgRenderQueue* ptQueue, hgSortKey uKey, const hgDrawPacket* ptPacket)
+{
+    assert(ptPacket->ptPipeline && "draw packet without a pipeline");
+    assert(ptPacket->uSetCount <= HG_MAX_PACKET_SETS && ptPacket->uPushSize <= HG_MAX_PACKET_PUSH_BYTES);
+    assert(ptPacket->uDynamicOffsetCount <= HG_MAX_PACKET_SETS && "more dynamic offsets than hgDrawPacket::auDynamicOffsets holds");
+
+    if(ptQueue->uCount == ptQueue->uCapacity)
+    {
+        ptQueue->uCapacity = ptQueue->uCapacity ? ptQueue->uCapacity * 2 : 256;
+        ptQueue->atPackets = realloc(ptQueue->atPackets, ptQueue->uCapacity * sizeof(hgDrawPacket));
+        ptQueue->atEntries = realloc(ptQueue->atEntries, ptQueue->uCapacity * sizeof(hgRenderQueueEntry));
+        ptQueue->atScratch = realloc(ptQueue->atScratch, ptQueue->uCapacity * sizeof(hgRenderQueueEntry));
+    }
+    ptQueue->atPackets[ptQueue->uCount] = *ptPacket;
+    ptQueue->atEntries[ptQueue->uCount] = (hgRenderQueueEntry){uKey, ptQueue->uCount};
+    ptQueue->uCount++;
+}
+
+void
+hg_cmd_submit_render_queue(hgAppData* ptState, hgRenderQueue* ptQueue)
+{
+    HG_TRACE_BEGIN(__func__);
+    const hgRenderQueueEntry* atSorted = hg_radix_sort_entries(ptQueue->atEntries, ptQueue->atScratch, ptQueue->uCount);
+
+    // every packet binds everything it needs, the tracker turns that into only the changes between neighbours
+    for(uint32_t i = 0; i < ptQueue->uCount; i++)
+    {
+        hgDrawPacket* ptPacket = &ptQueue->atPackets[atSorted[i].uPacket];
+        hg_cmd_bind_pipeline(ptState, ptPacket->ptPipeline);
+        if(ptPacket->uSetCount > 0)
+        {
+            hg_cmd_bind_descriptor_sets(ptState, ptPacket->ptPipeline, 0, ptPacket->atSets, ptPacket->uSetCount, 
+                                        ptPacket->auDynamicOffsets, ptPacket->uDynamicOffsetCount);
+        }
+        if(ptPacket->uPushSize > 0)
+        {
+            hg_cmd_push_constants(ptState, ptPacket->ptPipeline, ptPacket->tPushStages, 0, ptPacket->uPushSize, ptPacket->auPushData);
+        }
+        if(ptPacket->tVertexBuffer != VK_NULL_HANDLE)   hg_cmd_bind_vertex_stream(ptState, 0, ptPacket->tVertexBuffer, ptPacket->tVertexOffset);
+        if(ptPacket->tInstanceBuffer != VK_NULL_HANDLE) hg_cmd_bind_vertex_stream(ptState, ptPacket->uInstanceBinding, ptPacket->tInstanceBuffer, ptPacket->tInstanceOffset);
+
+        uint32_t uInstanceCount = ptPacket->uInstanceCount ? ptPacket->uInstanceCount : 1;
+        if(ptPacket->tIndexBuffer != VK_NULL_HANDLE)
+        {
+            hg_track_index_buffer(ptState, ptPacket->tIndexBuffer, 0, ptPacket->tIndexType);
+            hg_cmd_draw_indexed_instanced(ptState, ptPacket->uCount, uInstanceCount, ptPacket->uFirst, ptPacket->iVertexOffset, ptPacket->uFirstInstance);
+        }
+        else
+        {
+            hg_cmd_draw_instanced(ptState, ptPacket->uCount, uInstanceCount, ptPacket->uFirst, ptPacket->uFirstInstance);
+        }
+    }
+
+    ptQueue->uCount = 0;
+    HG_TRACE_END();
+}
+
+// -------------------------------
+// convenience wrappers
+// -------------------------------
+void
+hg_draw_mesh(hgAppData* ptState, hgVertexBuffer* tVertexBuffer, hgIndexBuffer* tIndexBuffer, uint32_t uIndexCount)
+{
+    // the binds are filtered, so drawing the same mesh over and over only costs the draw
+    hg_cmd_bind_vertex_buffer(ptState, tVertexBuffer);
+    hg_cmd_bind_index_buffer(ptState, tIndexBuffer);
+    hg_cmd_draw_indexed(ptState, uIndexCount ? uIndexCount : tIndexBuffer->uIndexCount, 0, 0);
+}
+
+// =============================================================================
+// CLEANUP
+// =============================================================================
+
+void 
+hg_core_cleanup(hgAppData* ptState)
+{
+    if (!ptState) return;
+    HG_TRACE_BEGIN(__func__);
+    vkDeviceWaitIdle(ptState->tContextComponents.tDevice);
+
+    // screenshots of the last frames still get written
+    hg_flush_readbacks(ptState);
+    hg_cleanup_swapchain_resources(ptState); // handles swapchain and related components
+
+    // destroy surface (not in swapchain resources function)
+    if (ptState->tSwapchainComponents.tSurface != VK_NULL_HANDLE) 
+    {
+        vkDestroySurfaceKHR(ptState->tContextComponents.tInstance, ptState->tSwapchainComponents.tSurface, NULL);
+        ptState->tSwapchainComponents.tSurface = VK_NULL_HANDLE;
+    }
+
+    // cleanup Pipeline Components (except framebuffers) -> note: framebuffers already destroyed by hg_cleanup_swapchain_resources()
+    // destroy render pass
+    if (ptState->tPipelineComponents.tRenderPass != VK_NULL_HANDLE) 
+    {
+        vkDestroyRenderPass(ptState->tContextComponents.tDevice, ptState->tPipelineComponents.tRenderPass, NULL);
+        ptState->tPipelineComponents.tRenderPass = VK_NULL_HANDLE;
+    }
+
+    // upload command buffers come from the command pools below
+    hg_destroy_upload_context(ptState);
+
+    // Cleanup Command Components -> note: frame command buffers are freed with the pool
+    // destroy command pool
+    if (ptState->tCommandComponents.tCommandPool != VK_NULL_HANDLE) 
+    {
+        vkDestroyCommandPool(ptState->tContextComponents.tDevice, ptState->tCommandComponents.tCommandPool, NULL);
+        ptState->tCommandComponents.tCommandPool = VK_NULL_HANDLE;
+    }
+    if (ptState->tCommandComponents.tTransferCommandPool != VK_NULL_HANDLE) 
+    {
+        vkDestroyCommandPool(ptState->tContextComponents.tDevice, ptState->tCommandComponents.tTransferCommandPool, NULL);
+        ptState->tCommandComponents.tTransferCommandPool = VK_NULL_HANDLE;
+    }
+
+    // cleanup Sync Components
+    for (uint32_t i = 0; i < HG_MAX_FRAMES_IN_FLIGHT; i++) 
+    {
+        if (ptState->tSyncComponents.tImageAvailable[i] != VK_NULL_HANDLE) 
+        {
+            vkDestroySemaphore(ptState->tContextComponents.tDevice, ptState->tSyncComponents.tImageAvailable[i], NULL);
+            ptState->tSyncComponents.tImageAvailable[i] = VK_NULL_HANDLE;
+        }
+        if (ptState->tSyncComponents.tInFlight[i] != VK_NULL_HANDLE) 
+        {
+            vkDestroyFence(ptState->tContextComponents.tDevice, ptState->tSyncComponents.tInFlight[i], NULL);
+            ptState->tSyncComponents.tInFlight[i] = VK_NULL_HANDLE;
+        }
+    }
+    hg_destroy_image_sync_objects(ptState);
+
+    // staging ring, transient memory and readback buffers live in the allocator so they go first
+    hg_destroy_staging_ring(ptState);
+    hg_destroy_transient_allocator(ptState);
+    hg_destroy_readback_ring(ptState);
+
+    // release the memory blocks -> every resource should be destroyed by now
+    hg_destroy_allocator(ptState);
+
+    // write the cache back for the next run
+    hg_destroy_shader_cache(ptState);
+    hg_save_pipeline_cache(ptState);
+    hg_destroy_pipeline_cache(ptState);
+    hg_destroy_gpu_profiler(ptState);
+    hg_destroy_frame_pacing(ptState);
+
+    // cleanup Vulkan Context (device and instance)
+    // note: physical device doesn't need to be destroyed
+    if (ptState->tContextComponents.tDevice != VK_NULL_HANDLE) 
+    {
+        vkDestroyDevice(ptState->tContextComponents.tDevice, NULL);
+        ptState->tContextComponents.tDevice = VK_NULL_HANDLE;
+    }
+    if (ptState->tContextComponents.tInstance != VK_NULL_HANDLE) 
+    {
+        vkDestroyInstance(ptState->tContextComponents.tInstance, NULL);
+        ptState->tContextComponents.tInstance = VK_NULL_HANDLE;
+    }
+
+    // reset counts and state
+    ptState->tSwapchainComponents.uSwapchainImageCount = 0;
+    ptState->tCommandComponents.uCurrentImageIndex = 0;
+    ptState->width = 0;
+    ptState->height = 0;
+
+    // note: GLFW window cleanup should be done separately by the application
+    HG_TRACE_END();
+}
+
+void
+hg_cleanup_swapchain_resources(hgAppData* ptState) 
+{
+    // same path as recreation, just without waiting for fences -> caller guarantees the device is idle
+    hgRetiredSwapchain tCurrent = {0};
+    hg_retire_swapchain_resources(ptState, &tCurrent);
+    tCurrent.tSwapchain = ptState->tSwapchainComponents.tSwapchain;
+    ptState->tSwapchainComponents.tSwapchain = VK_NULL_HANDLE;
+    hg_destroy_retired_swapchain(ptState, &tCurrent);
+
+    hg_collect_retired_swapchains(ptState, true);
+}
+
+void 
+hg_destroy_texture(hgAppData* ptAppData, hgTexture* tTexture)
+{
+    if(tTexture->tImageView != VK_NULL_HANDLE) vkDestroyImageView(ptAppData->tContextComponents.tDevice, tTexture->tImageView, NULL);
+    if(tTexture->tImage != VK_NULL_HANDLE)     vkDestroyImage(ptAppData->tContextComponents.tDevice, tTexture->tImage, NULL);
+    hg_free_memory(ptAppData, &tTexture->tAllocation);
+
+    memset(tTexture, 0, sizeof(hgTexture));
+}
+
+void
+hg_destroy_vertex_buffer(hgAppData* ptState, hgVertexBuffer* tVertexBuffer)
+{
+    hg_destroy_buffer(ptState, &tVertexBuffer->tBuffer, &tVertexBuffer->tAllocation);
+    tVertexBuffer->pDataMapped = NULL;
+}
+
+void
+hg_destroy_index_buffer(hgAppData* ptState, hgIndexBuffer* tIndexBuffer)
+{
+    hg_destroy_buffer(ptState, &tIndexBuffer->tBuffer, &tIndexBuffer->tAllocation);
+}
+
+void
+hg_destroy_indirect_buffer(hgAppData* ptState, hgIndirectBuffer* tIndirectBuffer)
+{
+    hg_destroy_buffer(ptState, &tIndirectBuffer->tBuffer, &tIndirectBuffer->tAllocation);
+}
+
+void
+hg_destroy_geometry_pool(hgAppData* ptState, hgGeometryPool* tPool)
+{
+    hg_destroy_buffer(ptState, &tPool->tVertexBuffer, &tPool->tVertexAllocation);
+    hg_destroy_buffer(ptState, &tPool->tIndexBuffer, &tPool->tIndexAllocation);
+    free(tPool->tFreeVertices.atRanges);
+    free(tPool->tFreeIndices.atRanges);
+    free(tPool->atMeshes);
+    free(tPool->atRetired);
+    for(uint32_t i = 0; i < tPool->uRetiredBufferCount; i++)
+    {
+        hg_destroy_buffer(ptState, &tPool->atRetiredBuffers[i].tVertexBuffer, &tPool->atRetiredBuffers[i].tVertexAllocation);
+        hg_destroy_buffer(ptState, &tPool->atRetiredBuffers[i].tIndexBuffer, &tPool->atRetiredBuffers[i].tIndexAllocation);
+    }
+    free(tPool->atRetiredBuffers);
+    memset(tPool, 0, sizeof(hgGeometryPool));
+}
+
+void
+hg_destroy_render_queue(hgRenderQueue* tQueue)
+{
+    free(tQueue->atPackets);
+    free(tQueue->atEntries);
+    free(tQueue->atScratch);
+    memset(tQueue, 0, sizeof(hgRenderQueue));
+}
+
+void 
+hg_destroy_pipeline(hgAppData* ptAppData, hgPipeline* tPipeline)
+{
+    if(tPipeline->tPipeline != VK_NULL_HANDLE)       vkDestroyPipeline      (ptAppData->tContextComponents.tDevice, tPipeline->tPipeline, NULL);
+    if(tPipeline->tPipelineLayout != VK_NULL_HANDLE) vkDestroyPipelineLayout(ptAppData->tContextComponents.tDevice, tPipeline->tPipelineLayout, NULL);
+
+};
+
+// =============================================================================
+// INTERNAL HELPERS
+// =============================================================================
+
+// -------------------------------
+// memory & buffer helpers
+// -------------------------------
+uint32_t 
+hg_find_memory_type(hgVulkanContext* ptContext, uint32_t uTypeFilter, VkMemoryPropertyFlags tProperties)
+{
+    VkPhysicalDeviceMemoryProperties tMemProperties;
+    vkGetPhysicalDeviceMemoryProperties(ptContext->tPhysicalDevice, &tMemProperties);
+
+    for(uint32_t i = 0; i < tMemProperties.memoryTypeCount; i++) 
+    {
+        if((uTypeFilter & (1 << i)) && (tMemProperties.memoryTypes[i].propertyFlags & tProperties) == tProperties)
+        {
+            return i;
+        }
+    }
+    printf("Failed to find suitable memory type!\n");
+    exit(1);
+}
+
+// -------------------------------
+// device memory allocator
+// -------------------------------
+void
+hg_init_allocator(hgAppData* ptState)
+{
+    hgMemoryAllocator* ptAllocator = &ptState->tMemoryComponents;
+    vkGetPhysicalDeviceMemoryProperties(ptState->tContextComponents.tPhysicalDevice, &ptAllocator->tMemProperties);
+
+    ptAllocator->tBufferImageGranularity = ptState->tContextComponents.tDeviceProperties.limits.bufferImageGranularity;
+    ptAllocator->tBlockSize              = HG_DEFAULT_MEMORY_BLOCK_SIZE;
+    ptAllocator->aptBlocks               = NULL;
+    ptAllocator->uBlockCount             = 0;
+    ptAllocator->uBlockCapacity          = 0;
+}
+
+void
+hg_destroy_allocator(hgAppData* ptState)
+{
+    hgMemoryAllocator* ptAllocator = &ptState->tMemoryComponents;
+
+    while(ptAllocator->uBlockCount > 0)
+    {
+        hgMemoryBlock* ptBlock = ptAllocator->aptBlocks[ptAllocator->uBlockCount - 1];
+        if(ptBlock->uAllocationCount > 0)
+        {
+            printf("memory block still has %u live allocations at shutdown (resource not destroyed?)\n", ptBlock->uAllocationCount);
+        }
+        hg_destroy_memory_block(ptState, ptBlock);
+    }
+
+    free(ptAllocator->aptBlocks);
+    ptAllocator->aptBlocks      = NULL;
+    ptAllocator->uBlockCapacity = 0;
+}
+
+void
+hg_allocate_memory(hgAppData* ptState, const VkMemoryRequirements* ptRequirements, VkMemoryPropertyFlags tProperties, bool bLinear, hgAllocation* ptAllocationOut)
+{
+    hgMemoryAllocator* ptAllocator = &ptState->tMemoryComponents;
+    uint32_t uMemoryType = hg_find_memory_type(&ptState->tContextComponents, ptRequirements->memoryTypeBits, tProperties);
+
+    // buffers and optimal images only have to live in separate blocks if the device has a granularity restriction
+    bool bSeparateKinds = ptAllocator->tBufferImageGranularity > 1;
+
+    hgMemoryBlock* ptTarget = NULL;
+    VkDeviceSize   tOffset  = 0;
+
+    // try existing blocks first
+    for(uint32_t i = 0; i < ptAllocator->uBlockCount; i++)
+    {
+        hgMemoryBlock* ptBlock = ptAllocator->aptBlocks[i];
+        if(ptBlock->uMemoryTypeIndex != uMemoryType || ptBlock->bDedicated)  continue;
+        if(bSeparateKinds && ptBlock->bLinear != bLinear)                     continue;
+        if(ptBlock->tSize - ptBlock->tUsed < ptRequirements->size)           continue;
+
+        if(hg_range_list_allocate(&ptBlock->tFreeRanges, ptRequirements->size, ptRequirements->alignment, &tOffset))
+        {
+            ptTarget = ptBlock;
+            break;
+        }
+    }
+
+    // nothing fits -> new block (small heaps get smaller blocks so one block can't eat the whole heap)
+    if(ptTarget == NULL)
+    {
+        uint32_t     uHeapIndex = ptAllocator->tMemProperties.memoryTypes[uMemoryType].heapIndex;
+        VkDeviceSize tHeapSize  = ptAllocator->tMemProperties.memoryHeaps[uHeapIndex].size;
+        VkDeviceSize tBlockSize = ptAllocator->tBlockSize;
+        if(tBlockSize > tHeapSize / 8) tBlockSize = tHeapSize / 8;
+
+        // anything bigger than half a block gets its own memory instead of wasting the rest of a block
+        bool bDedicated = ptRequirements->size > tBlockSize / 2;
+        ptTarget = hg_create_memory_block(ptState, uMemoryType, bDedicated ? ptRequirements->size : tBlockSize, bLinear, bDedicated);
+
+        bool bResult = hg_range_list_allocate(&ptTarget->tFreeRanges, ptRequirements->size, ptRequirements->alignment, &tOffset);
+        assert(bResult);
+        (void)bResult;
+    }
+
+    ptTarget->tUsed += ptRequirements->size;
+    ptTarget->uAllocationCount++;
+
+    ptAllocationOut->ptBlock = ptTarget;
+    ptAllocationOut->tMemory = ptTarget->tMemory;
+    ptAllocationOut->tOffset = tOffset;
+    ptAllocationOut->tSize   = ptRequirements->size;
+    ptAllocationOut->pMapped = ptTarget->pMapped ? (char*)ptTarget->pMapped + tOffset : NULL;
+}
+
+void
+hg_free_memory(hgAppData* ptState, hgAllocation* ptAllocation)
+{
+    hgMemoryBlock* ptBlock = ptAllocation->ptBlock;
+    if(ptBlock == NULL) return;
+
+    hg_range_list_free(&ptBlock->tFreeRanges, ptAllocation->tOffset, ptAllocation->tSize);
+    ptBlock->tUsed -= ptAllocation->tSize;
+    ptBlock->uAllocationCount--;
+    memset(ptAllocation, 0, sizeof(hgAllocation));
+
+    if(ptBlock->uAllocationCount > 0) return;
+
+    // dedicated blocks go straight back to the driver, regular blocks are only released if another
+    // empty one of the same type is around (keeps streaming from allocating/freeing a block every time)
+    bool bRelease = ptBlock->bDedicated;
+    for(uint32_t i = 0; i < ptState->tMemoryComponents.uBlockCount && !bRelease; i++)
+    {
+        hgMemoryBlock* ptOther = ptState->tMemoryComponents.aptBlocks[i];
+        if(ptOther != ptBlock && !ptOther->bDedicated && ptOther->uAllocationCount == 0 && ptOther->uMemoryTypeIndex == ptBlock->uMemoryTypeIndex)
+        {
+            bRelease = true;
+        }
+    }
+    if(bRelease) hg_destroy_memory_block(ptState, ptBlock);
+}
+
+void
+hg_allocate_image_memory(hgAppData* ptState, VkImage tImage, VkMemoryPropertyFlags tProperties, hgAllocation* ptAllocationOut)
+{
+    VkMemoryRequirements tMemRequirements;
+    vkGetImageMemoryRequirements(ptState->tContextComponents.tDevice, tImage, &tMemRequirements);
+
+    // all images in here are optimal tiling
+    hg_allocate_memory(ptState, &tMemRequirements, tProperties, false, ptAllocationOut);
+    VULKAN_CHECK(vkBindImageMemory(ptState->tContextComponents.tDevice, tImage, ptAllocationOut->tMemory, ptAllocationOut->tOffset));
+}
+
+hgMemoryBlock*
+hg_create_memory_block(hgAppData* ptState, uint32_t uMemoryType, VkDeviceSize tSize, bool bLinear, bool bDedicated)
+{
+    hgMemoryAllocator* ptAllocator = &ptState->tMemoryComponents;
+
+    hgMemoryBlock* ptBlock = calloc(1, sizeof(hgMemoryBlock));
+    ptBlock->uMemoryTypeIndex = uMemoryType;
+    ptBlock->bLinear          = bLinear;
+    ptBlock->bDedicated       = bDedicated;
+
+    VkMemoryAllocateInfo tAllocInfo = {
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize  = tSize,
+        .memoryTypeIndex = uMemoryType
+    };
+    VULKAN_CHECK(vkAllocateMemory(ptState->tContextComponents.tDevice, &tAllocInfo, NULL, &ptBlock->tMemory));
+    ptBlock->tSize = tSize;
+
+    // map host visible blocks once for their whole lifetime -> memory can only be mapped once anyway
+    if(ptAllocator->tMemProperties.memoryTypes[uMemoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        VULKAN_CHECK(vkMapMemory(ptState->tContextComponents.tDevice, ptBlock->tMemory, 0, VK_WHOLE_SIZE, 0, &ptBlock->pMapped));
+    }
+
+    // whole block starts out as one free range
+    ptBlock->tFreeRanges.uCapacity   = 16;
+    ptBlock->tFreeRanges.atRanges    = malloc(ptBlock->tFreeRanges.uCapacity * sizeof(hgMemoryRange));
+    ptBlock->tFreeRanges.atRanges[0] = (hgMemoryRange){0, tSize};
+    ptBlock->tFreeRanges.uCount      = 1;
+
+    if(ptAllocator->uBlockCount == ptAllocator->uBlockCapacity)
+    {
+        ptAllocator->uBlockCapacity = ptAllocator->uBlockCapacity ? ptAllocator->uBlockCapacity * 2 : 8;
+        ptAllocator->aptBlocks      = realloc(ptAllocator->aptBlocks, ptAllocator->uBlockCapacity * sizeof(hgMemoryBlock*));
+    }
+    ptAllocator->aptBlocks[ptAllocator->uBlockCount++] = ptBlock;
+    return ptBlock;
+}
+
+void
+hg_destroy_memory_block(hgAppData* ptState, hgMemoryBlock* ptBlock)
+{
+    hgMemoryAllocator* ptAllocator = &ptState->tMemoryComponents;
+
+    // remove from block list (order doesn't matter)
+    for(uint32_t i = 0; i < ptAllocator->uBlockCount; i++)
+    {
+        if(ptAllocator->aptBlocks[i] == ptBlock)
+        {
+            ptAllocator->aptBlocks[i] = ptAllocator->aptBlocks[--ptAllocator->uBlockCount];
+            break;
+        }
+    }
+
+    if(ptBlock->pMapped) vkUnmapMemory(ptState->tContextComponents.tDevice, ptBlock->tMemory);
+    vkFreeMemory(ptState->tContextComponents.tDevice, ptBlock->tMemory, NULL);
+    free(ptBlock->tFreeRanges.atRanges);
+    free(ptBlock);
+}
+
+bool
+hg_range_list_allocate(hgRangeList* ptList, VkDeviceSize tSize, VkDeviceSize tAlignment, VkDeviceSize* ptOffsetOut)
+{
+    // best fit -> smallest free range that still holds the aligned allocation
+    uint32_t     uBest      = UINT32_MAX;
+    VkDeviceSize tBestWaste = VK_WHOLE_SIZE;
+    for(uint32_t i = 0; i < ptList->uCount; i++)
+    {
+        hgMemoryRange* ptRange  = &ptList->atRanges[i];
+        VkDeviceSize   tAligned = hg_align_up(ptRange->tOffset, tAlignment);
+        if(tAligned + tSize > ptRange->tOffset + ptRange->tSize) continue;
+
+        VkDeviceSize tWaste = ptRange->tSize - tSize;
+        if(tWaste < tBestWaste)
+        {
+            uBest      = i;
+            tBestWaste = tWaste;
+        }
+    }
+    if(uBest == UINT32_MAX) return false;
+
+    hgMemoryRange tRange   = ptList->atRanges[uBest];
+    VkDeviceSize  tAligned = hg_align_up(tRange.tOffset, tAlignment);
+    VkDeviceSize  tPadding = tAligned - tRange.tOffset;
+    VkDeviceSize  tTail    = (tRange.tOffset + tRange.tSize) - (tAligned + tSize);
+
+    // alignment padding stays free in front, whatever is left over after the allocation stays free behind it
+    if(tPadding > 0 && tTail > 0)
+    {
+        if(ptList->uCount == ptList->uCapacity)
+        {
+            ptList->uCapacity = ptList->uCapacity ? ptList->uCapacity * 2 : 16;
+            ptList->atRanges  = realloc(ptList->atRanges, ptList->uCapacity * sizeof(hgMemoryRange));
+        }
+        memmove(&ptList->atRanges[uBest + 2], &ptList->atRanges[uBest + 1], (ptList->uCount - uBest - 1) * sizeof(hgMemoryRange));
+        ptList->atRanges[uBest].tSize = tPadding;
+        ptList->atRanges[uBest + 1]   = (hgMemoryRange){tAligned + tSize, tTail};
+        ptList->uCount++;
+    }
+    else if(tPadding > 0)
+    {
+        ptList->atRanges[uBest].tSize = tPadding;
+    }
+    else if(tTail > 0)
+    {
+        ptList->atRanges[uBest] = (hgMemoryRange){tAligned + tSize, tTail};
+    }
+    else
+    {
+        memmove(&ptList->atRanges[uBest], &ptList->atRanges[uBest + 1], (ptList->uCount - uBest - 1) * sizeof(hgMemoryRange));
+        ptList->uCount--;
+    }
+
+    *ptOffsetOut = tAligned;
+    return true;
+}
+
+void
+hg_range_list_free(hgRangeList* ptList, VkDeviceSize tOffset, VkDeviceSize tSize)
+{
+    // find where the range goes in the sorted list
+    uint32_t uIndex = 0;
+    while(uIndex < ptList->uCount && ptList->atRanges[uIndex].tOffset < tOffset) uIndex++;
+
+    bool bMergePrev = uIndex > 0 && 
+        ptList->atRanges[uIndex - 1].tOffset + ptList->atRanges[uIndex - 1].tSize == tOffset;
+    bool bMergeNext = uIndex < ptList->uCount && 
+        tOffset + tSize == ptList->atRanges[uIndex].tOffset;
+
+    if(bMergePrev && bMergeNext) // fills the hole between two ranges
+    {
+        ptList->atRanges[uIndex - 1].tSize += tSize + ptList->atRanges[uIndex].tSize;
+        memmove(&ptList->atRanges[uIndex], &ptList->atRanges[uIndex + 1], (ptList->uCount - uIndex - 1) * sizeof(hgMemoryRange));
+        ptList->uCount--;
+    }
+    else if(bMergePrev)
+    {
+        ptList->atRanges[uIndex - 1].tSize += tSize;
+    }
+    else if(bMergeNext)
+    {
+        ptList->atRanges[uIndex].tOffset  = tOffset;
+        ptList->atRanges[uIndex].tSize   += tSize;
+    }
+    else
+    {
+        if(ptList->uCount == ptList->uCapacity)
+        {
+            ptList->uCapacity = ptList->uCapacity ? ptList->uCapacity * 2 : 16;
+            ptList->atRanges  = realloc(ptList->atRanges, ptList->uCapacity * sizeof(hgMemoryRange));
+        }
+        memmove(&ptList->atRanges[uIndex + 1], &ptList->atRanges[uIndex], (ptList->uCount - uIndex) * sizeof(hgMemoryRange));
+        ptList->atRanges[uIndex] = (hgMemoryRange){tOffset, tSize};
+        ptList->uCount++;
+    }
+}
+
+VkDeviceSize
+hg_align_up(VkDeviceSize tValue, VkDeviceSize tAlignment)
+{
+    if(tAlignment <= 1) return tValue;
+    return (tValue + tAlignment - 1) / tAlignment * tAlignment;
+}
+
+void
+hg_create_buffer(hgAppData* ptState, VkDeviceSize tSize, VkBufferUsageFlags tFlags, VkMemoryPropertyFlags tProperties, VkBuffer* ptBuffer, hgAllocation* ptAllocation)
+{
+    // create buffer
+    VkBufferCreateInfo tBufferCreateInfo = {
+        .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size        = tSize,
+        .usage       = tFlags,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE
+    };
+    VULKAN_CHECK(vkCreateBuffer(ptState->tContextComponents.tDevice, &tBufferCreateInfo, NULL, ptBuffer));
+
+    // get memory requirements
     VkMemoryRequirements tMemRequirements;
-    vkGetBufferMemoryRequirements(ptContext->tDevice, *ptBuffer, &tMemRequirements);
+    vkGetBufferMemoryRequirements(ptState->tContextComponents.tDevice, *ptBuffer, &tMemRequirements);
+
+    // sub-allocate and bind memory
+    hg_allocate_memory(ptState, &tMemRequirements, tProperties, true, ptAllocation);
+    VULKAN_CHECK(vkBindBufferMemory(ptState->tContextComponents.tDevice, *ptBuffer, ptAllocation->tMemory, ptAllocation->tOffset));
+}
+
+void
+hg_destroy_buffer(hgAppData* ptState, VkBuffer* ptBuffer, hgAllocation* ptAllocation)
+{
+    if(*ptBuffer != VK_NULL_HANDLE) vkDestroyBuffer(ptState->tContextComponents.tDevice, *ptBuffer, NULL);
+    *ptBuffer = VK_NULL_HANDLE;
+    hg_free_memory(ptState, ptAllocation);
+}
+
+void
+hg_copy_buffer(hgAppData* ptState, VkBuffer tSrcBuffer, VkDeviceSize tSrcOffset, VkBuffer tDstBuffer, VkDeviceSize tDstOffset, VkDeviceSize tSize)
+{
+    // recorded into the open upload batch, submitted by hg_submit_upload_batch()
+    VkBufferCopy tCopyRegion = {
+        .srcOffset = tSrcOffset,
+        .dstOffset = tDstOffset,
+        .size      = tSize
+    };
+    vkCmdCopyBuffer(hg_get_upload_cmd_buffer(ptState), tSrcBuffer, tDstBuffer, 1, &tCopyRegion);
+}
+
+uint32_t
+hg_index_size(VkIndexType tIndexType)
+{
+    return tIndexType == VK_INDEX_TYPE_UINT32 ? sizeof(uint32_t) : sizeof(uint16_t);
+}
+
+hgIndexBuffer
+hg_upload_index_buffer(hgAppData* ptState, const void* pIndices, uint32_t uCount, VkIndexType tIndexType)
+{
+    hgIndexBuffer tNewBuffer = {0};
+
+    size_t szSize = (size_t)hg_index_size(tIndexType) * uCount;
+    tNewBuffer.szSize      = szSize;
+    tNewBuffer.uIndexCount = uCount;
+    tNewBuffer.tIndexType  = tIndexType;
+
+    // create device buffer
+    hg_create_buffer(ptState, (VkDeviceSize)szSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tNewBuffer.tBuffer, &tNewBuffer.tAllocation);
+
+    // copy
+    bool bImplicitBatch = !ptState->tUploadComponents.bBatchOpen;
+    if(bImplicitBatch) hg_begin_upload_batch(ptState);
+    hg_enqueue_buffer_upload(ptState, tNewBuffer.tBuffer, 0, pIndices, (VkDeviceSize)szSize);
+    if(bImplicitBatch) hg_wait_for_upload(ptState, hg_submit_upload_batch(ptState));
+    return tNewBuffer;
+}
+
+// -------------------------------
+// staging ring
+// -------------------------------
+void
+hg_create_staging_ring(hgAppData* ptState)
+{
+    hgStagingRing* ptRing = &ptState->tStagingComponents;
+    memset(ptRing, 0, sizeof(hgStagingRing));
+
+    ptRing->tSize = ptState->szStagingRingSize ? (VkDeviceSize)ptState->szStagingRingSize : HG_DEFAULT_STAGING_RING_SIZE;
+
+    // 16 keeps every texel format and vertex/index copy happy, drivers may want more
+    ptRing->tAlignment = 16;
+    VkDeviceSize tOptimal = ptState->tContextComponents.tDeviceProperties.limits.optimalBufferCopyOffsetAlignment;
+    if(tOptimal > ptRing->tAlignment) ptRing->tAlignment = tOptimal;
+
+    hg_create_buffer(ptState, ptRing->tSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ptRing->tBuffer, &ptRing->tAllocation);
+}
+
+void
+hg_destroy_staging_ring(hgAppData* ptState)
+{
+    hgStagingRing* ptRing = &ptState->tStagingComponents;
+    if(ptRing->tBuffer == VK_NULL_HANDLE) return;
+
+    hg_destroy_buffer(ptState, &ptRing->tBuffer, &ptRing->tAllocation);
+    memset(ptRing, 0, sizeof(hgStagingRing));
+}
+
+void
+hg_staging_alloc(hgAppData* ptState, VkDeviceSize tSize, hgStagingSlice* ptSliceOut)
+{
+    hgStagingRing*   ptRing   = &ptState->tStagingComponents;
+    hgUploadContext* ptUpload = &ptState->tUploadComponents;
+    if(ptRing->tBuffer == VK_NULL_HANDLE) hg_create_staging_ring(ptState);
+
+    memset(ptSliceOut, 0, sizeof(hgStagingSlice));
+
+    if(tSize <= ptRing->tSize)
+    {
+        hg_retire_uploads(ptState, false);
+
+        for(;;)
+        {
+            // nothing in use -> start over at the beginning of the buffer
+            if(ptRing->uTail == ptRing->uHead)
+            {
+                ptRing->uHead      = hg_align_up(ptRing->uHead, ptRing->tSize);
+                ptRing->uSubmitted = ptRing->uHead;
+                ptRing->uTail      = ptRing->uHead;
+            }
+
+            // never let a slice straddle the end of the buffer
+            uint64_t uStart = hg_align_up(ptRing->uHead, ptRing->tAlignment);
+            if(uStart % ptRing->tSize + tSize > ptRing->tSize) uStart = (uStart / ptRing->tSize + 1) * ptRing->tSize;
+
+            if(uStart + tSize - ptRing->uTail <= ptRing->tSize)
+            {
+                ptRing->uHead = uStart + tSize;
+
+                ptSliceOut->tBuffer = ptRing->tBuffer;
+                ptSliceOut->tOffset = uStart % ptRing->tSize;
+                ptSliceOut->pData   = (char*)ptRing->tAllocation.pMapped + ptSliceOut->tOffset;
+                return;
+            }
+
+            // full -> wait for the gpu to finish the oldest upload, or hand it what this batch recorded so far
+            if(ptUpload->uSubmissionCount > 0)           hg_retire_uploads(ptState, true);
+            else if(ptRing->uHead != ptRing->uSubmitted) hg_flush_upload_commands(ptState);
+            else                                         break;
+        }
+    }
+
+    // doesn't fit into the ring at all -> one off buffer
+    ptSliceOut->bTemporary = true;
+    hg_create_buffer(ptState, tSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ptSliceOut->tBuffer, &ptSliceOut->tAllocation);
+    ptSliceOut->tOffset = 0;
+    ptSliceOut->pData   = ptSliceOut->tAllocation.pMapped;
+}
+
+// -------------------------------
+// transient allocator
+// -------------------------------
+void
+hg_create_transient_allocator(hgAppData* ptState)
+{
+    hgTransientAllocator* ptTransient = &ptState->tTransientComponents;
+    memset(ptTransient, 0, sizeof(hgTransientAllocator));
+
+    // regions start on an aligned offset so the first allocation of each frame is aligned as well
+    ptTransient->tAlignment = ptState->tContextComponents.tDeviceProperties.limits.minUniformBufferOffsetAlignment;
+    if(ptTransient->tAlignment < 16) ptTransient->tAlignment = 16;
+
+    VkDeviceSize tFrameSize = ptState->szTransientFrameSize ? (VkDeviceSize)ptState->szTransientFrameSize : HG_DEFAULT_TRANSIENT_SIZE;
+    ptTransient->tFrameSize = hg_align_up(tFrameSize, ptTransient->tAlignment);
+
+    hg_create_buffer(ptState, ptTransient->tFrameSize * hg_get_frames_in_flight(ptState), 
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &ptTransient->tBuffer, &ptTransient->tAllocation);
+}
+
+void
+hg_destroy_transient_allocator(hgAppData* ptState)
+{
+    hgTransientAllocator* ptTransient = &ptState->tTransientComponents;
+    if(ptTransient->tBuffer == VK_NULL_HANDLE) return;
+
+    hg_destroy_buffer(ptState, &ptTransient->tBuffer, &ptTransient->tAllocation);
+    memset(ptTransient, 0, sizeof(hgTransientAllocator));
+}
+
+void
+hg_activate_transient_frame(hgAppData* ptState)
+{
+    hgTransientAllocator* ptTransient = &ptState->tTransientComponents;
+    uint32_t              uFrame      = ptState->tSyncComponents.uCurrentFrame;
+
+    // the region is reset wholesale once the gpu is done with the frame that last used it
+    // (hg_begin_frame waits on this fence anyway, so this only blocks if we got here first)
+    VkFence tFence = ptState->tSyncComponents.tInFlight[uFrame];
+    if(tFence != VK_NULL_HANDLE)
+    {
+        vkWaitForFences(ptState->tContextComponents.tDevice, 1, &tFence, VK_TRUE, UINT64_MAX);
+    }
+
+    ptTransient->uActiveFrame = uFrame;
+    ptTransient->tHead        = 0;
+    ptTransient->bActive      = true;
+}
+
+// -------------------------------
+// upload batches
+// -------------------------------
+VkCommandBuffer
+hg_get_upload_cmd_buffer(hgAppData* ptState)
+{
+    hgUploadContext* ptUpload = &ptState->tUploadComponents;
+    VkDevice         tDevice  = ptState->tContextComponents.tDevice;
+
+    if(ptUpload->ptRecording != NULL) return ptUpload->ptRecording->tCommandBuffer;
+
+    // every slot in flight -> wait for the oldest one
+    if(ptUpload->uSubmissionCount == HG_MAX_UPLOAD_SUBMISSIONS) hg_retire_uploads(ptState, true);
+
+    hgUploadSubmission* ptSlot = &ptUpload->atSubmissions[(ptUpload->uFirstSubmission + ptUpload->uSubmissionCount) % HG_MAX_UPLOAD_SUBMISSIONS];
+
+    // slots keep their command buffers and sync objects for the lifetime of the app
+    if(ptSlot->tCommandBuffer == VK_NULL_HANDLE)
+    {
+        VkCommandBufferAllocateInfo tAllocInfo = {
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandPool        = ptState->tCommandComponents.tTransferCommandPool,
+            .commandBufferCount = 1
+        };
+        VULKAN_CHECK(vkAllocateCommandBuffers(tDevice, &tAllocInfo, &ptSlot->tCommandBuffer));
+
+        VkFenceCreateInfo tFenceInfo = {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+        };
+        VULKAN_CHECK(vkCreateFence(tDevice, &tFenceInfo, NULL, &ptSlot->tFence));
+
+        if(ptState->tContextComponents.tTransferQueueFamily != ptState->tContextComponents.tGraphicsQueueFamily)
+        {
+            tAllocInfo.commandPool = ptState->tCommandComponents.tCommandPool;
+            VULKAN_CHECK(vkAllocateCommandBuffers(tDevice, &tAllocInfo, &ptSlot->tAcquireCommandBuffer));
+
+            VkSemaphoreCreateInfo tSemaphoreInfo = {
+                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+            };
+            VULKAN_CHECK(vkCreateSemaphore(tDevice, &tSemaphoreInfo, NULL, &ptSlot->tTransferDone));
+        }
+    }
+
+    VkCommandBufferBeginInfo tBeginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+    VULKAN_CHECK(vkBeginCommandBuffer(ptSlot->tCommandBuffer, &tBeginInfo));
+
+    // upload query pool only exists when uploads run on the graphics family (transfer queues can't reset queries)
+    VkQueryPool tUploadQueries = ptState->tProfilerComponents.tUploadQueryPool;
+    if(tUploadQueries != VK_NULL_HANDLE)
+    {
+        uint32_t uQuery = (uint32_t)(ptSlot - ptUpload->atSubmissions) * 2;
+        vkCmdResetQueryPool(ptSlot->tCommandBuffer, tUploadQueries, uQuery, 2);
+        vkCmdWriteTimestamp(ptSlot->tCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, tUploadQueries, uQuery);
+    }
+
+    ptUpload->ptRecording = ptSlot;
+    return ptSlot->tCommandBuffer;
+}
+
+hgUploadTicket
+hg_flush_upload_commands(hgAppData* ptState)
+{
+    hgUploadContext*    ptUpload = &ptState->tUploadComponents;
+    hgUploadSubmission* ptSlot   = ptUpload->ptRecording;
+    if(ptSlot == NULL) return ptUpload->uLastTicket;
+
+    if(ptState->tContextComponents.tTransferQueueFamily == ptState->tContextComponents.tGraphicsQueueFamily)
+    {
+        // make the copies visible to anything submitted to the queue afterwards
+        VkMemoryBarrier tBarrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | 
+                             VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+        };
+        vkCmdPipelineBarrier(ptSlot->tCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 
+            0, 1, &tBarrier, 0, NULL, 0, NULL);
+
+        if(ptState->tProfilerComponents.tUploadQueryPool != VK_NULL_HANDLE)
+        {
+            uint32_t uQuery = (uint32_t)(ptSlot - ptUpload->atSubmissions) * 2 + 1;
+            vkCmdWriteTimestamp(ptSlot->tCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, ptState->tProfilerComponents.tUploadQueryPool, uQuery);
+        }
+
+        VULKAN_CHECK(vkEndCommandBuffer(ptSlot->tCommandBuffer));
+
+        VkSubmitInfo tSubmitInfo = {
+            .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers    = &ptSlot->tCommandBuffer
+        };
+        VULKAN_CHECK(vkQueueSubmit(ptState->tContextComponents.tGraphicsQueue, 1, &tSubmitInfo, ptSlot->tFence));
+    }
+    else
+    {
+        // releases were recorded next to each copy, the matching acquires go onto the graphics queue below
+        VULKAN_CHECK(vkEndCommandBuffer(ptSlot->tCommandBuffer));
+
+        VkSubmitInfo tTransferSubmit = {
+            .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount   = 1,
+            .pCommandBuffers      = &ptSlot->tCommandBuffer,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores    = &ptSlot->tTransferDone
+        };
+        VULKAN_CHECK(vkQueueSubmit(ptState->tContextComponents.tTransferQueue, 1, &tTransferSubmit, VK_NULL_HANDLE));
+
+        // acquire on the graphics queue, ordered before any frame submitted after this
+        VkCommandBufferBeginInfo tBeginInfo = {
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+            .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+        };
+        VULKAN_CHECK(vkBeginCommandBuffer(ptSlot->tAcquireCommandBuffer, &tBeginInfo));
+        vkCmdPipelineBarrier(ptSlot->tAcquireCommandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 
+            0, NULL, ptSlot->uBufferAcquireCount, ptSlot->atBufferAcquires, ptSlot->uImageAcquireCount, ptSlot->atImageAcquires);
+        VULKAN_CHECK(vkEndCommandBuffer(ptSlot->tAcquireCommandBuffer));
+
+        VkPipelineStageFlags tWaitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo tAcquireSubmit = {
+            .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores    = &ptSlot->tTransferDone,
+            .pWaitDstStageMask  = &tWaitStage,
+            .commandBufferCount = 1,
+            .pCommandBuffers    = &ptSlot->tAcquireCommandBuffer
+        };
+        VULKAN_CHECK(vkQueueSubmit(ptState->tContextComponents.tGraphicsQueue, 1, &tAcquireSubmit, ptSlot->tFence));
+    }
+    ptSlot->uBufferAcquireCount = 0;
+    ptSlot->uImageAcquireCount  = 0;
+
+    // staging space written so far belongs to this submission now
+    ptSlot->uTicket     = ++ptUpload->uLastTicket;
+    ptSlot->uStagingEnd = ptState->tStagingComponents.uHead;
+    ptState->tStagingComponents.uSubmitted = ptSlot->uStagingEnd;
+
+    ptUpload->uSubmissionCount++;
+    ptUpload->ptRecording = NULL;
+    return ptSlot->uTicket;
+}
+
+void
+hg_retire_uploads(hgAppData* ptState, bool bWaitOldest)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgUploadContext* ptUpload = &ptState->tUploadComponents;
+    VkDevice         tDevice  = ptState->tContextComponents.tDevice;
+
+    if(bWaitOldest && ptUpload->uSubmissionCount > 0)
+    {
+        VULKAN_CHECK(vkWaitForFences(tDevice, 1, &ptUpload->atSubmissions[ptUpload->uFirstSubmission].tFence, VK_TRUE, UINT64_MAX));
+    }
+
+    // submissions complete in order, stop at the first one still in flight
+    while(ptUpload->uSubmissionCount > 0)
+    {
+        hgUploadSubmission* ptSlot = &ptUpload->atSubmissions[ptUpload->uFirstSubmission];
+        if(vkGetFenceStatus(tDevice, ptSlot->tFence) != VK_SUCCESS) break;
+
+        VULKAN_CHECK(vkResetFences(tDevice, 1, &ptSlot->tFence));
+        hg_resolve_upload_timestamps(ptState, ptUpload->uFirstSubmission);
+        for(uint32_t i = 0; i < ptSlot->uTemporaryCount; i++)
+        {
+            hg_destroy_buffer(ptState, &ptSlot->atTemporaries[i].tBuffer, &ptSlot->atTemporaries[i].tAllocation);
+        }
+        ptSlot->uTemporaryCount = 0;
+
+        // the ring may have restarted past this submission's data already
+        ptUpload->uCompletedTicket = ptSlot->uTicket;
+        if(ptSlot->uStagingEnd > ptState->tStagingComponents.uTail) ptState->tStagingComponents.uTail = ptSlot->uStagingEnd;
+        ptUpload->uFirstSubmission = (ptUpload->uFirstSubmission + 1) % HG_MAX_UPLOAD_SUBMISSIONS;
+        ptUpload->uSubmissionCount--;
+    }
+    HG_TRACE_END();
+}
+
+void
+hg_defer_staging_free(hgAppData* ptState, hgStagingSlice* ptSlice)
+{
+    // ring slices are reclaimed by hg_retire_uploads, only oversized uploads own their staging buffer
+    if(!ptSlice->bTemporary) return;
+
+    hgUploadSubmission* ptSlot = ptState->tUploadComponents.ptRecording;
+    assert(ptSlot != NULL && "staging slice freed outside of a recorded upload");
+
+    if(ptSlot->uTemporaryCount == ptSlot->uTemporaryCapacity)
+    {
+        ptSlot->uTemporaryCapacity = ptSlot->uTemporaryCapacity ? ptSlot->uTemporaryCapacity * 2 : 4;
+        ptSlot->atTemporaries = realloc(ptSlot->atTemporaries, ptSlot->uTemporaryCapacity * sizeof(hgStagingSlice));
+    }
+    ptSlot->atTemporaries[ptSlot->uTemporaryCount++] = *ptSlice;
+    memset(ptSlice, 0, sizeof(hgStagingSlice));
+}
+
+void
+hg_release_buffer_to_graphics(hgAppData* ptState, VkBuffer tBuffer, VkDeviceSize tOffset, VkDeviceSize tSize)
+{
+    if(ptState->tContextComponents.tTransferQueueFamily == ptState->tContextComponents.tGraphicsQueueFamily) return;
+
+    hgUploadSubmission* ptSlot = ptState->tUploadComponents.ptRecording;
+    assert(ptSlot != NULL);
+
+    if(ptSlot->uBufferAcquireCount == ptSlot->uBufferAcquireCapacity)
+    {
+        ptSlot->uBufferAcquireCapacity = ptSlot->uBufferAcquireCapacity ? ptSlot->uBufferAcquireCapacity * 2 : 16;
+        ptSlot->atBufferAcquires = realloc(ptSlot->atBufferAcquires, ptSlot->uBufferAcquireCapacity * sizeof(VkBufferMemoryBarrier));
+    }
+    VkBufferMemoryBarrier tBarrier = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask       = 0,
+        .srcQueueFamilyIndex = ptState->tContextComponents.tTransferQueueFamily,
+        .dstQueueFamilyIndex = ptState->tContextComponents.tGraphicsQueueFamily,
+        .buffer              = tBuffer,
+        .offset              = tOffset,
+        .size                = tSize
+    };
+    vkCmdPipelineBarrier(ptSlot->tCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 1, &tBarrier, 0, NULL);
+
+    // same barrier with the access masks on the other side
+    tBarrier.srcAccessMask = 0;
+    tBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | 
+                             VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    ptSlot->atBufferAcquires[ptSlot->uBufferAcquireCount++] = tBarrier;
+}
+
+void
+hg_release_image_to_graphics(hgAppData* ptState, VkImage tImage, VkImageSubresourceRange tSubresourceRange)
+{
+    hgUploadSubmission* ptSlot = ptState->tUploadComponents.ptRecording;
+    assert(ptSlot != NULL);
+
+    if(ptSlot->uImageAcquireCount == ptSlot->uImageAcquireCapacity)
+    {
+        ptSlot->uImageAcquireCapacity = ptSlot->uImageAcquireCapacity ? ptSlot->uImageAcquireCapacity * 2 : 16;
+        ptSlot->atImageAcquires = realloc(ptSlot->atImageAcquires, ptSlot->uImageAcquireCapacity * sizeof(VkImageMemoryBarrier));
+    }
+
+    // the layout transition has to be identical on the release and the acquire side
+    VkImageMemoryBarrier tBarrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask       = 0,
+        .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = ptState->tContextComponents.tTransferQueueFamily,
+        .dstQueueFamilyIndex = ptState->tContextComponents.tGraphicsQueueFamily,
+        .image               = tImage,
+        .subresourceRange    = tSubresourceRange
+    };
+    vkCmdPipelineBarrier(ptSlot->tCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &tBarrier);
+
+    tBarrier.srcAccessMask = 0;
+    tBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    ptSlot->atImageAcquires[ptSlot->uImageAcquireCount++] = tBarrier;
+}
+
+void
+hg_destroy_upload_context(hgAppData* ptState)
+{
+    hgUploadContext* ptUpload = &ptState->tUploadComponents;
+
+    // an unsubmitted batch is dropped, it never reached the gpu
+    if(ptUpload->ptRecording != NULL)
+    {
+        VULKAN_CHECK(vkEndCommandBuffer(ptUpload->ptRecording->tCommandBuffer));
+        ptUpload->ptRecording = NULL;
+    }
+    while(ptUpload->uSubmissionCount > 0) hg_retire_uploads(ptState, true);
+
+    for(uint32_t i = 0; i < HG_MAX_UPLOAD_SUBMISSIONS; i++)
+    {
+        hgUploadSubmission* ptSlot = &ptUpload->atSubmissions[i];
+        for(uint32_t j = 0; j < ptSlot->uTemporaryCount; j++)
+        {
+            hg_destroy_buffer(ptState, &ptSlot->atTemporaries[j].tBuffer, &ptSlot->atTemporaries[j].tAllocation);
+        }
+        free(ptSlot->atTemporaries);
+        free(ptSlot->atBufferAcquires);
+        free(ptSlot->atImageAcquires);
+
+        VkDevice tDevice = ptState->tContextComponents.tDevice;
+        if(ptSlot->tFence != VK_NULL_HANDLE)                vkDestroyFence(tDevice, ptSlot->tFence, NULL);
+        if(ptSlot->tTransferDone != VK_NULL_HANDLE)         vkDestroySemaphore(tDevice, ptSlot->tTransferDone, NULL);
+        if(ptSlot->tCommandBuffer != VK_NULL_HANDLE)        vkFreeCommandBuffers(tDevice, ptState->tCommandComponents.tTransferCommandPool, 1, &ptSlot->tCommandBuffer);
+        if(ptSlot->tAcquireCommandBuffer != VK_NULL_HANDLE) vkFreeCommandBuffers(tDevice, ptState->tCommandComponents.tCommandPool, 1, &ptSlot->tAcquireCommandBuffer);
+    }
+    memset(ptUpload, 0, sizeof(hgUploadContext));
+}
+
+// -------------------------------
+// image operations
+// -------------------------------
+void 
+hg_transition_image_layout(VkCommandBuffer tCommandBuffer, VkImage tImage, VkImageLayout tOldLayout, 
+    VkImageLayout tNewLayout, VkImageSubresourceRange tSubresourceRange, VkPipelineStageFlags tSrcStageMask, 
+    VkPipelineStageFlags tDstStageMask) 
+{
+    VkImageMemoryBarrier tBarrier = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .oldLayout           = tOldLayout,
+        .newLayout           = tNewLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image               = tImage,
+        .subresourceRange    = tSubresourceRange,
+    };
+
+    // source layouts (old)
+    switch (tOldLayout) 
+    {
+        case VK_IMAGE_LAYOUT_UNDEFINED:
+            tBarrier.srcAccessMask = 0;
+            break;
+
+        case VK_IMAGE_LAYOUT_PREINITIALIZED:
+            tBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+            tBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+            tBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+            tBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+            tBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+            tBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            break;
+
+        default:
+            break;
+    }
+
+    // target layouts (new)
+    switch (tNewLayout) 
+    {
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+            tBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+            tBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+            tBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+            tBarrier.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            break;
+
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+            if (tBarrier.srcAccessMask == 0) 
+            {
+                tBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            }
+            tBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            break;
+
+        default:
+            break;
+    }
+
+    vkCmdPipelineBarrier(tCommandBuffer, tSrcStageMask, tDstStageMask, 0, 0, NULL, 0, NULL, 1, &tBarrier);
+}
+
+// -------------------------------
+// shader loading
+// -------------------------------
+bool
+hg_resolve_shader_path(const char* pcFilename, char* pcPathOut, size_t szPathSize, struct stat* ptStatOut)
+{
+    snprintf(pcPathOut, szPathSize, "%s", pcFilename);
+    if(stat(pcPathOut, ptStatOut) == 0)
+    {
+        return true;
+    }
+
+    // try one fallback location
+    snprintf(pcPathOut, szPathSize, "../out/shaders/%s", pcFilename);
+    return stat(pcPathOut, ptStatOut) == 0;
+}
+
+uint64_t
+hg_hash_bytes(const void* pData, size_t szSize)
+{
+    // FNV-1a, plenty for telling shader binaries apart
+    const unsigned char* pucBytes = pData;
+    uint64_t uHash = 14695981039346656037ull;
+    for(size_t i = 0; i < szSize; i++)
+    {
+        uHash ^= pucBytes[i];
+        uHash *= 1099511628211ull;
+    }
+    return uHash;
+}
+
+VkShaderModule 
+hg_create_shader_module(hgAppData* ptAppData, const char* pcFilename, hgMutex* ptCacheLock) 
+{
+    HG_TRACE_BEGIN(__func__);
+    hgShaderCache* ptCache = &ptAppData->tShaderComponents;
+    VkDevice       tDevice = ptAppData->tContextComponents.tDevice;
+
+    char        acPath[256];
+    struct stat tFileStat;
+    if(!hg_resolve_shader_path(pcFilename, acPath, sizeof(acPath), &tFileStat))
+    {
+        printf("Failed to open shader file: %s\n", pcFilename);
+        printf("Also tried: %s\n", acPath);
+        HG_TRACE_END();
+        return VK_NULL_HANDLE;
+    }
+
+    // cheap path -> same file, untouched since the module was created
+    if(ptCacheLock) hg_mutex_lock(ptCacheLock);
+    hgShaderModuleEntry* ptEntry = hg_find_shader_entry(ptCache, acPath);
+    if(ptEntry && ptEntry->iModifiedTime == (int64_t)tFileStat.st_mtime && ptEntry->uFileSize == (uint64_t)tFileStat.st_size)
+    {
+        VkShaderModule tModule = ptEntry->tModule;
+        if(ptCacheLock) hg_mutex_unlock(ptCacheLock);
+        HG_TRACE_END();
+        return tModule;
+    }
+    if(ptCacheLock) hg_mutex_unlock(ptCacheLock);
+
+    // file is new or was touched -> map it and compare contents (outside the lock, other workers keep loading theirs)
+    size_t szSize  = 0;
+    void*  pHandle = NULL;
+    void*  pCode   = hg_map_file(acPath, &szSize, &pHandle);
+    if(!pCode)
+    {
+        printf("Failed to map shader file: %s\n", acPath);
+        HG_TRACE_END();
+        return VK_NULL_HANDLE;
+    }
+    if(szSize == 0 || szSize % 4 != 0)
+    {
+        printf("Shader file is not valid spir-v (size %zu): %s\n", szSize, acPath);
+        hg_unmap_file(pCode, szSize, pHandle);
+        HG_TRACE_END();
+        return VK_NULL_HANDLE;
+    }
+
+    // only the timestamp changed (rebuilt with the same output), or another worker loaded these contents meanwhile.
+    // entries are looked up again every time the lock is taken, the table may have grown in between
+    uint64_t uHash = hg_hash_bytes(pCode, szSize);
+    if(ptCacheLock) hg_mutex_lock(ptCacheLock);
+    ptEntry = hg_find_shader_entry(ptCache, acPath);
+    if(ptEntry && ptEntry->uContentHash == uHash)
+    {
+        ptEntry->iModifiedTime = (int64_t)tFileStat.st_mtime;
+        ptEntry->uFileSize     = (uint64_t)tFileStat.st_size;
+        VkShaderModule tModule = ptEntry->tModule;
+        if(ptCacheLock) hg_mutex_unlock(ptCacheLock);
+        hg_unmap_file(pCode, szSize, pHandle);
+        HG_TRACE_END();
+        return tModule;
+    }
+    if(ptCacheLock) hg_mutex_unlock(ptCacheLock);
+
+    // vulkan only needs the code during vkCreateShaderModule, the mapping can go right after
+    VkShaderModuleCreateInfo tCreateInfo = {
+        .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = szSize,
+        .pCode    = pCode
+    };
+
+    VkShaderModule tShaderModule;
+    VULKAN_CHECK(vkCreateShaderModule(tDevice, &tCreateInfo, NULL, &tShaderModule));
+    hg_unmap_file(pCode, szSize, pHandle);
+
+    if(ptCacheLock) hg_mutex_lock(ptCacheLock);
+    ptEntry = hg_find_shader_entry(ptCache, acPath);
+    if(ptEntry && ptEntry->uContentHash == uHash)
+    {
+        // another worker created the same module first -> keep theirs, ours was never handed out
+        vkDestroyShaderModule(tDevice, tShaderModule, NULL);
+        tShaderModule = ptEntry->tModule;
+    }
+    else
+    {
+        if(ptEntry)
+        {
+            // contents changed -> another worker of the batch may still be building with the old module, so it is only
+            // released once the build is over (pipelines already built keep their compiled code)
+            if(ptCache->uStaleCount == ptCache->uStaleCapacity)
+            {
+                ptCache->uStaleCapacity = ptCache->uStaleCapacity ? ptCache->uStaleCapacity * 2 : 16;
+                ptCache->atStale        = realloc(ptCache->atStale, sizeof(VkShaderModule) * ptCache->uStaleCapacity);
+            }
+            ptCache->atStale[ptCache->uStaleCount++] = ptEntry->tModule;
+        }
+        else
+        {
+            if(ptCache->uEntryCount == ptCache->uEntryCapacity)
+            {
+                ptCache->uEntryCapacity = ptCache->uEntryCapacity ? ptCache->uEntryCapacity * 2 : 16;
+                ptCache->atEntries      = realloc(ptCache->atEntries, sizeof(hgShaderModuleEntry) * ptCache->uEntryCapacity);
+            }
+            ptEntry = &ptCache->atEntries[ptCache->uEntryCount++];
+            memset(ptEntry, 0, sizeof(hgShaderModuleEntry));
+            snprintf(ptEntry->acPath, sizeof(ptEntry->acPath), "%s", acPath);
+        }
+
+        ptEntry->uContentHash  = uHash;
+        ptEntry->iModifiedTime = (int64_t)tFileStat.st_mtime;
+        ptEntry->uFileSize     = (uint64_t)tFileStat.st_size;
+        ptEntry->tModule       = tShaderModule;
+    }
+    if(ptCacheLock) hg_mutex_unlock(ptCacheLock);
+
+    HG_TRACE_END();
+    return tShaderModule;
+}
+
+hgShaderModuleEntry*
+hg_find_shader_entry(hgShaderCache* ptCache, const char* pcPath)
+{
+    for(uint32_t i = 0; i < ptCache->uEntryCount; i++)
+    {
+        if(strcmp(ptCache->atEntries[i].acPath, pcPath) == 0)
+        {
+            return &ptCache->atEntries[i];
+        }
+    }
+    return NULL;
+}
+
+void
+hg_destroy_shader_cache(hgAppData* ptState)
+{
+    hgShaderCache* ptCache = &ptState->tShaderComponents;
+    for(uint32_t i = 0; i < ptCache->uEntryCount; i++)
+    {
+        vkDestroyShaderModule(ptState->tContextComponents.tDevice, ptCache->atEntries[i].tModule, NULL);
+    }
+    hg_release_stale_shader_modules(ptState);
+    free(ptCache->atEntries);
+    free(ptCache->atStale);
+    memset(ptCache, 0, sizeof(hgShaderCache));
+}
+
+void
+hg_release_stale_shader_modules(hgAppData* ptState)
+{
+    hgShaderCache* ptCache = &ptState->tShaderComponents;
+    for(uint32_t i = 0; i < ptCache->uStaleCount; i++)
+    {
+        vkDestroyShaderModule(ptState->tContextComponents.tDevice, ptCache->atStale[i], NULL);
+    }
+    ptCache->uStaleCount = 0;
+}
+
+// -------------------------------
+// file mapping
+// -------------------------------
+void*
+hg_map_file(const char* pcPath, size_t* pszSizeOut, void** ppHandleOut)
+{
+    *pszSizeOut  = 0;
+    *ppHandleOut = NULL;
+
+#ifdef _WIN32
+    HANDLE tFile = CreateFileA(pcPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(tFile == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    LARGE_INTEGER tFileSize;
+    if(!GetFileSizeEx(tFile, &tFileSize) || tFileSize.QuadPart == 0)
+    {
+        CloseHandle(tFile);
+        return NULL;
+    }
+
+    // the mapping object keeps the file alive, the file handle can be closed right away
+    HANDLE tMapping = CreateFileMappingA(tFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(tFile);
+    if(!tMapping)
+    {
+        return NULL;
+    }
+
+    void* pData = MapViewOfFile(tMapping, FILE_MAP_READ, 0, 0, 0);
+    if(!pData)
+    {
+        CloseHandle(tMapping);
+        return NULL;
+    }
+
+    *pszSizeOut  = (size_t)tFileSize.QuadPart;
+    *ppHandleOut = tMapping;
+    return pData;
+#else
+    int iFile = open(pcPath, O_RDONLY);
+    if(iFile < 0)
+    {
+        return NULL;
+    }
+
+    struct stat tFileStat;
+    if(fstat(iFile, &tFileStat) != 0 || tFileStat.st_size == 0)
+    {
+        close(iFile);
+        return NULL;
+    }
+
+    void* pData = mmap(NULL, (size_t)tFileStat.st_size, PROT_READ, MAP_PRIVATE, iFile, 0);
+    close(iFile);
+    if(pData == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    *pszSizeOut = (size_t)tFileStat.st_size;
+    return pData;
+#endif
+}
+
+void
+hg_unmap_file(void* pData, size_t szSize, void* pHandle)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(pData);
+    CloseHandle((HANDLE)pHandle);
+#else
+    (void)pHandle;
+    munmap(pData, szSize);
+#endif
+}
+
+// -------------------------------
+// threading
+// -------------------------------
+typedef struct _hgThreadStart
+{
+    hgThreadFunc pfFunc;
+    void*        pUserData;
+} hgThreadStart;
+
+#ifdef _WIN32
+DWORD WINAPI
+hg_thread_entry(LPVOID pParam)
+{
+    hgThreadStart tStart = *(hgThreadStart*)pParam;
+    free(pParam);
+    tStart.pfFunc(tStart.pUserData);
+#ifdef HG_ENABLE_TRACE
+    hg_trace_release_buffer();
+#endif
+    return 0;
+}
+#else
+void*
+hg_thread_entry(void* pParam)
+{
+    hgThreadStart tStart = *(hgThreadStart*)pParam;
+    free(pParam);
+    tStart.pfFunc(tStart.pUserData);
+#ifdef HG_ENABLE_TRACE
+    hg_trace_release_buffer();
+#endif
+    return NULL;
+}
+#endif
+
+bool
+hg_thread_start(hgThread* ptThreadOut, hgThreadFunc pfFunc, void* pUserData)
+{
+    // heap copy so the entry point doesn't depend on the caller's stack
+    hgThreadStart* ptStart = malloc(sizeof(hgThreadStart));
+    ptStart->pfFunc    = pfFunc;
+    ptStart->pUserData = pUserData;
+
+#ifdef _WIN32
+    *ptThreadOut = CreateThread(NULL, 0, hg_thread_entry, ptStart, 0, NULL);
+    if(*ptThreadOut == NULL)
+#else
+    if(pthread_create(ptThreadOut, NULL, hg_thread_entry, ptStart) != 0)
+#endif
+    {
+        free(ptStart);
+        return false;
+    }
+    return true;
+}
+
+void
+hg_thread_join(hgThread tThread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(tThread, INFINITE);
+    CloseHandle(tThread);
+#else
+    pthread_join(tThread, NULL);
+#endif
+}
+
+uint32_t
+hg_get_core_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO tSystemInfo;
+    GetSystemInfo(&tSystemInfo);
+    return (uint32_t)tSystemInfo.dwNumberOfProcessors;
+#else
+    long lCores = sysconf(_SC_NPROCESSORS_ONLN);
+    return lCores > 0 ? (uint32_t)lCores : 1;
+#endif
+}
+
+void
+hg_mutex_init(hgMutex* ptMutex)
+{
+#ifdef _WIN32
+    InitializeSRWLock(ptMutex);
+#else
+    pthread_mutex_init(ptMutex, NULL);
+#endif
+}
+
+void
+hg_mutex_lock(hgMutex* ptMutex)
+{
+#ifdef _WIN32
+    AcquireSRWLockExclusive(ptMutex);
+#else
+    pthread_mutex_lock(ptMutex);
+#endif
+}
 
-    // find suitable memory
-    uint32_t tMemTypeIndex = hg_find_memory_type(ptContext, tMemRequirements.memoryTypeBits, tProperties);
+void
+hg_mutex_unlock(hgMutex* ptMutex)
+{
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(ptMutex);
+#else
+    pthread_mutex_unlock(ptMutex);
+#endif
+}
 
-    // allocate and bind memory
-    VkMemoryAllocateInfo tMemAllocInfo = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize  = tMemRequirements.size,
-        .memoryTypeIndex = tMemTypeIndex
+void
+hg_mutex_destroy(hgMutex* ptMutex)
+{
+#ifdef _WIN32
+    (void)ptMutex; // SRW locks need no cleanup
+#else
+    pthread_mutex_destroy(ptMutex);
+#endif
+}
+
+// -------------------------------
+// pipeline cache
+// -------------------------------
+const char*
+hg_get_pipeline_cache_path(hgAppData* ptState)
+{
+    return ptState->pcPipelineCachePath ? ptState->pcPipelineCachePath : HG_DEFAULT_PIPELINE_CACHE;
+}
+
+// the blob is only valid for the exact driver/device that wrote it, a mismatch is dropped rather than handed to the driver
+bool
+hg_is_pipeline_cache_compatible(hgAppData* ptState, const unsigned char* pucData, size_t szSize)
+{
+    // VkPipelineCacheHeaderVersionOne -> headerSize, headerVersion, vendorID, deviceID, pipelineCacheUUID[16]
+    if(szSize < 16 + VK_UUID_SIZE)
+    {
+        return false;
+    }
+
+    uint32_t auHeader[4];
+    memcpy(auHeader, pucData, sizeof(auHeader));
+
+    const VkPhysicalDeviceProperties* ptProps = &ptState->tContextComponents.tDeviceProperties;
+    if(auHeader[0] < 16 + VK_UUID_SIZE || auHeader[0] > szSize)  return false;
+    if(auHeader[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)     return false;
+    if(auHeader[2] != ptProps->vendorID)                         return false;
+    if(auHeader[3] != ptProps->deviceID)                         return false;
+    return memcmp(pucData + 16, ptProps->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void
+hg_create_pipeline_cache(hgAppData* ptState)
+{
+    HG_TRACE_BEGIN(__func__);
+    const char*    pcPath   = hg_get_pipeline_cache_path(ptState);
+    unsigned char* pucData  = NULL;
+    size_t         szSize   = 0;
+
+    // a missing file is the normal first run case
+    FILE* pFile = fopen(pcPath, "rb");
+    if(pFile)
+    {
+        fseek(pFile, 0, SEEK_END);
+        long lSize = ftell(pFile);
+        rewind(pFile);
+
+        if(lSize > 0)
+        {
+            pucData = malloc((size_t)lSize);
+            if(fread(pucData, (size_t)lSize, 1, pFile) == 1)
+            {
+                szSize = (size_t)lSize;
+            }
+        }
+        fclose(pFile);
+
+        if(szSize > 0 && !hg_is_pipeline_cache_compatible(ptState, pucData, szSize))
+        {
+            printf("Pipeline cache %s was written by a different device/driver, starting empty\n", pcPath);
+            szSize = 0;
+        }
+    }
+
+    VkPipelineCacheCreateInfo tCacheInfo = {
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = szSize,
+        .pInitialData    = szSize > 0 ? pucData : NULL
     };
-    VULKAN_CHECK(vkAllocateMemory(ptContext->tDevice, &tMemAllocInfo, NULL, pMemory));
-    VULKAN_CHECK(vkBindBufferMemory(ptContext->tDevice, *ptBuffer, *pMemory, 0));
+
+    // drivers may still reject data that passed the header check, fall back to an empty cache
+    if(vkCreatePipelineCache(ptState->tContextComponents.tDevice, &tCacheInfo, NULL, &ptState->tContextComponents.tPipelineCache) != VK_SUCCESS)
+    {
+        tCacheInfo.initialDataSize = 0;
+        tCacheInfo.pInitialData    = NULL;
+        VULKAN_CHECK(vkCreatePipelineCache(ptState->tContextComponents.tDevice, &tCacheInfo, NULL, &ptState->tContextComponents.tPipelineCache));
+    }
+
+    free(pucData);
+    HG_TRACE_END();
 }
 
-void hg_copy_buffer(hgVulkanContext* ptContext, hgCommandResources* ptCommands, VkBuffer tSrcBuffer, VkBuffer tDstBuffer, VkDeviceSize tSize)
+void
+hg_save_pipeline_cache(hgAppData* ptState)
 {
-    // create a temporary command buffer for the copy
-    VkCommandBufferAllocateInfo tBufferAllocInfo = {
-        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandPool        = ptCommands->tCommandPool,
-        .commandBufferCount = 1
+    HG_TRACE_BEGIN(__func__);
+    if(ptState->tContextComponents.tPipelineCache == VK_NULL_HANDLE)
+    {
+        HG_TRACE_END();
+        return;
+    }
+
+    size_t szSize = 0;
+    VULKAN_CHECK(vkGetPipelineCacheData(ptState->tContextComponents.tDevice, ptState->tContextComponents.tPipelineCache, &szSize, NULL));
+    if(szSize == 0)
+    {
+        HG_TRACE_END();
+        return;
+    }
+
+    void* pData = malloc(szSize);
+    VULKAN_CHECK(vkGetPipelineCacheData(ptState->tContextComponents.tDevice, ptState->tContextComponents.tPipelineCache, &szSize, pData));
+
+    // not being able to write the cache only costs startup time next run
+    const char* pcPath = hg_get_pipeline_cache_path(ptState);
+    FILE* pFile = fopen(pcPath, "wb");
+    if(pFile)
+    {
+        fwrite(pData, szSize, 1, pFile);
+        fclose(pFile);
+    }
+    else
+    {
+        printf("Failed to write pipeline cache: %s\n", pcPath);
+    }
+
+    free(pData);
+    HG_TRACE_END();
+}
+
+void
+hg_destroy_pipeline_cache(hgAppData* ptState)
+{
+    if(ptState->tContextComponents.tPipelineCache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(ptState->tContextComponents.tDevice, ptState->tContextComponents.tPipelineCache, NULL);
+        ptState->tContextComponents.tPipelineCache = VK_NULL_HANDLE;
+    }
+}
+
+// -------------------------------
+// per image sync objects
+// -------------------------------
+void
+hg_create_image_sync_objects(hgAppData* ptState)
+{
+    hgFrameSync* ptSync = &ptState->tSyncComponents;
+    ptSync->uImageCount     = ptState->tSwapchainComponents.uSwapchainImageCount;
+    ptSync->tRenderFinished = malloc(ptSync->uImageCount * sizeof(VkSemaphore));
+    ptSync->tImagesInFlight = calloc(ptSync->uImageCount, sizeof(VkFence));
+
+    VkSemaphoreCreateInfo tSemaphoreInfo = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
+    };
+    for(uint32_t i = 0; i < ptSync->uImageCount; i++)
+    {
+        VULKAN_CHECK(vkCreateSemaphore(ptState->tContextComponents.tDevice, &tSemaphoreInfo, NULL, &ptSync->tRenderFinished[i]));
+    }
+}
+
+void
+hg_destroy_image_sync_objects(hgAppData* ptState)
+{
+    hgFrameSync* ptSync = &ptState->tSyncComponents;
+    for(uint32_t i = 0; i < ptSync->uImageCount; i++)
+    {
+        vkDestroySemaphore(ptState->tContextComponents.tDevice, ptSync->tRenderFinished[i], NULL);
+    }
+    free(ptSync->tRenderFinished);
+    free(ptSync->tImagesInFlight);
+    ptSync->tRenderFinished = NULL;
+    ptSync->tImagesInFlight = NULL;
+    ptSync->uImageCount     = 0;
+}
+
+// -------------------------------
+// frame pacing
+// -------------------------------
+uint64_t
+hg_get_time_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER tFrequency = {0};
+    if(tFrequency.QuadPart == 0) QueryPerformanceFrequency(&tFrequency);
+
+    LARGE_INTEGER tCounter;
+    QueryPerformanceCounter(&tCounter);
+    return (uint64_t)((double)tCounter.QuadPart * 1000000000.0 / (double)tFrequency.QuadPart);
+#else
+    struct timespec tTime;
+    clock_gettime(CLOCK_MONOTONIC, &tTime);
+    return (uint64_t)tTime.tv_sec * 1000000000ull + (uint64_t)tTime.tv_nsec;
+#endif
+}
+
+void
+hg_sleep_until_ns(hgFramePacing* ptPacing, uint64_t uDeadlineNs)
+{
+    // one absolute sleep for the whole interval -> the thread is idle until the deadline instead of polling
+#ifdef _WIN32
+    // high resolution waitable timers (windows 10 1803+) wake within a fraction of a ms, older systems get a 1ms
+    // scheduler period instead of the default ~15ms
+    if(!ptPacing->pSleepTimer && !ptPacing->bTimerPeriodRaised)
+    {
+        ptPacing->pSleepTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if(!ptPacing->pSleepTimer)
+        {
+            timeBeginPeriod(1);
+            ptPacing->bTimerPeriodRaised = true;
+        }
+    }
+
+    uint64_t uNowNs = hg_get_time_ns();
+    if(uNowNs >= uDeadlineNs)
+    {
+        return;
+    }
+    if(ptPacing->pSleepTimer)
+    {
+        LARGE_INTEGER tDueTime;
+        tDueTime.QuadPart = -(LONGLONG)((uDeadlineNs - uNowNs) / 100); // negative -> relative, in 100ns
+        if(SetWaitableTimer(ptPacing->pSleepTimer, &tDueTime, 0, NULL, NULL, FALSE))
+        {
+            WaitForSingleObject(ptPacing->pSleepTimer, INFINITE);
+            return;
+        }
+    }
+    Sleep((DWORD)((uDeadlineNs - uNowNs) / 1000000));
+#else
+    (void)ptPacing;
+
+    // same clock as hg_get_time_ns, so the deadline can be used as is
+    struct timespec tDeadline = {
+        .tv_sec  = (time_t)(uDeadlineNs / 1000000000ull),
+        .tv_nsec = (long)(uDeadlineNs % 1000000000ull)
+    };
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tDeadline, NULL) == EINTR)
+    {
+        // signal -> sleep the rest
+    }
+#endif
+}
+
+void
+hg_apply_frame_pacing(hgAppData* ptState)
+{
+    hgFramePacing* ptPacing = &ptState->tPacingComponents;
+    if(ptState->tPacingMode != HG_PACING_FPS_CAP || ptState->fTargetFps <= 0.0f)
+    {
+        ptPacing->uLastFrameStartNs = hg_get_time_ns();
+        return;
+    }
+
+    uint64_t uPeriodNs   = (uint64_t)(1000000000.0 / (double)ptState->fTargetFps);
+    uint64_t uDeadlineNs = ptPacing->uLastFrameStartNs + uPeriodNs;
+    uint64_t uNowNs      = hg_get_time_ns();
+    if(ptPacing->uLastFrameStartNs != 0 && uNowNs < uDeadlineNs)
+    {
+        // os sleeps can overshoot by a bit, precise pacing wakes early and spins the rest on purpose
+        if(!ptState->bPrecisePacing)
+        {
+            hg_sleep_until_ns(ptPacing, uDeadlineNs);
+        }
+        else
+        {
+            if(uNowNs + HG_PACING_SPIN_NS < uDeadlineNs) hg_sleep_until_ns(ptPacing, uDeadlineNs - HG_PACING_SPIN_NS);
+            while(hg_get_time_ns() < uDeadlineNs)
+            {
+                // spin
+            }
+        }
+
+        // step from the deadline so the rate doesn't drift with sleep overshoot
+        ptPacing->uLastFrameStartNs = uDeadlineNs;
+    }
+    else
+    {
+        // first frame or running behind -> don't try to catch up with a burst
+        ptPacing->uLastFrameStartNs = uNowNs;
+    }
+}
+
+void
+hg_destroy_frame_pacing(hgAppData* ptState)
+{
+#ifdef _WIN32
+    hgFramePacing* ptPacing = &ptState->tPacingComponents;
+    if(ptPacing->pSleepTimer)        CloseHandle(ptPacing->pSleepTimer);
+    if(ptPacing->bTimerPeriodRaised) timeEndPeriod(1);
+    ptPacing->pSleepTimer        = NULL;
+    ptPacing->bTimerPeriodRaised = false;
+#else
+    (void)ptState;
+#endif
+}
+
+void
+hg_update_frame_latency(hgAppData* ptState, uint32_t uFrame, uint64_t uNowNs)
+{
+    hgFramePacing* ptPacing = &ptState->tPacingComponents;
+    if(!ptPacing->abLatencyPending[uFrame])
+    {
+        return;
+    }
+    if(vkGetFenceStatus(ptState->tContextComponents.tDevice, ptState->tSyncComponents.tInFlight[uFrame]) != VK_SUCCESS)
+    {
+        return;
+    }
+    ptPacing->abLatencyPending[uFrame] = false;
+
+    // resolution is one begin frame, the fence is only looked at here
+    hgFrameLatency* ptLatency = &ptPacing->tLatency;
+    float fMs = (float)((double)(uNowNs - ptPacing->auFrameStartNs[uFrame]) / 1000000.0);
+    ptLatency->fLastMs    = fMs;
+    ptLatency->fAverageMs = ptLatency->uSampleCount == 0 ? fMs : ptLatency->fAverageMs + (fMs - ptLatency->fAverageMs) * HG_LATENCY_AVERAGE_WEIGHT;
+    if(fMs > ptLatency->fMaxMs) ptLatency->fMaxMs = fMs;
+    ptLatency->uSampleCount++;
+}
+
+// -------------------------------
+// headless render targets
+// -------------------------------
+void
+hg_create_offscreen_targets(hgAppData* ptState)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgSwapchain* ptSwapchain = &ptState->tSwapchainComponents;
+    VkDevice     tDevice     = ptState->tContextComponents.tDevice;
+
+    // one image per frame in flight is all the frame loop can use without a present engine holding images
+    uint32_t uImageCount = ptState->uSwapchainImageCount ? ptState->uSwapchainImageCount : hg_get_frames_in_flight(ptState);
+
+    ptSwapchain->tFormat               = VK_FORMAT_B8G8R8A8_UNORM;
+    ptSwapchain->tExtent               = (VkExtent2D){(uint32_t)ptState->width, (uint32_t)ptState->height};
+    ptSwapchain->tImageUsage           = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    ptSwapchain->tActivePresentMode    = ptSwapchain->tPresentMode;
+    ptSwapchain->uRequestedImageCount  = ptState->uSwapchainImageCount;
+    ptSwapchain->uSwapchainImageCount  = uImageCount;
+    ptSwapchain->tSwapchainImages      = malloc(uImageCount * sizeof(VkImage));
+    ptSwapchain->tSwapchainImageViews  = malloc(uImageCount * sizeof(VkImageView));
+    ptSwapchain->tOffscreenAllocations = calloc(uImageCount, sizeof(hgAllocation));
+    assert(ptSwapchain->tExtent.width > 0 && ptSwapchain->tExtent.height > 0 && "headless mode needs width/height set");
+
+    for(uint32_t i = 0; i < uImageCount; i++)
+    {
+        // transfer src so frames can be copied out (screenshots, golden images)
+        VkImageCreateInfo tImageInfo = {
+            .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType     = VK_IMAGE_TYPE_2D,
+            .extent        = {ptSwapchain->tExtent.width, ptSwapchain->tExtent.height, 1},
+            .mipLevels     = 1,
+            .arrayLayers   = 1,
+            .format        = ptSwapchain->tFormat,
+            .tiling        = VK_IMAGE_TILING_OPTIMAL,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .usage         = ptSwapchain->tImageUsage,
+            .samples       = VK_SAMPLE_COUNT_1_BIT,
+            .sharingMode   = VK_SHARING_MODE_EXCLUSIVE
+        };
+        VULKAN_CHECK(vkCreateImage(tDevice, &tImageInfo, NULL, &ptSwapchain->tSwapchainImages[i]));
+        hg_allocate_image_memory(ptState, ptSwapchain->tSwapchainImages[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &ptSwapchain->tOffscreenAllocations[i]);
+
+        VkImageViewCreateInfo tViewInfo = {
+            .sType              = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image              = ptSwapchain->tSwapchainImages[i],
+            .viewType           = VK_IMAGE_VIEW_TYPE_2D,
+            .format             = ptSwapchain->tFormat,
+            .subresourceRange   = {
+                .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel   = 0,
+                .levelCount     = 1,
+                .baseArrayLayer = 0,
+                .layerCount     = 1
+            }
+        };
+        VULKAN_CHECK(vkCreateImageView(tDevice, &tViewInfo, NULL, &ptSwapchain->tSwapchainImageViews[i]));
+    }
+    HG_TRACE_END();
+}
+
+// -------------------------------
+// swapchain retirement
+// -------------------------------
+void
+hg_retire_swapchain_resources(hgAppData* ptState, hgRetiredSwapchain* ptRetiredOut)
+{
+    hgSwapchain*      ptSwapchain = &ptState->tSwapchainComponents;
+    hgRenderPipeline* ptPipeline  = &ptState->tPipelineComponents;
+    hgFrameSync*      ptSync      = &ptState->tSyncComponents;
+
+    // move ownership, the swapchain handle itself is handled by the caller
+    memset(ptRetiredOut, 0, sizeof(hgRetiredSwapchain));
+    ptRetiredOut->tImageViews      = ptSwapchain->tSwapchainImageViews;
+    ptRetiredOut->tFramebuffers    = ptPipeline->tFramebuffers;
+    ptRetiredOut->uImageCount      = ptSwapchain->uSwapchainImageCount;
+    ptRetiredOut->tRenderFinished  = ptSync->tRenderFinished;
+    ptRetiredOut->tDepthImage      = ptPipeline->tDepthImage;
+    ptRetiredOut->tDepthImageView  = ptPipeline->tDepthImageView;
+    ptRetiredOut->tDepthAllocation = ptPipeline->tDepthAllocation;
+    ptRetiredOut->uRetireFrame     = ptSync->uFrameCount;
+
+    // swapchain image handles belong to the swapchain, only the array is ours -> headless images are ours entirely
+    if(ptState->bHeadless)
+    {
+        ptRetiredOut->tOffscreenImages      = ptSwapchain->tSwapchainImages;
+        ptRetiredOut->tOffscreenAllocations = ptSwapchain->tOffscreenAllocations;
+    }
+    else
+    {
+        free(ptSwapchain->tSwapchainImages);
+    }
+    free(ptSync->tImagesInFlight);
+    ptSwapchain->tOffscreenAllocations = NULL;
+
+    ptSwapchain->tSwapchainImages     = NULL;
+    ptSwapchain->tSwapchainImageViews = NULL;
+    ptSwapchain->uSwapchainImageCount = 0;
+    ptPipeline->tFramebuffers         = NULL;
+    ptPipeline->tDepthImage           = VK_NULL_HANDLE;
+    ptPipeline->tDepthImageView       = VK_NULL_HANDLE;
+    memset(&ptPipeline->tDepthAllocation, 0, sizeof(hgAllocation));
+    ptSync->tRenderFinished           = NULL;
+    ptSync->tImagesInFlight           = NULL;
+    ptSync->uImageCount               = 0;
+}
+
+void
+hg_destroy_retired_swapchain(hgAppData* ptState, hgRetiredSwapchain* ptRetired)
+{
+    VkDevice tDevice = ptState->tContextComponents.tDevice;
+
+    if(ptRetired->tDepthImageView != VK_NULL_HANDLE) vkDestroyImageView(tDevice, ptRetired->tDepthImageView, NULL);
+    if(ptRetired->tDepthImage != VK_NULL_HANDLE)     vkDestroyImage(tDevice, ptRetired->tDepthImage, NULL);
+    hg_free_memory(ptState, &ptRetired->tDepthAllocation);
+
+    for(uint32_t i = 0; i < ptRetired->uImageCount; i++)
+    {
+        if(ptRetired->tFramebuffers)   vkDestroyFramebuffer(tDevice, ptRetired->tFramebuffers[i], NULL);
+        if(ptRetired->tImageViews)     vkDestroyImageView(tDevice, ptRetired->tImageViews[i], NULL);
+        if(ptRetired->tRenderFinished) vkDestroySemaphore(tDevice, ptRetired->tRenderFinished[i], NULL);
+        if(ptRetired->tOffscreenImages)
+        {
+            vkDestroyImage(tDevice, ptRetired->tOffscreenImages[i], NULL);
+            hg_free_memory(ptState, &ptRetired->tOffscreenAllocations[i]);
+        }
+    }
+    free(ptRetired->tFramebuffers);
+    free(ptRetired->tImageViews);
+    free(ptRetired->tRenderFinished);
+    free(ptRetired->tOffscreenImages);
+    free(ptRetired->tOffscreenAllocations);
+
+    if(ptRetired->tSwapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(tDevice, ptRetired->tSwapchain, NULL);
+    memset(ptRetired, 0, sizeof(hgRetiredSwapchain));
+}
+
+// frames finish in submission order on the graphics queue
+bool
+hg_is_frame_complete(hgAppData* ptState, uint64_t uFrame)
+{
+    hgFrameSync* ptSync = &ptState->tSyncComponents;
+    for(uint32_t i = 0; i < hg_get_frames_in_flight(ptState); i++)
+    {
+        // a fence that was reused since was waited on first, so only a fence still holding this frame matters
+        if(ptSync->auSubmittedFrame[i] == uFrame)
+        {
+            return vkGetFenceStatus(ptState->tContextComponents.tDevice, ptSync->tInFlight[i]) == VK_SUCCESS;
+        }
+    }
+    return true;
+}
+
+void
+hg_collect_retired_swapchains(hgAppData* ptState, bool bWaitAll)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgSwapchain* ptSwapchain = &ptState->tSwapchainComponents;
+    hgFrameSync* ptSync      = &ptState->tSyncComponents;
+
+    if(bWaitAll && ptSwapchain->uRetiredCount > 0)
+    {
+        // never called between the fence reset in hg_begin_frame and the submit in hg_end_frame, so every fence will signal
+        for(uint32_t i = 0; i < hg_get_frames_in_flight(ptState); i++)
+        {
+            if(ptSync->tInFlight[i] != VK_NULL_HANDLE)
+            {
+                vkWaitForFences(ptState->tContextComponents.tDevice, 1, &ptSync->tInFlight[i], VK_TRUE, UINT64_MAX);
+            }
+        }
+    }
+
+    // retired in order, so stop at the first one still in use
+    uint32_t uCollected = 0;
+    while(uCollected < ptSwapchain->uRetiredCount)
+    {
+        hgRetiredSwapchain* ptRetired = &ptSwapchain->atRetired[uCollected];
+        if(!bWaitAll && !hg_is_frame_complete(ptState, ptRetired->uRetireFrame))
+        {
+            break;
+        }
+        hg_destroy_retired_swapchain(ptState, ptRetired);
+        uCollected++;
+    }
+
+    if(uCollected > 0)
+    {
+        ptSwapchain->uRetiredCount -= uCollected;
+        memmove(ptSwapchain->atRetired, &ptSwapchain->atRetired[uCollected], ptSwapchain->uRetiredCount * sizeof(hgRetiredSwapchain));
+    }
+    HG_TRACE_END();
+}
+
+// -------------------------------
+// readback ring
+// -------------------------------
+void
+hg_record_readbacks(hgAppData* ptState, VkCommandBuffer tCommandBuffer, uint32_t uImageIndex)
+{
+    hgReadbackRing* ptRing = &ptState->tReadbackComponents;
+    VkImage         tImage = ptState->tSwapchainComponents.tSwapchainImages[uImageIndex];
+
+    // render pass leaves the image ready to present (or to read back when headless)
+    VkImageLayout tFinalLayout = ptState->bHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    VkImageSubresourceRange tRange = {
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = 0,
+        .levelCount     = 1,
+        .baseArrayLayer = 0,
+        .layerCount     = 1
+    };
+
+    bool bTransitioned = false;
+    for(uint32_t i = 0; i < HG_READBACK_RING_SIZE; i++)
+    {
+        hgReadbackSlot* ptSlot = &ptRing->atSlots[i];
+        if(!ptSlot->bInUse || ptSlot->uFrame != 0)
+        {
+            continue;
+        }
+
+        if(!bTransitioned)
+        {
+            VkImageMemoryBarrier tToTransfer = {
+                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask       = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                .dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT,
+                .oldLayout           = tFinalLayout,
+                .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image               = tImage,
+                .subresourceRange    = tRange
+            };
+            vkCmdPipelineBarrier(tCommandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+                0, 0, NULL, 0, NULL, 1, &tToTransfer);
+            bTransitioned = true;
+        }
+
+        VkBufferImageCopy tRegion = {
+            .bufferOffset      = 0,
+            .bufferRowLength   = 0, // tightly packed
+            .bufferImageHeight = 0,
+            .imageSubresource  = {
+                .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel       = 0,
+                .baseArrayLayer = 0,
+                .layerCount     = 1
+            },
+            .imageOffset       = {0, 0, 0},
+            .imageExtent       = {ptSlot->uWidth, ptSlot->uHeight, 1}
+        };
+        vkCmdCopyImageToBuffer(tCommandBuffer, tImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, ptSlot->tBuffer, 1, &tRegion);
+
+        // delivered once the fence of this submission signals
+        ptSlot->uFrame = ptState->tSyncComponents.uFrameCount + 1;
+    }
+
+    if(!bTransitioned)
+    {
+        return;
+    }
+
+    // copies visible to the host after the fence, image back in the layout present expects
+    VkMemoryBarrier tToHost = {
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+    };
+    VkImageMemoryBarrier tToPresent = {
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask       = 0,
+        .dstAccessMask       = 0,
+        .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .newLayout           = tFinalLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image               = tImage,
+        .subresourceRange    = tRange
     };
+    vkCmdPipelineBarrier(tCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 
+        0, 1, &tToHost, 0, NULL, 1, &tToPresent);
+}
+
+void
+hg_deliver_readbacks(hgAppData* ptState, bool bWaitAll)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgReadbackRing* ptRing = &ptState->tReadbackComponents;
+    hgFrameSync*    ptSync = &ptState->tSyncComponents;
+
+    // oldest first so callbacks see frames in order
+    while(true)
+    {
+        hgReadbackSlot* ptOldest = NULL;
+        for(uint32_t i = 0; i < HG_READBACK_RING_SIZE; i++)
+        {
+            hgReadbackSlot* ptSlot = &ptRing->atSlots[i];
+            if(ptSlot->bInUse && ptSlot->uFrame != 0 && (!ptOldest || ptSlot->uFrame < ptOldest->uFrame))
+            {
+                ptOldest = ptSlot;
+            }
+        }
+        if(!ptOldest)
+        {
+            break;
+        }
+
+        if(!hg_is_frame_complete(ptState, ptOldest->uFrame))
+        {
+            if(!bWaitAll)
+            {
+                break;
+            }
+            for(uint32_t i = 0; i < hg_get_frames_in_flight(ptState); i++)
+            {
+                if(ptSync->auSubmittedFrame[i] == ptOldest->uFrame)
+                {
+                    vkWaitForFences(ptState->tContextComponents.tDevice, 1, &ptSync->tInFlight[i], VK_TRUE, UINT64_MAX);
+                }
+            }
+        }
 
-    VkCommandBuffer tCommandBuffer;
-    VULKAN_CHECK(vkAllocateCommandBuffers(ptContext->tDevice, &tBufferAllocInfo, &tCommandBuffer));
+        hgReadbackImage tImage = {
+            .pPixels   = ptOldest->tAllocation.pMapped,
+            .uWidth    = ptOldest->uWidth,
+            .uHeight   = ptOldest->uHeight,
+            .uRowPitch = ptOldest->uWidth * 4,
+            .tFormat   = ptOldest->tFormat,
+            .uFrame    = ptOldest->uFrame
+        };
 
-    // Record copy command
-    VkCommandBufferBeginInfo tBeginCommandBufferInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-    };
-    VULKAN_CHECK(vkBeginCommandBuffer(tCommandBuffer, &tBeginCommandBufferInfo));
+        // slot is released first so the callback can request the next readback
+        ptOldest->bInUse = false;
+        ptOldest->uFrame = 0;
+        ptOldest->pfCallback(&tImage, ptOldest->pUserData);
+    }
 
-    VkBufferCopy tCopyRegion = {
-        .srcOffset = 0,
-        .dstOffset = 0,
-        .size      = tSize
-    };
-    vkCmdCopyBuffer(tCommandBuffer, tSrcBuffer, tDstBuffer, 1, &tCopyRegion);
+    hg_reap_png_writers(ptState, false);
+    HG_TRACE_END();
+}
 
-    VULKAN_CHECK(vkEndCommandBuffer(tCommandBuffer));
+void
+hg_destroy_readback_ring(hgAppData* ptState)
+{
+    hgReadbackRing* ptRing = &ptState->tReadbackComponents;
+    for(uint32_t i = 0; i < HG_READBACK_RING_SIZE; i++)
+    {
+        hgReadbackSlot* ptSlot = &ptRing->atSlots[i];
 
-    // submit and wait for completion
-    VkSubmitInfo submitInfo = {
-        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .commandBufferCount = 1,
-        .pCommandBuffers    = &tCommandBuffer
-    };
-    VULKAN_CHECK(vkQueueSubmit(ptContext->tGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
-    VULKAN_CHECK(vkQueueWaitIdle(ptContext->tGraphicsQueue));  // wait for copy to finish
+        // requested but never recorded -> png requests are ours to free
+        if(ptSlot->bInUse && ptSlot->pfCallback == hg_png_capture_callback)
+        {
+            ((hgPngRequest*)ptSlot->pUserData)->ptJob->bReserved = false;
+            free(ptSlot->pUserData);
+        }
+        if(ptSlot->tBuffer != VK_NULL_HANDLE)
+        {
+            hg_destroy_buffer(ptState, &ptSlot->tBuffer, &ptSlot->tAllocation);
+        }
+        memset(ptSlot, 0, sizeof(hgReadbackSlot));
+    }
 
-    vkFreeCommandBuffers(ptContext->tDevice, ptCommands->tCommandPool, 1, &tCommandBuffer);
+    if(ptRing->ptPngWriter)
+    {
+        hg_reap_png_writers(ptState, true);
+        hg_mutex_destroy(&ptRing->ptPngWriter->tLock);
+        free(ptRing->ptPngWriter);
+        ptRing->ptPngWriter = NULL;
+    }
 }
 
 // -------------------------------
-// single time commands
+// png capture
 // -------------------------------
-VkCommandBuffer 
-hg_begin_single_time_commands(hgAppData* ptAppData) 
+void
+hg_png_capture_callback(const hgReadbackImage* ptImage, void* pUserData)
 {
-    VkCommandBufferAllocateInfo tAllocInfo = {
-        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandPool        = ptAppData->tCommandComponents.tCommandPool,
-        .commandBufferCount = 1
-    };
-    VkCommandBuffer tCommandBuffer;
-    VULKAN_CHECK(vkAllocateCommandBuffers(ptAppData->tContextComponents.tDevice, &tAllocInfo, &tCommandBuffer));
+    hgPngRequest* ptRequest = pUserData;
+    hgPngWriter*  ptWriter  = ptRequest->ptState->tReadbackComponents.ptPngWriter;
+    hgPngJob*     ptJob     = ptRequest->ptJob; // reserved by hg_capture_png, nothing to wait for here
+
+    // mapped readback memory goes back to the ring right after this callback, so the writer gets its own copy
+    size_t szSize = (size_t)ptImage->uRowPitch * ptImage->uHeight;
+    ptJob->pPixels = malloc(szSize);
+    memcpy(ptJob->pPixels, ptImage->pPixels, szSize);
+    ptJob->uWidth    = ptImage->uWidth;
+    ptJob->uHeight   = ptImage->uHeight;
+    ptJob->tFormat   = ptImage->tFormat;
+    ptJob->bDone     = false;
+    ptJob->bReserved = false;
+    ptJob->ptLock    = &ptWriter->tLock;
+    memcpy(ptJob->acPath, ptRequest->acPath, sizeof(ptJob->acPath));
+    free(ptRequest);
+
+    ptJob->bRunning = hg_thread_start(&ptJob->tThread, hg_png_write_job, ptJob);
+    if(!ptJob->bRunning)
+    {
+        hg_png_write_job(ptJob); // no thread available, encode right here
+    }
+}
 
-    VkCommandBufferBeginInfo tBeginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-    };
-    VULKAN_CHECK(vkBeginCommandBuffer(tCommandBuffer, &tBeginInfo));
-    return tCommandBuffer;
+void
+hg_png_write_job(void* pUserData)
+{
+    HG_TRACE_BEGIN(__func__);
+    hgPngJob* ptJob = pUserData;
+
+    // swapchain images are BGRA, the swapchain alpha is meaningless with an opaque composite
+    size_t szPixelCount = (size_t)ptJob->uWidth * ptJob->uHeight;
+    bool   bSwizzle     = ptJob->tFormat == VK_FORMAT_B8G8R8A8_UNORM || ptJob->tFormat == VK_FORMAT_B8G8R8A8_SRGB;
+    for(size_t i = 0; i < szPixelCount; i++)
+    {
+        unsigned char* pucPixel = &ptJob->pPixels[i * 4];
+        if(bSwizzle)
+        {
+            unsigned char ucBlue = pucPixel[0];
+            pucPixel[0] = pucPixel[2];
+            pucPixel[2] = ucBlue;
+        }
+        pucPixel[3] = 255;
+    }
+
+    if(!stbi_write_png(ptJob->acPath, (int)ptJob->uWidth, (int)ptJob->uHeight, 4, ptJob->pPixels, (int)ptJob->uWidth * 4))
+    {
+        printf("failed to write capture: %s\n", ptJob->acPath);
+    }
+    free(ptJob->pPixels);
+    ptJob->pPixels = NULL;
+
+    hg_mutex_lock(ptJob->ptLock);
+    ptJob->bDone = true;
+    hg_mutex_unlock(ptJob->ptLock);
+    HG_TRACE_END();
 }
 
-void 
-hg_end_single_time_commands(hgAppData* ptAppData, VkCommandBuffer tCommandBuffer) 
+void
+hg_reap_png_writers(hgAppData* ptState, bool bWaitAll)
 {
-    VULKAN_CHECK(vkEndCommandBuffer(tCommandBuffer));
+    hgPngWriter* ptWriter = ptState->tReadbackComponents.ptPngWriter;
+    if(!ptWriter)
+    {
+        return;
+    }
 
-    VkSubmitInfo tSubmitInfo = {
-        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .commandBufferCount = 1,
-        .pCommandBuffers    = &tCommandBuffer
-    };
+    for(uint32_t i = 0; i < HG_MAX_PNG_WRITERS; i++)
+    {
+        hgPngJob* ptJob = &ptWriter->atJobs[i];
+        if(!ptJob->bRunning)
+        {
+            continue;
+        }
 
-    // submit and wait for completion
-    VULKAN_CHECK(vkQueueSubmit(ptAppData->tContextComponents.tGraphicsQueue, 1, &tSubmitInfo, VK_NULL_HANDLE));
-    VULKAN_CHECK(vkQueueWaitIdle(ptAppData->tContextComponents.tGraphicsQueue));
+        hg_mutex_lock(&ptWriter->tLock);
+        bool bDone = ptJob->bDone;
+        hg_mutex_unlock(&ptWriter->tLock);
 
-    // free the command buffer
-    vkFreeCommandBuffers(ptAppData->tContextComponents.tDevice, ptAppData->tCommandComponents.tCommandPool, 1, &tCommandBuffer);
+        if(bDone || bWaitAll)
+        {
+            hg_thread_join(ptJob->tThread);
+            ptJob->bRunning = false;
+        }
+    }
 }
 
 // -------------------------------
-// image operations
+// gpu profiler
 // -------------------------------
-void 
-hg_transition_image_layout(VkCommandBuffer tCommandBuffer, VkImage tImage, VkImageLayout tOldLayout, 
-    VkImageLayout tNewLayout, VkImageSubresourceRange tSubresourceRange, VkPipelineStageFlags tSrcStageMask, 
-    VkPipelineStageFlags tDstStageMask) 
+void
+hg_create_gpu_profiler(hgAppData* ptState)
 {
-    VkImageMemoryBarrier tBarrier = {
-        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .oldLayout           = tOldLayout,
-        .newLayout           = tNewLayout,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image               = tImage,
-        .subresourceRange    = tSubresourceRange,
-    };
+    hgGpuProfiler*   ptProfiler = &ptState->tProfilerComponents;
+    hgVulkanContext* ptContext  = &ptState->tContextComponents;
+    memset(ptProfiler, 0, sizeof(hgGpuProfiler));
 
-    // source layouts (old)
-    switch (tOldLayout) 
+    if(!ptState->bGpuProfiling)
     {
-        case VK_IMAGE_LAYOUT_UNDEFINED:
-            tBarrier.srcAccessMask = 0;
-            break;
+        return;
+    }
 
-        case VK_IMAGE_LAYOUT_PREINITIALIZED:
-            tBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-            break;
+    uint32_t uFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(ptContext->tPhysicalDevice, &uFamilyCount, NULL);
+    VkQueueFamilyProperties* ptFamilies = malloc(uFamilyCount * sizeof(VkQueueFamilyProperties));
+    vkGetPhysicalDeviceQueueFamilyProperties(ptContext->tPhysicalDevice, &uFamilyCount, ptFamilies);
+    uint32_t uValidBits = ptFamilies[ptContext->tGraphicsQueueFamily].timestampValidBits;
+    free(ptFamilies);
 
-        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-            tBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            break;
+    if(uValidBits == 0 || ptContext->tDeviceProperties.limits.timestampPeriod == 0.0f)
+    {
+        printf("gpu profiling not available, the graphics queue has no timestamps\n");
+        return;
+    }
+    ptProfiler->fPeriodNs      = ptContext->tDeviceProperties.limits.timestampPeriod;
+    ptProfiler->uTimestampMask = uValidBits >= 64 ? UINT64_MAX : ((1ull << uValidBits) - 1);
 
-        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-            tBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            break;
+    VkQueryPoolCreateInfo tPoolInfo = {
+        .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = HG_MAX_FRAMES_IN_FLIGHT * HG_MAX_GPU_SCOPES * 2
+    };
+    VULKAN_CHECK(vkCreateQueryPool(ptContext->tDevice, &tPoolInfo, NULL, &ptProfiler->tQueryPool));
 
-        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-            tBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            break;
+    if(ptContext->tTransferQueueFamily == ptContext->tGraphicsQueueFamily)
+    {
+        tPoolInfo.queryCount = HG_MAX_UPLOAD_SUBMISSIONS * 2;
+        VULKAN_CHECK(vkCreateQueryPool(ptContext->tDevice, &tPoolInfo, NULL, &ptProfiler->tUploadQueryPool));
+    }
+}
 
-        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-            tBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            break;
+void
+hg_destroy_gpu_profiler(hgAppData* ptState)
+{
+    hgGpuProfiler* ptProfiler = &ptState->tProfilerComponents;
+    VkDevice       tDevice    = ptState->tContextComponents.tDevice;
+    if(ptProfiler->tQueryPool != VK_NULL_HANDLE)       vkDestroyQueryPool(tDevice, ptProfiler->tQueryPool, NULL);
+    if(ptProfiler->tUploadQueryPool != VK_NULL_HANDLE) vkDestroyQueryPool(tDevice, ptProfiler->tUploadQueryPool, NULL);
+    memset(ptProfiler, 0, sizeof(hgGpuProfiler));
+}
 
-        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-            tBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            break;
+void
+hg_reset_gpu_frame(hgAppData* ptState, VkCommandBuffer tCommandBuffer)
+{
+    hgGpuProfiler* ptProfiler = &ptState->tProfilerComponents;
+    if(ptProfiler->tQueryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
 
-        default:
-            break;
+    // queries have to be reset before they are written again, done outside of any render pass
+    uint32_t uFrame = ptState->tSyncComponents.uCurrentFrame;
+    vkCmdResetQueryPool(tCommandBuffer, ptProfiler->tQueryPool, uFrame * HG_MAX_GPU_SCOPES * 2, HG_MAX_GPU_SCOPES * 2);
+    ptProfiler->auScopeCount[uFrame] = 0;
+    ptProfiler->auFrame[uFrame]      = ptState->tSyncComponents.uFrameCount + 1;
+    ptProfiler->uOpenCount           = 0;
+}
+
+void
+hg_resolve_gpu_frame(hgAppData* ptState, uint32_t uFrame)
+{
+    hgGpuProfiler* ptProfiler = &ptState->tProfilerComponents;
+    uint32_t       uCount     = ptProfiler->auScopeCount[uFrame];
+    if(ptProfiler->tQueryPool == VK_NULL_HANDLE || ptProfiler->auFrame[uFrame] == 0 || uCount == 0)
+    {
+        return;
     }
 
-    // target layouts (new)
-    switch (tNewLayout) 
+    // no wait flag -> the fence already signaled, anything still unavailable (never submitted) just skips the frame
+    uint64_t auTimestamps[HG_MAX_GPU_SCOPES * 2];
+    VkResult tResult = vkGetQueryPoolResults(ptState->tContextComponents.tDevice, ptProfiler->tQueryPool, 
+        uFrame * HG_MAX_GPU_SCOPES * 2, uCount * 2, sizeof(auTimestamps), auTimestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    ptProfiler->auFrame[uFrame] = 0;
+    if(tResult != VK_SUCCESS)
     {
-        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-            tBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-            break;
+        return;
+    }
 
-        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-            tBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-            break;
+    hgGpuFrameProfile* ptProfile = &ptProfiler->tLastFrame;
+    ptProfile->uFrame      = ptState->tSyncComponents.auSubmittedFrame[uFrame];
+    ptProfile->uScopeCount = 0;
+    int32_t aiResultIndex[HG_MAX_GPU_SCOPES]; // recorded scope -> result index (skipped scopes shift the rest)
+    for(uint32_t i = 0; i < uCount; i++)
+    {
+        // a scope left open at submit has no end timestamp
+        hgGpuScope* ptScope = &ptProfiler->aatScopes[uFrame][i];
+        aiResultIndex[i] = -1;
+        if(!ptScope->bClosed)
+        {
+            continue;
+        }
 
-        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-            tBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            break;
+        uint64_t uTicks = (auTimestamps[i * 2 + 1] - auTimestamps[i * 2]) & ptProfiler->uTimestampMask;
+        aiResultIndex[i] = (int32_t)ptProfile->uScopeCount;
+        hgGpuScopeResult* ptResult = &ptProfile->atScopes[ptProfile->uScopeCount++];
+        ptResult->pcName  = ptScope->pcName;
+        ptResult->uDepth  = ptScope->uDepth;
+        ptResult->iParent = ptScope->iParent >= 0 ? aiResultIndex[ptScope->iParent] : -1;
+        ptResult->fMs     = (float)((double)uTicks * ptProfiler->fPeriodNs / 1000000.0);
+        hg_update_gpu_scope_stats(ptState, ptResult);
+    }
+}
 
-        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-            tBarrier.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-            break;
+void
+hg_resolve_upload_timestamps(hgAppData* ptState, uint32_t uSubmission)
+{
+    hgGpuProfiler* ptProfiler = &ptState->tProfilerComponents;
+    if(ptProfiler->tUploadQueryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
 
-        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-            if (tBarrier.srcAccessMask == 0) 
-            {
-                tBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
-            }
-            tBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-            break;
+    uint64_t auTimestamps[2];
+    VkResult tResult = vkGetQueryPoolResults(ptState->tContextComponents.tDevice, ptProfiler->tUploadQueryPool, 
+        uSubmission * 2, 2, sizeof(auTimestamps), auTimestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if(tResult != VK_SUCCESS)
+    {
+        return;
+    }
 
-        default:
+    hgGpuScopeResult* ptResult = &ptProfiler->tLastFrame.tUpload;
+    uint64_t          uTicks   = (auTimestamps[1] - auTimestamps[0]) & ptProfiler->uTimestampMask;
+    ptResult->pcName  = "upload";
+    ptResult->uDepth  = 0;
+    ptResult->iParent = -1;
+    ptResult->fMs     = (float)((double)uTicks * ptProfiler->fPeriodNs / 1000000.0);
+    hg_update_gpu_scope_stats(ptState, ptResult);
+}
+
+void
+hg_update_gpu_scope_stats(hgAppData* ptState, hgGpuScopeResult* ptResult)
+{
+    hgGpuProfiler*   ptProfiler = &ptState->tProfilerComponents;
+    hgGpuScopeStats* ptStats    = NULL;
+
+    // scopes sharing a name share their stats (same pass recorded every frame)
+    for(uint32_t i = 0; i < ptProfiler->uStatCount; i++)
+    {
+        if(strcmp(ptProfiler->atStats[i].pcName, ptResult->pcName) == 0)
+        {
+            ptStats = &ptProfiler->atStats[i];
             break;
+        }
+    }
+    if(!ptStats)
+    {
+        if(ptProfiler->uStatCount == HG_MAX_GPU_SCOPES)
+        {
+            ptResult->fAverageMs = ptResult->fMs;
+            ptResult->fMaxMs     = ptResult->fMs;
+            return;
+        }
+        ptStats = &ptProfiler->atStats[ptProfiler->uStatCount++];
+        ptStats->pcName     = ptResult->pcName;
+        ptStats->fAverageMs = ptResult->fMs;
+        ptStats->fMaxMs     = 0.0f;
     }
 
-    vkCmdPipelineBarrier(tCommandBuffer, tSrcStageMask, tDstStageMask, 0, 0, NULL, 0, NULL, 1, &tBarrier);
+    ptStats->fAverageMs += (ptResult->fMs - ptStats->fAverageMs) * HG_GPU_TIME_AVERAGE_WEIGHT;
+    if(ptResult->fMs > ptStats->fMaxMs) ptStats->fMaxMs = ptResult->fMs;
+    ptStats->uSampleCount++;
+
+    ptResult->fAverageMs = ptStats->fAverageMs;
+    ptResult->fMaxMs     = ptStats->fMaxMs;
 }
 
-void 
-hg_upload_to_image(hgAppData* ptAppData, VkImage tImage, const unsigned char* pData, int iWidth, int iHeight)
+// -------------------------------
+// cpu tracing
+// -------------------------------
+#ifdef HG_ENABLE_TRACE
+hgTraceBuffer*
+hg_trace_acquire_buffer(void)
 {
-    VkDeviceSize imageSize = iWidth * iHeight * 4; // RGBA8
+    // reuse the buffer of an exited thread (pipeline workers come and go), its events stay in the trace
+    hg_mutex_lock(&gtTraceLock);
+    hgTraceBuffer* ptBuffer = gptTraceBuffers;
+    while(ptBuffer && ptBuffer->bOwned)
+    {
+        ptBuffer = ptBuffer->ptNext;
+    }
+    if(!ptBuffer)
+    {
+        if(guTraceThreadCount == 0) guTraceStartNs = hg_get_time_ns();
 
-    // create staging buffer
-    VkBuffer       tStagingBuffer;
-    VkDeviceMemory tStagingBufferMemory;
-    hg_create_buffer(&ptAppData->tContextComponents, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &tStagingBuffer, &tStagingBufferMemory);
+        ptBuffer = calloc(1, sizeof(hgTraceBuffer));
+        ptBuffer->uThreadId = guTraceThreadCount++;
+        ptBuffer->ptNext    = gptTraceBuffers;
+        gptTraceBuffers     = ptBuffer;
+    }
+    ptBuffer->bOwned     = true;
+    ptBuffer->uOpenCount = 0;
+    hg_mutex_unlock(&gtTraceLock);
 
-    // copy data to staging buffer
-    void* pMapped;
-    vkMapMemory(ptAppData->tContextComponents.tDevice, tStagingBufferMemory, 0, imageSize, 0, &pMapped);
-    memcpy(pMapped, pData, imageSize);
-    vkUnmapMemory(ptAppData->tContextComponents.tDevice, tStagingBufferMemory);
+    gptThreadTrace = ptBuffer;
+    return ptBuffer;
+}
 
-    // record copy commands
-    VkCommandBuffer tCmdBuffer = hg_begin_single_time_commands(ptAppData);
+void
+hg_trace_release_buffer(void)
+{
+    if(!gptThreadTrace)
+    {
+        return;
+    }
+    hg_mutex_lock(&gtTraceLock);
+    gptThreadTrace->bOwned = false;
+    hg_mutex_unlock(&gtTraceLock);
+    gptThreadTrace = NULL;
+}
+#endif
 
-    // transition to transfer dst
-    VkImageSubresourceRange tSubResRan = {
-        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-        .baseMipLevel   = 0,
-        .levelCount     = 1,
-        .baseArrayLayer = 0,
-        .layerCount     = 1
-    };
+// -------------------------------
+// instance streams
+// -------------------------------
+void
+hg_write_instance_data(hgInstanceData* atInstances, const float* afModels, const float* afColors, uint32_t uCount)
+{
+    for(uint32_t i = 0; i < uCount; i++)
+    {
+        memcpy(atInstances[i].afModel, &afModels[i * 16], sizeof(float) * 16);
+        if(afColors) memcpy(atInstances[i].afColor, &afColors[i * 4], sizeof(float) * 4);
+        else         memcpy(atInstances[i].afColor, (float[4]){1.0f, 1.0f, 1.0f, 1.0f}, sizeof(float) * 4);
+    }
+}
 
-    hg_transition_image_layout(tCmdBuffer, tImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
-        tSubResRan, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+// -------------------------------
+// bound state tracker
+// -------------------------------
+hgBoundState*
+hg_get_bound_state(hgAppData* ptState)
+{
+    return &ptState->tCommandComponents.atBoundState[ptState->tSyncComponents.uCurrentFrame];
+}
 
-    // copy buffer to image
-    VkBufferImageCopy tRegion = {
-        .bufferOffset       = 0,
-        .bufferRowLength    = 0,
-        .bufferImageHeight  = 0,
-        .imageSubresource   = {
-            .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-            .mipLevel       = 0,
-            .baseArrayLayer = 0,
-            .layerCount     = 1
-        },
-        .imageOffset        = {0, 0, 0},
-        .imageExtent        = {iWidth, iHeight, 1}
-    };
-    vkCmdCopyBufferToImage(tCmdBuffer, tStagingBuffer, tImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &tRegion);
+void
+hg_reset_bound_state(hgAppData* ptState, uint32_t uFrame)
+{
+    memset(&ptState->tCommandComponents.atBoundState[uFrame], 0, sizeof(hgBoundState));
+}
 
-    // transition to shader read
-    hg_transition_image_layout(tCmdBuffer, tImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 
-        tSubResRan, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+void
+hg_track_pipeline_layout(hgBoundState* ptBound, VkPipelineLayout tLayout)
+{
+    // sets and push constants recorded against another layout may be disturbed -> forget them instead of checking compatibility
+    if(ptBound->tLayout == tLayout) return;
+
+    ptBound->tLayout = tLayout;
+    memset(ptBound->atSets, 0, sizeof(ptBound->atSets));
+    memset(ptBound->atPushStages, 0, sizeof(ptBound->atPushStages));
+}
 
-    hg_end_single_time_commands(ptAppData, tCmdBuffer);
+void
+hg_track_index_buffer(hgAppData* ptState, VkBuffer tBuffer, VkDeviceSize tOffset, VkIndexType tIndexType)
+{
+    hgBoundState* ptBound = hg_get_bound_state(ptState);
+    if(ptBound->tIndexBuffer == tBuffer && ptBound->tIndexOffset == tOffset && ptBound->tIndexType == tIndexType)
+    {
+        ptBound->tStats.uBindsSkipped++;
+        return;
+    }
 
-    // cleanup staging
-    vkDestroyBuffer(ptAppData->tContextComponents.tDevice, tStagingBuffer, NULL);
-    vkFreeMemory(ptAppData->tContextComponents.tDevice, tStagingBufferMemory, NULL);
+    vkCmdBindIndexBuffer(hg_get_current_frame_cmd_buffer(ptState), tBuffer, tOffset, tIndexType);
+    ptBound->tIndexBuffer = tBuffer;
+    ptBound->tIndexOffset = tOffset;
+    ptBound->tIndexType   = tIndexType;
+    ptBound->tStats.uBindsIssued++;
 }
 
 // -------------------------------
-// shader loading
+// geometry pools
 // -------------------------------
-VkShaderModule 
-hg_create_shader_module(hgAppData* ptAppData, const char* pcFilename) 
+void
+hg_create_geometry_buffers(hgAppData* ptState, hgGeometryPool* ptPool)
 {
-    FILE* pFile = fopen(pcFilename, "rb");
-    if(!pFile) 
-    {
-        // try one fallback location
-        char szFallbackPath[256];
-        snprintf(szFallbackPath, sizeof(szFallbackPath), "../out/shaders/%s", pcFilename);
-        pFile = fopen(szFallbackPath, "rb");
+    // transfer source too, compaction copies the meshes over into a fresh pair
+    hg_create_buffer(ptState, (VkDeviceSize)ptPool->uVertexCapacity * ptPool->uVertexStride, 
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &ptPool->tVertexBuffer, &ptPool->tVertexAllocation);
+    hg_create_buffer(ptState, (VkDeviceSize)ptPool->uIndexCapacity * hg_index_size(ptPool->tIndexType), 
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &ptPool->tIndexBuffer, &ptPool->tIndexAllocation);
+}
 
-        if(!pFile) 
+void
+hg_reclaim_geometry_ranges(hgAppData* ptState, hgGeometryPool* ptPool)
+{
+    // a retire frame that hasn't been submitted yet may still be recording draws of the mesh
+    uint64_t uLastSubmitted = ptState->tSyncComponents.uFrameCount;
+    uint32_t uKept          = 0;
+    for(uint32_t i = 0; i < ptPool->uRetiredCount; i++)
+    {
+        hgRetiredMesh* ptRetired = &ptPool->atRetired[i];
+        if(ptRetired->uRetireFrame > uLastSubmitted || !hg_is_frame_complete(ptState, ptRetired->uRetireFrame))
         {
-            printf("Failed to open shader file: %s\n", pcFilename);
-            printf("Also tried: %s\n", szFallbackPath);
-            return VK_NULL_HANDLE;
+            ptPool->atRetired[uKept++] = *ptRetired;
+            continue;
         }
-        printf("Found shader at: %s\n", szFallbackPath);
+        hg_range_list_free(&ptPool->tFreeVertices, (VkDeviceSize)ptRetired->tMesh.iVertexOffset, ptRetired->tMesh.uVertexCount);
+        hg_range_list_free(&ptPool->tFreeIndices, ptRetired->tMesh.uFirstIndex, ptRetired->tMesh.uIndexCount);
     }
-    else
+    ptPool->uRetiredCount = uKept;
+
+    // same for buffer pairs replaced by a compaction
+    uKept = 0;
+    for(uint32_t i = 0; i < ptPool->uRetiredBufferCount; i++)
     {
-        printf("Found shader at: %s\n", pcFilename);
+        hgRetiredBuffers* ptRetired = &ptPool->atRetiredBuffers[i];
+        if(ptRetired->uRetireFrame > uLastSubmitted || !hg_is_frame_complete(ptState, ptRetired->uRetireFrame))
+        {
+            ptPool->atRetiredBuffers[uKept++] = *ptRetired;
+            continue;
+        }
+        hg_destroy_buffer(ptState, &ptRetired->tVertexBuffer, &ptRetired->tVertexAllocation);
+        hg_destroy_buffer(ptState, &ptRetired->tIndexBuffer, &ptRetired->tIndexAllocation);
     }
-
-    fseek(pFile, 0, SEEK_END);
-    long lSize = ftell(pFile);
-    rewind(pFile);
-
-    uint32_t* puCode = malloc(lSize);
-    fread(puCode, lSize, 1, pFile);
-    fclose(pFile);
-
-    VkShaderModuleCreateInfo tCreateInfo = {
-        .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .codeSize = lSize,
-        .pCode    = puCode
-    };
-
-    VkShaderModule tShaderModule;
-    VULKAN_CHECK(vkCreateShaderModule(ptAppData->tContextComponents.tDevice, &tCreateInfo, NULL, &tShaderModule));
-
-    free(puCode);
-    return tShaderModule;
+    ptPool->uRetiredBufferCount = uKept;
 }
 
 // -------------------------------
-// command buffer access
+// render queue
 // -------------------------------
-VkCommandBuffer 
-hg_get_current_frame_cmd_buffer(hgAppData* ptState) 
+hgRenderQueueEntry*
+hg_radix_sort_entries(hgRenderQueueEntry* atEntries, hgRenderQueueEntry* atScratch, uint32_t uCount)
 {
-    return ptState->tCommandComponents.tCommandBuffers[ptState->tCommandComponents.uCurrentImageIndex];
+    // lsd, one key byte per pass -> stable, so equal keys keep the order they were queued in
+    hgRenderQueueEntry* atSrc = atEntries;
+    hgRenderQueueEntry* atDst = atScratch;
+    for(uint32_t uShift = 0; uShift < 64 && uCount > 1; uShift += 8)
+    {
+        uint32_t auOffsets[256] = {0};
+        for(uint32_t i = 0; i < uCount; i++) auOffsets[(atSrc[i].uKey >> uShift) & 0xff]++;
+
+        // all keys share this byte (unused layers, ids or depth bits) -> the pass wouldn't move anything
+        if(auOffsets[(atSrc[0].uKey >> uShift) & 0xff] == uCount) continue;
+
+        uint32_t uSum = 0;
+        for(uint32_t uBucket = 0; uBucket < 256; uBucket++)
+        {
+            uint32_t uBucketCount = auOffsets[uBucket];
+            auOffsets[uBucket]    = uSum;
+            uSum                 += uBucketCount;
+        }
+        for(uint32_t i = 0; i < uCount; i++) atDst[auOffsets[(atSrc[i].uKey >> uShift) & 0xff]++] = atSrc[i];
+
+        hgRenderQueueEntry* atSwap = atSrc;
+        atSrc = atDst;
+        atDst = atSwap;
+    }
+    return atSrc;
 }
 
 // -------------------------------
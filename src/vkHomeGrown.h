@@ -6,7 +6,11 @@
 #define VKHOMEGROWN_H
 
 #include <vulkan/vulkan.h>
-#include <GLFW/glfw3.h>
+#ifndef HG_NO_GLFW
+    #include <GLFW/glfw3.h>
+#else
+    typedef struct GLFWwindow GLFWwindow; // headless only builds (no window system needed at all)
+#endif
 #include <stdlib.h>
 #include <stdbool.h>
 
@@ -29,6 +33,43 @@
 // MACROS
 // =============================================================================
 
+#define HG_DEFAULT_MEMORY_BLOCK_SIZE (64ull * 1024 * 1024) // size of the device memory blocks resources are sub-allocated from
+#define HG_DEFAULT_STAGING_RING_SIZE (32ull * 1024 * 1024) // used when hgAppData::szStagingRingSize is left at 0
+#define HG_MAX_UPLOAD_SUBMISSIONS    8                     // upload command buffers that can be in flight at once
+#define HG_MAX_FRAMES_IN_FLIGHT      3
+#define HG_DEFAULT_TRANSIENT_SIZE    (4ull * 1024 * 1024)  // per frame region of the transient allocator, see hgAppData::szTransientFrameSize
+#define HG_DEFAULT_FRAMES_IN_FLIGHT  2                     // used when hgAppData::uFramesInFlight is left at 0
+#define HG_DEFAULT_PIPELINE_CACHE    "pipeline_cache.bin"  // used when hgAppData::pcPipelineCachePath is left at NULL
+#define HG_MAX_PIPELINE_WORKERS      16                    // threads hg_create_graphics_pipelines may use (including the caller)
+#define HG_MAX_RETIRED_SWAPCHAINS    4                     // old swapchains waiting on frame fences before destruction
+#define HG_LATENCY_AVERAGE_WEIGHT    0.1f                  // weight of the newest sample in the rolling latency average
+#define HG_PACING_SPIN_NS            2000000ull            // how long before the fps cap deadline hgAppData::bPrecisePacing stops sleeping and spins
+#define HG_READBACK_RING_SIZE        4                     // frame readbacks that can be pending at once (each holds a full color image)
+#define HG_MAX_PNG_WRITERS           4                     // png captures waiting for their readback or encoding at once, hg_capture_png fails beyond that
+#define HG_MAX_GPU_SCOPES            64                    // timed gpu scopes per frame (two timestamps each), extra scopes are not timed
+#define HG_MAX_GPU_SCOPE_DEPTH       16                    // nesting limit of gpu scopes
+#define HG_GPU_TIME_AVERAGE_WEIGHT   0.1f                  // weight of the newest sample in the rolling gpu scope averages
+#define HG_MAX_VERTEX_BINDINGS       8                     // vertex buffer bindings a pipeline/the bound state tracker supports (maxVertexInputBindings is at least 16)
+#define HG_INSTANCE_ATTRIBUTE_COUNT  5                     // locations used by an hgInstanceData stream (mat4 takes four)
+#define HG_MAX_BOUND_DESCRIPTOR_SETS 8                     // descriptor set slots the bound state tracker remembers (maxBoundDescriptorSets is at least 4)
+#define HG_MAX_DYNAMIC_OFFSETS       8                     // dynamic offsets per hg_cmd_bind_descriptor_sets call
+#define HG_MAX_TRACKED_PUSH_BYTES    128                   // push constant bytes shadowed for redundancy checks (the guaranteed minimum size)
+#define HG_MAX_PACKET_SETS           4                     // descriptor sets one hgDrawPacket binds (from set 0)
+#define HG_MAX_PACKET_PUSH_BYTES     64                    // push constants one hgDrawPacket carries (a model matrix)
+#define HG_SORT_KEY_DEPTH_MAX        0x7fffffull           // depth is quantized to 23 bits of the sort key
+
+#define HG_TRACE_EVENTS_PER_THREAD   (16 * 1024)           // ring of finished cpu trace scopes per thread, newest overwrite oldest
+#define HG_TRACE_MAX_DEPTH           32                    // nesting limit of cpu trace scopes
+
+// cpu tracing -> build with -DHG_ENABLE_TRACE, otherwise the scopes compile to nothing
+#ifdef HG_ENABLE_TRACE
+    #define HG_TRACE_BEGIN(name) hg_trace_begin(name)
+    #define HG_TRACE_END()       hg_trace_end()
+#else
+    #define HG_TRACE_BEGIN(name) ((void)0)
+    #define HG_TRACE_END()       ((void)0)
+#endif
+
 #define VULKAN_CHECK(result) if((result) != VK_SUCCESS) { \
     printf("vulkan error at %s:%d: %d\n", __FILE__, __LINE__, (result)); \
     exit(1); \
@@ -46,28 +87,146 @@ typedef struct _hgVertex
     float u, v;       // texture coords 
 } hgVertex;
 
+// standard per instance stream layout (see hg_alloc_instance_stream/hg_get_instance_attributes)
+typedef struct _hgInstanceData
+{
+    float afModel[16]; // column major model matrix
+    float afColor[4];  // multiplied with the vertex color by the instanced shaders
+} hgInstanceData;
+
+// sub-allocation out of one of the allocator's memory blocks (see hgMemoryAllocator)
+typedef struct _hgAllocation
+{
+    struct _hgMemoryBlock* ptBlock;  // owning block -> NULL if nothing is allocated
+    VkDeviceMemory         tMemory;  // block memory, cached here for binding
+    VkDeviceSize           tOffset;  // offset of this allocation inside the block
+    VkDeviceSize           tSize;
+    void*                  pMapped;  // only set for host visible memory (blocks stay mapped)
+} hgAllocation;
+
+// free range inside a memory block (bytes) or a geometry pool (vertices/indices)
+typedef struct _hgMemoryRange
+{
+    VkDeviceSize tOffset;
+    VkDeviceSize tSize;
+} hgMemoryRange;
+
+// free list sorted by offset, neighbours are merged on free
+typedef struct _hgRangeList
+{
+    hgMemoryRange* atRanges;
+    uint32_t       uCount;
+    uint32_t       uCapacity;
+} hgRangeList;
+
+typedef struct _hgAllocatorStats
+{
+    uint32_t     uBlockCount;
+    uint32_t     uDedicatedBlockCount; // blocks holding a single large allocation
+    uint32_t     uAllocationCount;
+    uint32_t     uFreeRangeCount;
+    VkDeviceSize tTotalBytes;          // memory actually allocated from the driver
+    VkDeviceSize tUsedBytes;           // memory handed out to resources
+    VkDeviceSize tLargestFreeRange;
+    float        fFragmentation;       // 0 -> all free memory is one range, approaches 1 as it gets split up
+} hgAllocatorStats;
+
+// returned by hg_submit_upload_batch -> 0 never refers to pending work
+typedef uint64_t hgUploadTicket;
+
+// how far the cpu may run ahead of the display (see hgAppData::tPacingMode)
+typedef enum _hgPacingMode
+{
+    HG_PACING_THROUGHPUT  = 0, // record up to hgAppData::uFramesInFlight frames ahead
+    HG_PACING_LOW_LATENCY = 1, // wait for the previous frame before starting the next -> input sampled as late as possible
+    HG_PACING_FPS_CAP     = 2  // sleep to hgAppData::fTargetFps, saves power on fixed rate displays
+} hgPacingMode;
+
+// cpu frame start (hg_begin_frame) to the gpu finishing that frame, the present is queued right behind it
+typedef struct _hgFrameLatency
+{
+    float    fLastMs;
+    float    fAverageMs;   // rolling, see HG_LATENCY_AVERAGE_WEIGHT
+    float    fMaxMs;
+    uint64_t uSampleCount;
+} hgFrameLatency;
+
+// what the bound state tracker did while recording a frame (see hg_get_bind_stats)
+typedef struct _hgBindStats
+{
+    uint32_t uBindsIssued;  // vkCmdBind*/vkCmdPushConstants that reached the command buffer
+    uint32_t uBindsSkipped; // calls dropped because the same state was already bound
+    uint32_t uDraws;
+    uint32_t uInstances;    // summed over all draws
+} hgBindStats;
+
+// pixels of a finished readback (see hg_request_readback) -> only valid during the callback, copy them to keep them
+typedef struct _hgReadbackImage
+{
+    const void* pPixels;
+    uint32_t    uWidth;
+    uint32_t    uHeight;
+    uint32_t    uRowPitch; // bytes per row (tightly packed, 4 bytes per pixel)
+    VkFormat    tFormat;   // swapchain format -> B8G8R8A8, so swizzle before writing RGBA files
+    uint64_t    uFrame;    // frame number the pixels come from (counts submitted frames from 1)
+} hgReadbackImage;
+
+typedef void (*hgReadbackCallback)(const hgReadbackImage* ptImage, void* pUserData);
+
+// gpu time of one scope, averages/max are kept per scope name across frames
+typedef struct _hgGpuScopeResult
+{
+    const char* pcName;
+    uint32_t    uDepth;     // 0 -> the "frame" scope around the whole command buffer
+    int32_t     iParent;    // index into hgGpuFrameProfile::atScopes, -1 for the root
+    float       fMs;
+    float       fAverageMs; // rolling, see HG_GPU_TIME_AVERAGE_WEIGHT
+    float       fMaxMs;
+} hgGpuScopeResult;
+
+// scope tree of the last frame the gpu finished -> scopes are in begin order, so children follow their parent
+typedef struct _hgGpuFrameProfile
+{
+    uint64_t         uFrame;
+    uint32_t         uScopeCount;
+    hgGpuScopeResult atScopes[HG_MAX_GPU_SCOPES];
+    hgGpuScopeResult tUpload;  // last finished upload batch (only timed when uploads share the graphics queue)
+} hgGpuFrameProfile;
+
 typedef struct _hgTexture
 {
     VkImage        tImage;
     VkImageView    tImageView;
-    VkDeviceMemory tMemory;
+    hgAllocation   tAllocation;
     int            iWidth;
     int            iHeight;
 } hgTexture;
 
+// per frame scratch memory (see hg_alloc_transient) -> valid until this frame slot is reused
+typedef struct _hgTransientAllocation
+{
+    void*        pData;    // cpu write pointer
+    VkBuffer     tBuffer;  // bind this buffer ...
+    VkDeviceSize tOffset;  // ... at this offset (also works as a dynamic uniform offset)
+    VkDeviceSize tSize;
+} hgTransientAllocation;
+
 // Add to header
 typedef struct _hgUniformBuffer
 {
     VkBuffer       tBuffer;
-    VkDeviceMemory tMemory;
-    void*          pMapped;  // keep mapped for updates
+    hgAllocation   tAllocation;
+    void*          pMapped;      // keep mapped for updates
     size_t         szSize;
+    size_t         szSlotSize;   // dynamic only: bytes per object
+    size_t         szSlotStride; // dynamic only: slot size rounded up to minUniformBufferOffsetAlignment
+    uint32_t       uSlotCount;   // dynamic only: slots per frame in flight (0 -> plain uniform buffer)
 } hgUniformBuffer;
 
 typedef struct _hgVertexBuffer
 {
     VkBuffer       tBuffer;
-    VkDeviceMemory tMemory;
+    hgAllocation   tAllocation;
     size_t         szSize;
     uint32_t       uVertexCount;
     void*          pDataMapped; // TODO: do i need this stored? 
@@ -76,18 +235,131 @@ typedef struct _hgVertexBuffer
 typedef struct _hgIndexBuffer
 {
     VkBuffer       tBuffer;
-    VkDeviceMemory tMemory;
+    hgAllocation   tAllocation;
     size_t         szSize;
     uint32_t       uIndexCount;
+    VkIndexType    tIndexType;  // UINT16 or UINT32, used by every bind of the buffer
 } hgIndexBuffer;
 
+// draw arguments the gpu reads at draw time -> written by an upload or by a compute shader (storage buffer usage)
+typedef struct _hgIndirectBuffer
+{
+    VkBuffer       tBuffer;
+    hgAllocation   tAllocation;
+    uint32_t       uMaxDraws;     // VkDrawIndexedIndirectCommand slots at offset 0
+    VkDeviceSize   tCountOffset;  // uint32_t draw count right after the commands (see hg_cmd_draw_indexed_indirect_count)
+} hgIndirectBuffer;
+
+// returned by hg_register_mesh -> 0 never refers to a mesh
+typedef uint32_t hgMeshHandle;
+
+// where a mesh lives inside its geometry pool, these go straight into an indexed draw or a VkDrawIndexedIndirectCommand
+typedef struct _hgMesh
+{
+    uint32_t uFirstIndex;
+    uint32_t uIndexCount;
+    int32_t  iVertexOffset; // first vertex of the mesh, added to every index -> indices stay mesh relative
+    uint32_t uVertexCount;  // 0 -> unused slot
+} hgMesh;
+
+// ranges of an unregistered mesh, reused once the frame it was retired in has finished
+typedef struct _hgRetiredMesh
+{
+    hgMesh   tMesh;
+    uint64_t uRetireFrame;
+} hgRetiredMesh;
+
+// buffer pair replaced by hg_compact_geometry_pool, destroyed once the frames still reading it have finished
+typedef struct _hgRetiredBuffers
+{
+    VkBuffer     tVertexBuffer;
+    hgAllocation tVertexAllocation;
+    VkBuffer     tIndexBuffer;
+    hgAllocation tIndexAllocation;
+    uint64_t     uRetireFrame;
+} hgRetiredBuffers;
+
+// one device local vertex buffer + index buffer shared by many meshes -> bound once, every mesh is a range of it
+typedef struct _hgGeometryPool
+{
+    VkBuffer          tVertexBuffer;
+    hgAllocation      tVertexAllocation;
+    VkBuffer          tIndexBuffer;
+    hgAllocation      tIndexAllocation;
+    uint32_t          uVertexStride;
+    uint32_t          uVertexCapacity;
+    uint32_t          uIndexCapacity;
+    VkIndexType       tIndexType;      // 16 bit unless a mesh index can reach 0xffff (see hg_create_geometry_pool)
+    hgRangeList       tFreeVertices;   // in vertices
+    hgRangeList       tFreeIndices;    // in indices
+    hgMesh*           atMeshes;        // slot of handle h is h - 1
+    uint32_t          uMeshCount;      // slots handed out so far (unused ones are recycled)
+    uint32_t          uMeshCapacity;
+    hgRetiredMesh*    atRetired;
+    uint32_t          uRetiredCount;
+    uint32_t          uRetiredCapacity;
+    hgRetiredBuffers* atRetiredBuffers; // old pairs of compactions still in flight
+    uint32_t          uRetiredBufferCount;
+    uint32_t          uRetiredBufferCapacity;
+} hgGeometryPool;
+
 typedef struct _hgPipeline
 {
     VkPipeline             tPipeline;
     VkPipelineLayout       tPipelineLayout;
     VkPipelineBindPoint    tPipelineBindPoint; // will always be VK_PIPELINE_BIND_POINT_GRAPHICS right now but leaving the door open to compute, raytracing, etc..
+    VkShaderStageFlags     tPushConstantStages; // union of all push constant range stages
+    uint32_t               uPushConstantSize;   // end of the furthest push constant range
 } hgPipeline;
 
+// see hg_make_sort_key -> queued draws are recorded in ascending key order
+typedef uint64_t hgSortKey;
+
+// everything one queued draw needs, recorded through the bound state tracker so state shared with the previous packet is free
+typedef struct _hgDrawPacket
+{
+    hgPipeline*        ptPipeline;
+    VkDescriptorSet    atSets[HG_MAX_PACKET_SETS]; // bound from set 0
+    uint32_t           uSetCount;
+    uint32_t           auDynamicOffsets[HG_MAX_PACKET_SETS];
+    uint32_t           uDynamicOffsetCount; // at most HG_MAX_PACKET_SETS (asserted by hg_queue_draw)
+
+    // geometry -> filled by hg_set_packet_mesh/hg_set_packet_pool_mesh
+    VkBuffer           tVertexBuffer;     // binding 0, VK_NULL_HANDLE -> nothing bound (vertices made up in the shader)
+    VkDeviceSize       tVertexOffset;
+    VkBuffer           tIndexBuffer;      // VK_NULL_HANDLE -> non indexed draw
+    VkIndexType        tIndexType;
+    uint32_t           uCount;            // indices (vertices for non indexed draws)
+    uint32_t           uFirst;            // first index (first vertex)
+    int32_t            iVertexOffset;
+    VkBuffer           tInstanceBuffer;   // optional per instance stream
+    VkDeviceSize       tInstanceOffset;
+    uint32_t           uInstanceBinding;
+    uint32_t           uInstanceCount;    // 0 -> 1
+    uint32_t           uFirstInstance;
+
+    VkShaderStageFlags tPushStages;
+    uint32_t           uPushSize;         // bytes of auPushData pushed at offset 0, 0 -> no push
+    uint8_t            auPushData[HG_MAX_PACKET_PUSH_BYTES];
+} hgDrawPacket;
+
+// what the sort moves around -> packets stay where they were queued
+typedef struct _hgRenderQueueEntry
+{
+    hgSortKey uKey;
+    uint32_t  uPacket;
+} hgRenderQueueEntry;
+
+// draws collected during a frame, sorted and recorded by hg_cmd_submit_render_queue (storage is kept across frames)
+typedef struct _hgRenderQueue
+{
+    hgDrawPacket*       atPackets;
+    hgRenderQueueEntry* atEntries;
+    hgRenderQueueEntry* atScratch;  // radix sort ping-pong
+    uint32_t            uCount;
+    uint32_t            uCapacity;
+} hgRenderQueue;
+
 // =============================================================================
 // CONFIGURATION STRUCTS
 // =============================================================================
@@ -108,7 +380,9 @@ typedef struct _hgPipelineConfig
     // vertex input
     VkVertexInputAttributeDescription* ptAttributeDescriptions;
     uint32_t                           uAttributeCount;
-    uint32_t                           uVertexStride;
+    uint32_t                           uVertexStride;         // single per vertex binding 0, ignored when ptBindingDescriptions is set
+    VkVertexInputBindingDescription*   ptBindingDescriptions; // several streams, each with its own stride and input rate (per instance included)
+    uint32_t                           uBindingCount;
 
     // rasterization state
     VkCullModeFlags     tCullMode;   // VK_CULL_MODE_NONE, _BACK_BIT, _FRONT_BIT
@@ -123,7 +397,7 @@ typedef struct _hgPipelineConfig
     // blend -> for future use 
     VkBool32 bBlendEnable;
 
-    // push constants -> for future use 
+    // push constants -> small per draw data (model matrix, material index) written with hg_cmd_push_constants
     VkPushConstantRange* ptPushConstantRanges;
     uint32_t             uPushConstantRangeCount;
 } hgPipelineConfig;
@@ -135,23 +409,229 @@ typedef struct _hgPipelineConfig
 // core Vulkan context (application lifetime)
 typedef struct _hgVulkanContext
 {
-    VkInstance       tInstance;
-    VkPhysicalDevice tPhysicalDevice;
-    VkDevice         tDevice;
-    VkQueue          tGraphicsQueue;
-    uint32_t         tGraphicsQueueFamily;
+    VkInstance                 tInstance;
+    VkPhysicalDevice           tPhysicalDevice;
+    VkPhysicalDeviceProperties tDeviceProperties; // limits are needed all over the place so grab them once
+    VkDevice                   tDevice;
+    VkQueue                    tGraphicsQueue;
+    uint32_t                   tGraphicsQueueFamily;
+    VkQueue                    tTransferQueue;       // transfer-only family if the device has one, otherwise the graphics queue
+    uint32_t                   tTransferQueueFamily;
+    VkPipelineCache            tPipelineCache;       // every pipeline is created through this, persisted to disk at cleanup
+    VkPhysicalDeviceFeatures   tEnabledFeatures;     // optional features turned on at device creation (multiDrawIndirect, drawIndirectFirstInstance, fullDrawIndexUint32)
+    PFN_vkCmdDrawIndexedIndirectCountKHR pfnCmdDrawIndexedIndirectCount; // VK_KHR_draw_indirect_count, NULL -> not supported
 } hgVulkanContext;
 
+// one vkAllocateMemory, carved up between many resources
+typedef struct _hgMemoryBlock
+{
+    VkDeviceMemory tMemory;
+    VkDeviceSize   tSize;
+    VkDeviceSize   tUsed;
+    uint32_t       uMemoryTypeIndex;
+    bool           bLinear;     // buffers vs optimal tiled images -> kept apart when bufferImageGranularity > 1
+    bool           bDedicated;  // sized for one allocation that didn't fit a regular block
+    void*          pMapped;     // whole block mapped once if host visible
+    uint32_t       uAllocationCount;
+
+    hgRangeList    tFreeRanges;
+} hgMemoryBlock;
+
+// device memory allocator (application lifetime)
+typedef struct _hgMemoryAllocator
+{
+    VkPhysicalDeviceMemoryProperties tMemProperties;
+    VkDeviceSize                     tBufferImageGranularity;
+    VkDeviceSize                     tBlockSize;
+    hgMemoryBlock**                  aptBlocks;
+    uint32_t                         uBlockCount;
+    uint32_t                         uBlockCapacity;
+} hgMemoryAllocator;
+
+// piece of staging memory an upload writes into before it gets copied on the gpu
+typedef struct _hgStagingSlice
+{
+    VkBuffer     tBuffer;
+    VkDeviceSize tOffset;
+    void*        pData;
+    bool         bTemporary;  // upload was bigger than the ring -> one off buffer that gets destroyed after the copy
+    hgAllocation tAllocation; // only used by temporary slices
+} hgStagingSlice;
+
+// persistently mapped ring buffer all uploads are staged through (application lifetime)
+typedef struct _hgStagingRing
+{
+    VkBuffer     tBuffer;
+    hgAllocation tAllocation;
+    VkDeviceSize tSize;
+    VkDeviceSize tAlignment;
+
+    // these only ever grow, offset into the buffer is (value % tSize)
+    uint64_t     uHead;      // next byte to be written
+    uint64_t     uSubmitted; // everything before this has been handed to the gpu
+    uint64_t     uTail;      // oldest byte the gpu might still be reading
+} hgStagingRing;
+
+// one recorded and submitted upload command buffer
+typedef struct _hgUploadSubmission
+{
+    VkCommandBuffer tCommandBuffer;        // recorded on the transfer queue
+    VkCommandBuffer tAcquireCommandBuffer; // graphics queue side of the ownership transfer (separate transfer family only)
+    VkSemaphore     tTransferDone;         // transfer submit -> acquire submit
+    VkFence         tFence;                // signaled by the last submit of the two
+    hgUploadTicket  uTicket;
+    uint64_t        uStagingEnd;       // staging ring space up to here is free once the fence signals
+    hgStagingSlice* atTemporaries;     // oversized staging buffers to destroy once the fence signals
+    uint32_t        uTemporaryCount;
+    uint32_t        uTemporaryCapacity;
+
+    // acquire half of the queue family ownership transfers (transfer -> graphics), recorded at submit
+    VkBufferMemoryBarrier* atBufferAcquires;
+    uint32_t               uBufferAcquireCount;
+    uint32_t               uBufferAcquireCapacity;
+    VkImageMemoryBarrier*  atImageAcquires;
+    uint32_t               uImageAcquireCount;
+    uint32_t               uImageAcquireCapacity;
+} hgUploadSubmission;
+
+// batches copies into as few submits as possible (see hg_begin_upload_batch)
+typedef struct _hgUploadContext
+{
+    hgUploadSubmission  atSubmissions[HG_MAX_UPLOAD_SUBMISSIONS]; // in flight ones are oldest first (circular)
+    uint32_t            uFirstSubmission;
+    uint32_t            uSubmissionCount;
+    hgUploadSubmission* ptRecording;      // slot being recorded into -> NULL if nothing is recorded yet
+    bool                bBatchOpen;
+    hgUploadTicket      uLastTicket;      // last submitted
+    hgUploadTicket      uCompletedTicket; // everything up to here has finished on the gpu
+} hgUploadContext;
+
+// one loaded spir-v file -> the module outlives the pipelines built from it
+typedef struct _hgShaderModuleEntry
+{
+    char           acPath[256];   // path the file was found at (after the ../out/shaders fallback)
+    uint64_t       uContentHash;  // FNV-1a of the spir-v words
+    int64_t        iModifiedTime; // file timestamp when the module was created
+    uint64_t       uFileSize;
+    VkShaderModule tModule;
+} hgShaderModuleEntry;
+
+// shader modules keyed by path + content hash, re-validated against the file timestamp on every lookup
+typedef struct _hgShaderCache
+{
+    hgShaderModuleEntry* atEntries;
+    uint32_t             uEntryCount;
+    uint32_t             uEntryCapacity;
+    VkShaderModule*      atStale;        // replaced by a newer file, another pipeline build may still be reading them
+    uint32_t             uStaleCount;
+    uint32_t             uStaleCapacity;
+} hgShaderCache;
+
+// one persistently mapped buffer split into a region per frame in flight, allocation is a pointer bump
+typedef struct _hgTransientAllocator
+{
+    VkBuffer     tBuffer;
+    hgAllocation tAllocation;
+    VkDeviceSize tFrameSize;   // size of each region
+    VkDeviceSize tAlignment;   // minUniformBufferOffsetAlignment (at least 16)
+    VkDeviceSize tHead;        // next free byte inside the active region
+    VkDeviceSize tPeakUsage;   // biggest amount a single frame has used so far
+    uint32_t     uActiveFrame; // region currently handed out from
+    bool         bActive;      // false between hg_end_frame and the next allocation/hg_begin_frame
+} hgTransientAllocator;
+
+// swapchain objects replaced by a recreation, destroyed once the last frame that used them has finished
+typedef struct _hgRetiredSwapchain
+{
+    VkSwapchainKHR tSwapchain;
+    VkImageView*   tImageViews;
+    VkFramebuffer* tFramebuffers;
+    VkSemaphore*   tRenderFinished;
+    VkImage*       tOffscreenImages;      // headless only (swapchain images are owned by the swapchain)
+    hgAllocation*  tOffscreenAllocations;
+    uint32_t       uImageCount;
+    VkImage        tDepthImage;
+    VkImageView    tDepthImageView;
+    hgAllocation   tDepthAllocation;
+    uint64_t       uRetireFrame;    // last frame submitted while these were current
+} hgRetiredSwapchain;
+
+// host visible copy of one frame's color image, handed to the callback once that frame's fence signaled
+typedef struct _hgReadbackSlot
+{
+    VkBuffer           tBuffer;
+    hgAllocation       tAllocation;
+    VkDeviceSize       tCapacity;  // buffer is kept and only grown when the extent gets bigger
+    uint32_t           uWidth;
+    uint32_t           uHeight;
+    VkFormat           tFormat;
+    uint64_t           uFrame;     // frame the copy was submitted with, 0 -> requested but not recorded yet
+    bool               bInUse;
+    hgReadbackCallback pfCallback;
+    void*              pUserData;
+} hgReadbackSlot;
+
+// readback ring -> copies are recorded at the end of the frame and delivered frames later, nothing ever waits on the gpu
+typedef struct _hgReadbackRing
+{
+    hgReadbackSlot       atSlots[HG_READBACK_RING_SIZE];
+    struct _hgPngWriter* ptPngWriter; // background png encoders, created on the first hg_capture_png
+} hgReadbackRing;
+
+// one scope recorded into a frame command buffer, its timestamps are queries 2 * index and 2 * index + 1 of the frame's range
+typedef struct _hgGpuScope
+{
+    const char* pcName;
+    uint32_t    uDepth;
+    int32_t     iParent;
+    bool        bClosed;
+} hgGpuScope;
+
+// running average/max of every scope name seen so far
+typedef struct _hgGpuScopeStats
+{
+    const char* pcName;
+    float       fAverageMs;
+    float       fMaxMs;
+    uint64_t    uSampleCount;
+} hgGpuScopeStats;
+
+// timestamp queries -> one range of the pool per frame in flight, read back without waiting once that frame's fence signaled
+typedef struct _hgGpuProfiler
+{
+    VkQueryPool       tQueryPool;       // HG_MAX_FRAMES_IN_FLIGHT * HG_MAX_GPU_SCOPES * 2 timestamps, NULL -> profiling off/unsupported
+    VkQueryPool       tUploadQueryPool; // two timestamps per upload submission slot
+    float             fPeriodNs;        // timestampPeriod
+    uint64_t          uTimestampMask;   // timestampValidBits of the graphics family
+    hgGpuScope        aatScopes[HG_MAX_FRAMES_IN_FLIGHT][HG_MAX_GPU_SCOPES];
+    uint32_t          auScopeCount[HG_MAX_FRAMES_IN_FLIGHT];
+    uint64_t          auFrame[HG_MAX_FRAMES_IN_FLIGHT]; // frame recorded into each range, 0 -> nothing to read back
+    int32_t           aiOpenStack[HG_MAX_GPU_SCOPE_DEPTH]; // open scopes of the frame being recorded (-1 -> not timed)
+    uint32_t          uOpenCount;
+    hgGpuScopeStats   atStats[HG_MAX_GPU_SCOPES];
+    uint32_t          uStatCount;
+    hgGpuFrameProfile tLastFrame;
+} hgGpuProfiler;
+
 // swapchain (recreated on resize)
 typedef struct _hgSwapchain
 {
-    VkSurfaceKHR   tSurface;
-    VkSwapchainKHR tSwapchain;
-    VkFormat       tFormat;
-    VkExtent2D     tExtent;
-    VkImage*       tSwapchainImages;
-    VkImageView*   tSwapchainImageViews;
-    uint32_t       uSwapchainImageCount;
+    VkSurfaceKHR     tSurface;
+    VkSwapchainKHR   tSwapchain;
+    VkFormat         tFormat;
+    VkExtent2D       tExtent;
+    VkImageUsageFlags tImageUsage;         // TRANSFER_SRC is only added when the surface supports it (needed for readbacks)
+    VkImage*         tSwapchainImages;
+    VkImageView*     tSwapchainImageViews;
+    uint32_t         uSwapchainImageCount;
+    hgAllocation*    tOffscreenAllocations; // headless only -> the images above are ours and live in this memory
+    VkPresentModeKHR tPresentMode;         // mode passed to hg_create_swapchain, reused on recreation
+    VkPresentModeKHR tActivePresentMode;   // what the surface actually supports (FIFO fallback)
+    uint32_t         uRequestedImageCount; // hgAppData::uSwapchainImageCount at creation, 0 -> picked per present mode
+    bool             bNeedsRecreate;       // suboptimal/out of date seen, recreated at the next frame boundary
+
+    hgRetiredSwapchain atRetired[HG_MAX_RETIRED_SWAPCHAINS];
+    uint32_t           uRetiredCount;
 } hgSwapchain;
 
 // render pipeline (tied to swapchain)
@@ -162,7 +642,7 @@ typedef struct _hgRenderPipeline
 
     // depth attachments 
     VkImage        tDepthImage;
-    VkDeviceMemory tDepthMemory;
+    hgAllocation   tDepthAllocation;
     VkImageView    tDepthImageView;
     VkFormat       tDepthFormat;  // store the format we choose
 
@@ -170,22 +650,72 @@ typedef struct _hgRenderPipeline
     float          afStencilClear[2];
 } hgRenderPipeline;
 
+// descriptor set slot as last bound -> dynamic offsets belong to the whole call, so the call range is kept with them
+typedef struct _hgBoundDescriptorSet
+{
+    VkDescriptorSet tSet;
+    uint32_t        uFirstSet;  // range of the call that bound it
+    uint32_t        uSetCount;
+    uint32_t        uDynamicOffsetCount;
+    uint32_t        auDynamicOffsets[HG_MAX_DYNAMIC_OFFSETS];
+} hgBoundDescriptorSet;
+
+// what the hg_cmd_bind_* functions last recorded into one frame command buffer, reset when the command buffer begins
+typedef struct _hgBoundState
+{
+    VkPipeline           tPipeline;
+    VkPipelineLayout     tLayout;       // sets and push constants below were recorded against this layout
+    VkBuffer             atVertexBuffers[HG_MAX_VERTEX_BINDINGS];
+    VkDeviceSize         atVertexOffsets[HG_MAX_VERTEX_BINDINGS];
+    VkBuffer             tIndexBuffer;
+    VkDeviceSize         tIndexOffset;
+    VkIndexType          tIndexType;
+    hgBoundDescriptorSet atSets[HG_MAX_BOUND_DESCRIPTOR_SETS];
+    uint8_t              auPushBytes[HG_MAX_TRACKED_PUSH_BYTES];
+    VkShaderStageFlags   atPushStages[HG_MAX_TRACKED_PUSH_BYTES / 4]; // stages each word was pushed with, 0 -> unknown
+    hgBindStats          tStats;
+} hgBoundState;
+
 // command recording tools
 typedef struct _hgCommandResources
 {
-    VkCommandPool    tCommandPool;
-    VkCommandBuffer* tCommandBuffers;  // one per swapchain image
-    uint32_t         uCurrentImageIndex;
+    VkCommandPool   tCommandPool;
+    VkCommandPool   tTransferCommandPool; // upload command buffers (transfer queue family)
+    VkCommandBuffer tCommandBuffers[HG_MAX_FRAMES_IN_FLIGHT]; // one per frame in flight
+    uint32_t        uCurrentImageIndex;   // swapchain image, not the frame -> see hgFrameSync::uCurrentFrame
+    hgBoundState    atBoundState[HG_MAX_FRAMES_IN_FLIGHT];    // redundant bind filtering, one per frame command buffer
+    hgBindStats     tLastBindStats;       // tracker counters of the last frame passed to hg_end_frame
+    bool            bRecording;           // between hg_begin_frame and hg_end_frame
+    bool            bInRenderPass;        // between hg_begin_render_pass and hg_end_render_pass
 } hgCommandResources;
 
 // synch objects
 typedef struct _hgFrameSync
 {
-    VkSemaphore tImageAvailable;
-    VkSemaphore tRenderFinished;
-    VkFence     tInFlight;
+    // per frame in flight
+    VkSemaphore  tImageAvailable[HG_MAX_FRAMES_IN_FLIGHT];
+    VkFence      tInFlight[HG_MAX_FRAMES_IN_FLIGHT];
+    uint64_t     auSubmittedFrame[HG_MAX_FRAMES_IN_FLIGHT]; // frame number last submitted with each fence
+    uint32_t     uCurrentFrame;
+    uint64_t     uFrameCount;                               // frames submitted so far
+
+    // per swapchain image -> presentation may still wait on the semaphore after the frame fence signaled
+    VkSemaphore* tRenderFinished;
+    VkFence*     tImagesInFlight;  // frame fence of the last frame that rendered to each image (not owned)
+    uint32_t     uImageCount;
 } hgFrameSync;
 
+// frame pacing + latency measurement
+typedef struct _hgFramePacing
+{
+    uint64_t       uLastFrameStartNs;                       // fps cap deadline is measured from here
+    void*          pSleepTimer;                             // windows high resolution waitable timer, created by the first capped frame
+    bool           bTimerPeriodRaised;                      // windows without that timer -> timeBeginPeriod(1) instead
+    uint64_t       auFrameStartNs[HG_MAX_FRAMES_IN_FLIGHT]; // cpu start of the frame last submitted on each slot
+    bool           abLatencyPending[HG_MAX_FRAMES_IN_FLIGHT];
+    hgFrameLatency tLatency;
+} hgFramePacing;
+
 // main application state
 typedef struct _hgAppData
 {
@@ -195,14 +725,33 @@ typedef struct _hgAppData
     int         height;
 
     // vulkan subsystems
-    hgVulkanContext    tContextComponents;
-    hgSwapchain        tSwapchainComponents;
-    hgRenderPipeline   tPipelineComponents;
-    hgCommandResources tCommandComponents;
-    hgFrameSync        tSyncComponents;
+    hgVulkanContext      tContextComponents;
+    hgMemoryAllocator    tMemoryComponents;
+    hgStagingRing        tStagingComponents;
+    hgUploadContext      tUploadComponents;
+    hgTransientAllocator tTransientComponents;
+    hgShaderCache        tShaderComponents;
+    hgSwapchain          tSwapchainComponents;
+    hgRenderPipeline     tPipelineComponents;
+    hgCommandResources   tCommandComponents;
+    hgFrameSync          tSyncComponents;
+    hgFramePacing        tPacingComponents;
+    hgReadbackRing       tReadbackComponents;
+    hgGpuProfiler        tProfilerComponents;
 
     // settings
-    bool bDepthEnabled; // should be set on intialization 
+    bool         bDepthEnabled;        // should be set on intialization
+    bool         bHeadless;            // no window/surface/present, frames render into offscreen images of width x height (set before hg_create_instance)
+    bool         bGpuProfiling;        // timestamp queries around every frame, render pass and upload batch (set before hg_create_logical_device)
+    uint32_t     uFramesInFlight;      // frames the cpu may record ahead of the gpu (1..HG_MAX_FRAMES_IN_FLIGHT), 0 -> HG_DEFAULT_FRAMES_IN_FLIGHT
+    size_t       szStagingRingSize;    // staging memory shared by all uploads, 0 -> HG_DEFAULT_STAGING_RING_SIZE
+    size_t       szTransientFrameSize; // per frame transient memory (hg_alloc_transient), 0 -> HG_DEFAULT_TRANSIENT_SIZE
+    const char*  pcPipelineCachePath;  // loaded at device creation and written back at cleanup, NULL -> HG_DEFAULT_PIPELINE_CACHE
+    uint32_t     uPipelineWorkerCount; // threads used by hg_create_graphics_pipelines, 0 -> one per core (up to HG_MAX_PIPELINE_WORKERS)
+    uint32_t     uSwapchainImageCount; // requested swapchain images (clamped to the surface), 0 -> minImageCount + 1 (3 for mailbox)
+    hgPacingMode tPacingMode;          // HG_PACING_THROUGHPUT by default
+    float        fTargetFps;           // only used by HG_PACING_FPS_CAP
+    bool         bPrecisePacing;       // HG_PACING_FPS_CAP spins the last HG_PACING_SPIN_NS before each deadline -> exact frame times, but burns a core
 } hgAppData;
 
 // =============================================================================
@@ -226,7 +775,7 @@ void hg_allocate_frame_cmd_buffers(hgAppData* ptState);
 void hg_create_swapchain(hgAppData* ptState, VkPresentModeKHR preferredPresentMode);
 void hg_create_render_pass(hgAppData* ptState, hgRenderPassConfig* config);
 void hg_create_framebuffers(hgAppData* ptState);
-void hg_recreate_swapchain(hgAppData* ptState);
+void hg_recreate_swapchain(hgAppData* ptState); // no device idle, old objects are retired -> called by hg_begin_frame/hg_end_frame on out of date/suboptimal
 void hg_create_depth_resources(hgAppData* ptState);
 
 // =============================================================================
@@ -237,6 +786,17 @@ void hg_create_depth_resources(hgAppData* ptState);
 hgVertexBuffer hg_create_static_vertex_buffer(hgAppData* ptState, void* data, size_t size, size_t stride);
 hgVertexBuffer hg_create_dynamic_vertex_buffer(hgAppData* ptState, void* data, size_t size, size_t stride);
 hgIndexBuffer  hg_create_index_buffer(hgAppData* ptState, uint16_t* indices, uint32_t count);
+hgIndexBuffer  hg_create_index_buffer_32(hgAppData* ptState, const uint32_t* indices, uint32_t count);
+// stored as 16 bit when the largest index allows it (half the memory and index fetch), as 32 bit otherwise -> check tIndexType
+
+// uploads -> static buffers and textures created while a batch is open only record their copies and return right away,
+// they can be drawn with once the batch is submitted (source data is copied immediately and can be freed)
+void           hg_begin_upload_batch(hgAppData* ptState);
+void           hg_enqueue_buffer_upload(hgAppData* ptState, VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+void           hg_enqueue_image_upload(hgAppData* ptState, VkImage image, const void* data, uint32_t width, uint32_t height); // RGBA8, ends in shader read layout
+hgUploadTicket hg_submit_upload_batch(hgAppData* ptState);
+bool           hg_is_upload_complete(hgAppData* ptState, hgUploadTicket ticket);
+void           hg_wait_for_upload(hgAppData* ptState, hgUploadTicket ticket);
 
 // textures
 unsigned char* hg_load_texture_data(const char* filename, int* widthOut, int* heightOut);
@@ -244,6 +804,8 @@ hgTexture      hg_create_texture(hgAppData* ptState, const unsigned char* data,
 
 // pipelines
 hgPipeline hg_create_graphics_pipeline(hgAppData* ptState, hgPipelineConfig* config);
+void       hg_create_graphics_pipelines(hgAppData* ptState, hgPipelineConfig* configs, uint32_t count, hgPipeline* pipelinesOut);
+// batch version -> pipelines are compiled in parallel across a worker pool (results in config order)
 
 // descriptors 
 VkDescriptorPool hg_create_descriptor_pool(hgAppData* ptState, uint32_t uMaxSets, VkDescriptorPoolSize* atPoolSizes, uint32_t uPoolSizeCount);
@@ -254,6 +816,49 @@ hgUniformBuffer hg_create_uniform_buffer(hgAppData* ptState, size_t size);
 void            hg_update_uniform_buffer(hgAppData* ptState, hgUniformBuffer* buffer, void* data, size_t size);
 void            hg_destroy_uniform_buffer(hgAppData* ptState, hgUniformBuffer* buffer);
 
+// dynamic uniform buffers -> one buffer holds an aligned slot per object (and per frame in flight), every object
+// shares one VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptor and picks its slot with a dynamic offset at bind time
+hgUniformBuffer hg_create_dynamic_uniform_buffer(hgAppData* ptState, size_t slotSize, uint32_t slotCount);
+void            hg_update_uniform_slot(hgAppData* ptState, hgUniformBuffer* buffer, uint32_t slot, const void* data, size_t size);
+uint32_t        hg_get_uniform_dynamic_offset(hgAppData* ptState, hgUniformBuffer* buffer, uint32_t slot);
+void            hg_update_uniform_descriptor(hgAppData* ptState, VkDescriptorSet tDescriptorSet, uint32_t uBinding, hgUniformBuffer* buffer);
+
+// transient per frame memory -> uniforms/vertices/indices rewritten every frame, no buffer per object needed
+hgTransientAllocation hg_alloc_transient(hgAppData* ptState, size_t size);
+
+// instance streams -> model matrices (16 floats each) and colors (4 floats each, NULL -> white) interleaved into hgInstanceData,
+// bind the result to a per instance binding and draw every instance with one hg_cmd_draw_indexed_instanced
+hgTransientAllocation hg_alloc_instance_stream(hgAppData* ptState, const float* models, const float* colors, uint32_t count);  // this frame only
+hgVertexBuffer        hg_create_instance_buffer(hgAppData* ptState, const float* models, const float* colors, uint32_t count); // static
+uint32_t              hg_get_instance_attributes(uint32_t binding, uint32_t firstLocation, VkVertexInputAttributeDescription* attributesOut);
+// fills HG_INSTANCE_ATTRIBUTE_COUNT attributes (model at firstLocation..+3, color after it), returns the count
+
+// indirect draws -> arrays of VkDrawIndexedIndirectCommand, thousands of draws go out with one call
+hgIndirectBuffer      hg_create_indirect_buffer(hgAppData* ptState, const VkDrawIndexedIndirectCommand* commands, uint32_t count); // NULL commands -> filled on the gpu, starts zeroed (count too)
+void                  hg_cmd_reset_indirect_buffer(hgAppData* ptState, hgIndirectBuffer* indirectBuffer); // zero commands + count before the gpu refills them (outside a render pass)
+hgTransientAllocation hg_alloc_indirect_commands(hgAppData* ptState, uint32_t count); // this frame only, the cpu fills pData in bulk
+bool                  hg_supports_multi_draw_indirect(hgAppData* ptState);            // false -> indirect draws are split into one call per command
+bool                  hg_supports_draw_indirect_count(hgAppData* ptState);            // false -> the count buffer is ignored and the max count is drawn
+
+// geometry pools -> meshes are sub-ranges of one big vertex/index buffer pair, so switching meshes needs no rebinding
+// and a whole scene can go out as one indirect draw. indices are relative to the mesh's first vertex, so maxVertices
+// bounds every index -> the pool stores 16 bit indices when maxVertices <= 0xffff, 32 bit otherwise
+hgGeometryPool hg_create_geometry_pool(hgAppData* ptState, uint32_t vertexStride, uint32_t maxVertices, uint32_t maxIndices);
+hgMeshHandle   hg_register_mesh(hgAppData* ptState, hgGeometryPool* pool, const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+// uploads like the static buffers (batched when a batch is open), indices are narrowed to the pool's index type.
+// 0 -> no free range big enough (see hg_compact_geometry_pool)
+void           hg_unregister_mesh(hgAppData* ptState, hgGeometryPool* pool, hgMeshHandle mesh); // ranges are reused once the gpu is done with them
+const hgMesh*  hg_get_mesh(hgGeometryPool* pool, hgMeshHandle mesh);
+bool           hg_compact_geometry_pool(hgAppData* ptState, hgGeometryPool* pool);
+// moves every mesh to the front so the free space is one range again, false -> already packed. the copies are recorded
+// into the frame command buffer -> call after hg_begin_frame, before hg_begin_render_pass. handles stay valid, their
+// hgMesh ranges change. copies into a second buffer pair -> pool memory doubles until that frame has finished on the gpu
+// (the old pair is freed by a later register/compact, or by hg_destroy_geometry_pool)
+
+// memory -> every buffer/image above is sub-allocated from large per memory type blocks
+void hg_get_allocator_stats(hgAppData* ptState, hgAllocatorStats* ptStatsOut);
+void hg_print_allocator_stats(hgAppData* ptState);
+
 // =============================================================================
 // FRAME RENDERING
 // =============================================================================
@@ -262,21 +867,72 @@ void            hg_destroy_uniform_buffer(hgAppData* ptState, hgUniformBuffer* b
 uint32_t hg_begin_frame(hgAppData* ptState);
 void     hg_end_frame(hgAppData* ptState, uint32_t uImageIndex);
 
+// frame in flight access -> anything the cpu rewrites every frame (uniforms, dynamic vertices) needs one copy per
+// frame in flight, index those with hg_get_current_frame_index() (not with the swapchain image index)
+uint32_t        hg_get_frames_in_flight(hgAppData* ptState);
+uint32_t        hg_get_current_frame_index(hgAppData* ptState);
+VkCommandBuffer hg_get_current_frame_cmd_buffer(hgAppData* ptState);
+
+// pacing -> policy lives in hgAppData::tPacingMode/fTargetFps, can be changed between frames
+void hg_get_frame_latency(hgAppData* ptState, hgFrameLatency* latencyOut);
+
+// readback -> call between hg_begin_frame and hg_end_frame (after the render pass), the color image is copied at hg_end_frame
+// and the callback runs inside a later hg_begin_frame once the gpu finished that frame. false -> all HG_READBACK_RING_SIZE slots busy
+bool hg_request_readback(hgAppData* ptState, hgReadbackCallback callback, void* userData);
+bool hg_capture_png(hgAppData* ptState, const char* path); // readback + png encode on a background thread, never blocks a frame.
+                                                           // false -> readback ring or all HG_MAX_PNG_WRITERS busy, try again later
+void hg_flush_readbacks(hgAppData* ptState);               // waits for pending readbacks and png writes (done by cleanup as well)
+
+// gpu profiling (hgAppData::bGpuProfiling) -> frames, render passes and upload batches are timed automatically,
+// add nested scopes of your own between hg_begin_frame and hg_end_frame. names are kept by pointer (use string literals)
+void hg_cmd_begin_gpu_scope(hgAppData* ptState, const char* name);
+void hg_cmd_end_gpu_scope(hgAppData* ptState);
+bool hg_get_gpu_frame_profile(hgAppData* ptState, hgGpuFrameProfile* profileOut); // false -> profiling off or no frame finished yet
+void hg_print_gpu_frame_profile(hgAppData* ptState);
+
+// cpu tracing (-DHG_ENABLE_TRACE) -> every thread records into its own buffer without locking, use the HG_TRACE_* macros
+// so the calls disappear in normal builds. the dump is a chrome://tracing / ui.perfetto.dev json, take it while the
+// other threads are idle (e.g. after the frame loop)
+void hg_trace_begin(const char* name); // name is kept by pointer (string literal or __func__)
+void hg_trace_end(void);
+bool hg_trace_dump(const char* path);  // false -> tracing compiled out or the file can't be written. writes the last
+                                       // HG_TRACE_EVENTS_PER_THREAD scopes of every thread
+
 
 // Render pass
 void hg_begin_render_pass(hgAppData* ptState, uint32_t uImageIndex);
+// also sets viewport + scissor to the full swapchain extent
 void hg_end_render_pass(hgAppData* ptState);
 
+// dynamic state (all pipelines use dynamic viewport/scissor so they survive swapchain recreation)
+void hg_cmd_set_viewport(hgAppData* ptState, float fX, float fY, float fWidth, float fHeight);
+void hg_cmd_set_scissor(hgAppData* ptState, int32_t iX, int32_t iY, uint32_t uWidth, uint32_t uHeight);
+
 
 // bind state (must be called between begin/end render pass)
-// may not do these functions as it doesnt really make sense to stash away the vulkan code on these
+// every frame command buffer remembers what these bound last and drops calls that would bind the same thing again,
+// so they are cheap to call per draw. raw vkCmdBind*/vkCmdPushConstants go around the tracker -> call
+// hg_cmd_invalidate_bound_state after recording those
 void hg_cmd_bind_pipeline(hgAppData* ptState, hgPipeline* tPipeline);
 void hg_cmd_bind_vertex_buffer(hgAppData* ptState, hgVertexBuffer* tVertexBuffer);
 // bind vertex buffer for subsequent draw calls
+void hg_cmd_bind_transient_vertex_buffer(hgAppData* ptState, hgTransientAllocation* tVertices);
+// bind vertices written into hg_alloc_transient memory this frame
+void hg_cmd_bind_vertex_stream(hgAppData* ptState, uint32_t uBinding, VkBuffer tBuffer, VkDeviceSize tOffset);
+// bind any buffer to one of the pipeline's vertex bindings (the two above use binding 0)
 void hg_cmd_bind_index_buffer(hgAppData* ptState, hgIndexBuffer* tIndexBuffer);
 // bind index buffer for subsequent indexed draw calls
-void hg_cmd_bind_descriptor_sets(hgAppData* ptState, hgPipeline* tPipeline, VkDescriptorSet* tDescriptorSets, uint32_t uSetCount);
-// bind descriptor sets (textures, uniforms) for shaders
+void hg_cmd_bind_descriptor_sets(hgAppData* ptState, hgPipeline* tPipeline, uint32_t uFirstSet, VkDescriptorSet* tDescriptorSets, uint32_t uSetCount,
+                                 const uint32_t* auDynamicOffsets, uint32_t uDynamicOffsetCount);
+// bind descriptor sets (textures, uniforms) for shaders starting at set index uFirstSet, dynamic offsets may be NULL/0
+void hg_cmd_push_constants(hgAppData* ptState, hgPipeline* tPipeline, VkShaderStageFlags tStages, uint32_t uOffset, uint32_t uSize, const void* pData);
+// write push constants on the current frame command buffer (range must be declared in hgPipelineConfig)
+void hg_cmd_invalidate_bound_state(hgAppData* ptState);
+// forget everything the tracker knows about the current frame command buffer, the next binds are all issued
+void hg_get_bind_stats(hgAppData* ptState, hgBindStats* statsOut);
+// binds issued/skipped and draws of the last frame passed to hg_end_frame
+void hg_cmd_bind_geometry_pool(hgAppData* ptState, hgGeometryPool* tPool);
+// bind the pool's vertex (binding 0) and index buffers, filtered like the binds above
 
 
 // Draw commands (must be called between begin/end render pass)
@@ -284,20 +940,45 @@ void hg_cmd_draw(hgAppData* ptState, uint32_t uVertexCount, uint32_t uFirstVerte
 // draw non-indexed geometry using currently bound vertex buffer
 void hg_cmd_draw_indexed(hgAppData* ptState, uint32_t uIndexCount, uint32_t uFirstIndex, int32_t iVertexOffset);
 // draw indexed geometry using currently bound vertex and index buffers
+void hg_cmd_draw_instanced(hgAppData* ptState, uint32_t uVertexCount, uint32_t uInstanceCount, uint32_t uFirstVertex, uint32_t uFirstInstance);
+void hg_cmd_draw_indexed_instanced(hgAppData* ptState, uint32_t uIndexCount, uint32_t uInstanceCount, uint32_t uFirstIndex, int32_t iVertexOffset, uint32_t uFirstInstance);
+// same as above for uInstanceCount instances, per instance bindings advance once per instance starting at uFirstInstance
+void hg_cmd_draw_indexed_indirect(hgAppData* ptState, VkBuffer tBuffer, VkDeviceSize tOffset, uint32_t uDrawCount);
+// uDrawCount tightly packed VkDrawIndexedIndirectCommand at tOffset (hgIndirectBuffer or hg_alloc_indirect_commands memory)
+void hg_cmd_draw_indexed_indirect_count(hgAppData* ptState, VkBuffer tBuffer, VkDeviceSize tOffset, VkBuffer tCountBuffer, VkDeviceSize tCountOffset, uint32_t uMaxDrawCount);
+// draw count read by the gpu from tCountBuffer, without VK_KHR_draw_indirect_count all uMaxDrawCount commands are drawn ->
+// hgIndirectBuffers start zeroed and hg_cmd_reset_indirect_buffer re-zeroes them, so slots past the count draw nothing on both paths
+void hg_cmd_draw_pool_mesh(hgAppData* ptState, hgGeometryPool* tPool, hgMeshHandle tMesh, uint32_t uInstanceCount, uint32_t uFirstInstance);
+// binds the pool (skipped when it is already bound) and draws one of its meshes
+
+// render queue -> queue draws in any order, submitting radix sorts them by key and records them through the bound state
+// tracker, so binds drop to one per pipeline/material group. queue between hg_begin_frame and the submit, packets are copied
+hgRenderQueue hg_create_render_queue(uint32_t initialCapacity);
+hgSortKey     hg_make_sort_key(uint8_t layer, uint16_t pipelineId, uint16_t materialId, float depth, bool transparent);
+// depth 0..1 (view distance / far plane). bits 63..56 layer, bit 55 translucency -> inside a layer every opaque draw goes
+// before every transparent one. opaque: pipeline 54..39 | material 38..23 | depth 22..0 (near to far inside each state
+// group, for early z), transparent: inverted depth 54..32 | pipeline 31..16 | material 15..0 (far to near across the layer)
+void          hg_set_packet_mesh(hgDrawPacket* packet, hgVertexBuffer* vertexBuffer, hgIndexBuffer* indexBuffer); // whole index buffer
+void          hg_set_packet_pool_mesh(hgDrawPacket* packet, hgGeometryPool* pool, hgMeshHandle mesh);
+void          hg_queue_draw(hgRenderQueue* queue, hgSortKey key, const hgDrawPacket* packet);
+void          hg_cmd_submit_render_queue(hgAppData* ptState, hgRenderQueue* queue); // sort, record (inside a render pass) and empty the queue
 
 // convenience wrappers -> not sure if this is worth it or not yet
 void hg_draw_mesh(hgAppData* ptState, hgVertexBuffer* tVertexBuffer, hgIndexBuffer* tIndexBuffer, uint32_t uIndexCount);
-// convenience function - binds vertex/index buffers and draws in one call
+// convenience function - binds vertex/index buffers and draws in one call (uIndexCount 0 -> the whole index buffer)
 
 // =============================================================================
 // CLEANUP
 // =============================================================================
 
 void hg_core_cleanup(hgAppData* ptState); // should be called after all other cleanup
-void hg_cleanup_swapchain_resources(hgAppData* ptState); // for swapchain rebuilding on window resize
+void hg_cleanup_swapchain_resources(hgAppData* ptState); // destroys swapchain objects right away (device must be idle)
 void hg_destroy_texture(hgAppData* ptState, hgTexture* texture);
 void hg_destroy_vertex_buffer(hgAppData* ptState, hgVertexBuffer* tVertexBuffer);
 void hg_destroy_index_buffer(hgAppData* ptState, hgIndexBuffer* tIndexBuffer);
+void hg_destroy_indirect_buffer(hgAppData* ptState, hgIndirectBuffer* tIndirectBuffer);
+void hg_destroy_geometry_pool(hgAppData* ptState, hgGeometryPool* tPool);
+void hg_destroy_render_queue(hgRenderQueue* tQueue);
 void hg_destroy_pipeline(hgAppData* ptState, hgPipeline* tPipeline);
 
 #endif // VKHOMEGROWN_H
\ No newline at end of file